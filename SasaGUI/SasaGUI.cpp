@@ -1,4 +1,13 @@
 ﻿#include "SasaGUI.hpp"
+#include <execution>
+#include <bit>
+#include <cstring>
+#include <list>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#	include <emmintrin.h>
+#	define SASAGUI_USE_SSE2
+#endif
 
 namespace SasaGUI
 {
@@ -46,12 +55,15 @@ namespace SasaGUI
 			constexpr static ColorF TitlebarTopColor{ 0.86 };
 			constexpr static ColorF TitlebarBottomColor{ 0.8 };
 			constexpr static ColorF TitlebarLabelColor{ 0.0 };
+			constexpr static ColorF CollapseButtonColor{ 0.3 };
 
 			constexpr static Size DefaultWindowSize{ 100, 100 };
 			constexpr static int32 Roundness = 6;
 			constexpr static int32 FrameThickness = 1;
 			constexpr static int32 ResizeGripSize = 5;
+			constexpr static double CollapseButtonScale = 0.35; // タイトルバーの高さに対する三角形の大きさ
 			constexpr static double ScrollSpeed = 2.0;
+			constexpr static double MaxLocalCoord = 1 << 28; // コントロールに渡す座標の上限
 		};
 
 		struct CheckBox
@@ -100,6 +112,217 @@ namespace SasaGUI
 			constexpr static int32 TabMinWidth = 50;
 		};
 
+		struct Child
+		{
+			constexpr static ColorF FrameColor{ 0.75 };
+
+			constexpr static int32 FrameThickness = 1;
+		};
+
+		struct Table
+		{
+			constexpr static ColorF HeaderColor{ 0.86 };
+			constexpr static ColorF HoveredHeaderColor{ 0.9 };
+			constexpr static ColorF RowColor = Palette::White;
+			constexpr static ColorF AlternateRowColor{ 0.96 };
+			constexpr static ColorF BorderColor{ 0.75 };
+			constexpr static ColorF SortArrowColor{ 0.3 };
+			constexpr static ColorF SortingArrowColor{ 0.3, 0.4 }; // 並べ替えの完了待ち
+
+			constexpr static ColorF LabelColor = Common::LabelColor;
+
+			constexpr static int32 CellPadding = 3;
+			constexpr static int32 ResizeHandleWidth = 4; // 列の境界からの距離
+			constexpr static double MinColumnWidth = 20;
+			constexpr static double SortArrowScale = 0.3; // 文字の高さに対する三角形の大きさ
+		};
+
+		struct LogView
+		{
+			constexpr static int32 TextPadding = 3;
+		};
+
+		struct CollapsingHeader
+		{
+			constexpr static ColorF BackgroundColor{ 0.86 };
+			constexpr static ColorF HoveredBackgroundColor{ 0.9 };
+			constexpr static ColorF ArrowColor{ 0.3 };
+
+			constexpr static ColorF LabelColor = Common::LabelColor;
+
+			constexpr static int32 Roundness = 3;
+			constexpr static int32 Padding = 2;
+			constexpr static double ArrowScale = 0.35; // 文字の高さに対する三角形の大きさ
+		};
+
+		struct Plot
+		{
+			constexpr static ColorF BackgroundColor = Palette::White;
+			constexpr static ColorF FrameColor{ 0.75 };
+			constexpr static ColorF LineColor = Color{ 3, 121, 255 };
+			constexpr static ColorF SelectionColor{ 0.3, 0.5, 1.0, 0.25 };
+
+			constexpr static int32 Padding = 4;
+			constexpr static double LineThickness = 1.0;
+			constexpr static double MinSelectionWidth = 4; // これより狭い範囲選択はズームしない
+		};
+
+		struct Scatter
+		{
+			constexpr static ColorF BackgroundColor = Palette::White;
+			constexpr static ColorF FrameColor{ 0.75 };
+			constexpr static ColorF PointColor = Color{ 3, 121, 255 };
+			constexpr static ColorF HoveredPointColor = Palette::Orange;
+			constexpr static ColorF SelectionColor{ 0.3, 0.5, 1.0, 0.25 };
+
+			constexpr static int32 Padding = 4;
+			constexpr static int32 PointSize = 3; // 同じ大きさの升目ごとに1つだけ描く
+			constexpr static double HoverRadius = 6;
+			constexpr static double MinSelectionSize = 4;
+			constexpr static double ClickThreshold = 2; // これより動かずに離したら右クリックとみなす
+		};
+
+		struct StripChart
+		{
+			constexpr static ColorF BackgroundColor = Palette::White;
+			constexpr static ColorF FrameColor{ 0.75 };
+
+			constexpr static int32 Padding = 4;
+			constexpr static double LineThickness = 1.0;
+		};
+
+		struct Histogram
+		{
+			constexpr static ColorF BackgroundColor = Palette::White;
+			constexpr static ColorF FrameColor{ 0.75 };
+			constexpr static ColorF BarColor = Color{ 3, 121, 255 };
+
+			constexpr static int32 Padding = 4;
+			constexpr static int32 MinBarWidth = 3; // 区間の数を自動で決めるときの棒の最小の幅
+			constexpr static size_t ParallelThreshold = 1'000'000; // これ以上のサンプルは複数のスレッドで数える
+		};
+
+		struct Timeline
+		{
+			constexpr static ColorF BackgroundColor = Palette::White;
+			constexpr static ColorF AlternateColor{ 0.96 };
+			constexpr static ColorF LabelBackgroundColor{ 0.9 };
+			constexpr static ColorF BorderColor{ 0.75 };
+			constexpr static ColorF HoveredFrameColor = Palette::Black;
+			constexpr static ColorF SelectionColor{ 0.3, 0.5, 1.0, 0.25 };
+
+			constexpr static ColorF LabelColor = Common::LabelColor;
+
+			constexpr static int32 LabelWidth = 120;
+			constexpr static int32 TrackPadding = 3;
+			constexpr static double MinSpanWidth = 1.0;
+			constexpr static double MinViewDuration = 1e-9; // 表示する時刻の範囲の最小の長さ (1ピクセルの時間が0にならないように)
+			constexpr static double MinSelectionWidth = 4;
+			constexpr static double ClickThreshold = 2; // これより動かずに離したら右クリックとみなす
+		};
+
+		struct Tree
+		{
+			constexpr static ColorF HoveredColor{ 0.92 };
+			constexpr static ColorF SelectedColor{ 0.8, 0.88, 1.0 };
+			constexpr static ColorF ArrowColor{ 0.3 };
+
+			constexpr static ColorF LabelColor = Common::LabelColor;
+
+			constexpr static int32 RowPadding = 2;
+			constexpr static int32 Indent = 16;
+			constexpr static double ArrowScale = 0.3; // 文字の高さに対する三角形の大きさ
+		};
+
+		struct Dropdown
+		{
+			constexpr static ColorF BackgroundColor{ 0.86 };
+			constexpr static ColorF HoveredBackgroundColor{ 0.9 };
+			constexpr static ColorF ArrowColor{ 0.3 };
+			constexpr static ColorF HoveredItemColor{ 0.92 };
+			constexpr static ColorF SelectedItemColor{ 0.8, 0.88, 1.0 };
+
+			constexpr static ColorF LabelColor = Common::LabelColor;
+
+			constexpr static int32 Roundness = 3;
+			constexpr static int32 Padding = 2;
+			constexpr static int32 ItemPadding = 2;
+			constexpr static int32 ListHeight = 240;
+			constexpr static double ArrowScale = 0.3; // 文字の高さに対する三角形の大きさ
+			constexpr static size_t FilterChunkSize = 4096; // 絞り込みの結果を公開する間隔
+			constexpr static size_t FilterCacheSize = 16; // 結果を残しておく検索語の数
+		};
+
+		struct TextEditor
+		{
+			constexpr static ColorF BackgroundColor{ 1.0 };
+			constexpr static ColorF TextColor = Common::LabelColor;
+			constexpr static ColorF SelectionColor{ 0.8, 0.88, 1.0 };
+			constexpr static ColorF InactiveSelectionColor{ 0.88 };
+			constexpr static ColorF CaretColor{ 0.0 };
+
+			constexpr static int32 TextPadding = 3;
+			constexpr static double CaretWidth = 1.5;
+			constexpr static double CaretBlinkInterval = 0.5;
+			constexpr static double NewlineWidthScale = 0.3; // 選択範囲に含まれる改行の幅 (文字の高さに対する比)
+			constexpr static Duration KeyRepeatDelay = 0.4s;
+			constexpr static Duration KeyRepeatInterval = 0.03s;
+		};
+
+		struct TiledImage
+		{
+			constexpr static ColorF BackgroundColor{ 0.2 };
+			constexpr static ColorF FrameColor{ 0.75 };
+			constexpr static ColorF SelectionColor{ 0.3, 0.5, 1.0, 0.25 };
+
+			constexpr static int32 TileSize = 256;
+			constexpr static size_t GpuBudget = size_t{ 256 } << 20; // 残しておくテクスチャの合計 (バイト)
+			constexpr static size_t CpuBudget = size_t{ 512 } << 20; // 残しておく読み込み済みの画像の合計 (バイト)
+			constexpr static int32 UploadsPerFrame = 8; // 1フレームに作るテクスチャの数
+			constexpr static double MaxScale = 16; // 原寸の1ピクセルを何ピクセルまで拡大するか
+			constexpr static double MinSelectionSize = 4;
+			constexpr static double ClickThreshold = 2; // これより動かずに離したら右クリックとみなす
+		};
+
+		struct ThumbnailGrid
+		{
+			constexpr static ColorF HoveredColor{ 0.92 };
+			constexpr static ColorF SelectedColor{ 0.8, 0.88, 1.0 };
+			constexpr static ColorF PlaceholderColor{ 0.88 };
+			constexpr static ColorF FailedColor{ 0.75, 0.35, 0.35 };
+			constexpr static ColorF LabelColor = Common::LabelColor;
+
+			constexpr static int32 Padding = 4;
+			constexpr static int32 PrefetchRows = 2; // 見えている範囲の前後に先に読み込む行数
+			constexpr static int32 PageSize = 2048; // サムネイルを詰めるテクスチャの1辺
+			constexpr static size_t PageCount = 4; // サムネイルを詰めるテクスチャの数
+			constexpr static int32 UploadsPerFrame = 16; // 1フレームにテクスチャに書き込む数
+		};
+
+		struct NodeGraph
+		{
+			constexpr static ColorF BackgroundColor{ 0.93 };
+			constexpr static ColorF GridColor{ 0.86 };
+			constexpr static ColorF NodeColor{ 1.0 };
+			constexpr static ColorF TitleColor{ 0.84, 0.88, 0.95 };
+			constexpr static ColorF BorderColor{ 0.55 };
+			constexpr static ColorF SelectedBorderColor{ 0.25, 0.5, 1.0 };
+			constexpr static ColorF LabelColor = Common::LabelColor;
+			constexpr static ColorF PortColor{ 0.45 };
+			constexpr static ColorF HoveredPortColor{ 0.25, 0.5, 1.0 };
+			constexpr static ColorF LinkColor{ 0.4 };
+			constexpr static ColorF SelectedLinkColor{ 0.25, 0.5, 1.0 };
+
+			constexpr static int32 GridSize = 32;
+			constexpr static int32 Padding = 6;
+			constexpr static double Roundness = 4;
+			constexpr static double PortRadius = 5;
+			constexpr static double LinkThickness = 2;
+			constexpr static double LinkHitTolerance = 4; // クリックでリンクを選択できる曲線からの距離
+			constexpr static double MinTangent = 40; // リンクの曲線が端から水平に伸びる最小の長さ
+			constexpr static int32 LinkSegments = 24; // リンクの曲線の分割数
+		};
+
 		struct ProgressBar
 		{
 			constexpr static ColorF BackgroundColor{ 0.9 };
@@ -125,6 +348,9 @@ namespace SasaGUI
 	}
 
 	class Layer;
+
+	class Table;
+	class NodeGraphCanvas;
 	class InputContext;
 
 	enum class WindowLayer : int32
@@ -193,6 +419,9 @@ namespace SasaGUI
 		// タイトルバー領域
 		Rect titlebarRect;
 
+		// 折りたたみボタンの領域
+		Rect collapseButtonRect;
+
 		// ウィンドウ内の領域
 		Rect clientRect;
 
@@ -397,6 +626,19 @@ namespace SasaGUI
 			m_scrollVelocity = 0.0;
 		}
 
+		// スクロールの目標位置が末尾にあるか
+		bool atEnd() const
+		{
+			return m_scrollTarget >= m_maximum - m_viewportSize - 1.0;
+		}
+
+		// スクロール中の目標位置ごと平行移動する
+		void shift(double delta)
+		{
+			m_value = Max(Min(m_value + delta, m_maximum - m_viewportSize), m_minimum);
+			m_scrollTarget = Max(Min(m_scrollTarget + delta, m_maximum - m_viewportSize), m_minimum);
+		}
+
 		void update(Optional<Vec2> cursorXYPos = Cursor::PosF(), double deltaTime = Scene::DeltaTime())
 		{
 			Optional<double> cursorPos = cursorXYPos.map([this](Vec2 v) { return getMainAxisValue(v); });
@@ -578,1198 +820,10236 @@ namespace SasaGUI
 		}
 	};
 
-	namespace detail
+	enum class LayoutType
 	{
-		using ControlGenerator = std::function<IControl* ()>;
-
-		template<class ControlType>
-		static ControlGenerator DefaultGenerator()
-		{
-			return []() -> IControl* { return new ControlType(); };
-		}
-
-		class WindowImpl : Uncopyable
-		{
-		public:
-
-			using Config = Config::Window;
+		Row, Column, Grid
+	};
 
-			using ControlContainer = Array<std::shared_ptr<IControl>>;
+	// レイアウトコンテナの解決結果
+	// 子の大きさと利用可能な幅が変わらない限り再利用する
+	struct LayoutCache
+	{
+		Optional<double> availableWidth;
 
-			WindowImpl(InputContext& input, const StringView id, const StringView name, const Font& font);
+		Array<SizeF> childSizes;
 
-		public:
+		Array<RectF> childRects;
 
-			Window window;
+		SizeF size{ 0, 0 };
 
-			const String& id() const { return m_id; }
+		bool used = false;
 
-			size_t randomId() const { return m_randomId; }
+		// このフレームで解決し直したウィンドウ (0のときは未解決)
+		size_t solvedBy = 0;
+	};
 
-			const Rect& rect() const { return window.rect; }
+	class LayoutContainer
+	{
+	public:
 
-			int32 titlebarHeight() const
+		LayoutContainer(LayoutType type, const Array<LayoutTrack>& tracks, Alignment crossAlign, double space, Vec2 origin, Optional<double> availableWidth, LayoutCache& cache)
+			: m_type(type)
+			, m_tracks(tracks)
+			, m_crossAlign(crossAlign)
+			, m_space(space)
+			, m_origin(origin)
+			, m_availableWidth(availableWidth)
+			, m_cache(&cache)
+			, m_dirty(cache.availableWidth != availableWidth)
+		{
+			if (m_type == LayoutType::Grid && m_tracks.empty())
 			{
-				if (window.hasTitlebar())
-				{
-					return window.font.height();
-				}
-				else
-				{
-					return 0;
-				}
+				m_tracks.emplace_back();
 			}
+		}
 
-			Size minSize() const
-			{
-				if (window.flags & WindowFlag::NoBackground)
-				{
-					return { 0, 0 };
-				}
-				else if (
-					window.flags & WindowFlag::NoScrollbar ||
-					window.flags & WindowFlag::AutoResize)
-				{
-					return {
-						Config::Roundness * 2,
-						Max(Config::Roundness, titlebarHeight()) + Config::Roundness
-					};
-				}
-				else
-				{
-					constexpr static int32 ContentMinSize = ScrollBar::MinLength + ScrollBar::Thickness;
-					return {
-						Max(Config::Roundness * 2, ContentMinSize),
-						Max(Config::Roundness * 2, titlebarHeight() + ContentMinSize)
-					};
-				}
-			}
+	public:
 
-			Optional<Vec2> getLocalCursorPos() const;
+		LayoutType type() const { return m_type; }
 
-			void frameBegin(InputContext& input);
+		Vec2 origin() const { return m_origin; }
 
-			void frameEnd();
+		// finish()で解決し直すことになるか
+		bool needsSolve() const
+		{
+			return m_dirty || m_childSizes.size() != m_cache->childSizes.size();
+		}
 
-			template<std::derived_from<IControl> ControlType>
-			inline IControl& nextControl(const std::shared_ptr<ControlType>& control)
-			{
-				return reinterpret_cast<ControlType&>(nextControlImpl(control));
-			}
+		// 解決結果を書き込むキャッシュを差し替える
+		void rebind(LayoutCache& cache)
+		{
+			m_cache = &cache;
+			m_dirty = true;
+		}
 
-			template<std::derived_from<IControl> ControlType>
-			inline ControlType& nextStatelessControl(ControlGenerator generator = DefaultGenerator<ControlType>())
+		size_t nextIndex() const { return m_childSizes.size(); }
+
+		// 子の矩形をコンテンツ座標で返す
+		RectF place(SizeF size)
+		{
+			size_t idx = m_childSizes.size();
+			m_childSizes.push_back(size);
+
+			RectF rect;
+			if (not m_dirty &&
+				idx < m_cache->childSizes.size() &&
+				m_cache->childSizes[idx] == size)
 			{
-				return reinterpret_cast<ControlType&>(nextStatelessControlImpl(
-					typeid(ControlType),
-					generator
-				));
+				rect = m_cache->childRects[idx];
 			}
-
-			template<std::derived_from<IControl> ControlType>
-			inline ControlType& nextStatefulControl(size_t id, ControlGenerator generator = DefaultGenerator<ControlType>())
+			else
 			{
-				s3d::detail::HashCombine(id, typeid(ControlType).hash_code());
-				return reinterpret_cast<ControlType&>(nextStatefulControlImpl(
-					id,
-					generator
-				));
+				m_dirty = true;
+				rect = placeProvisional(idx, size);
 			}
 
-			void updateControl(IControl& control);
-
-			Rect pushRect(Size size);
-
-			void setPos(Vec2 pos, Vec2 offset);
-
-			void setSize(Size size);
+			m_extent.x = Max(m_extent.x, rect.rightX());
+			m_extent.y = Max(m_extent.y, rect.bottomY());
+			m_prevRect = rect;
 
-		private:
+			return rect.movedBy(m_origin);
+		}
 
-			struct NextPosition
+		// 入れ子のコンテナの大きさが確定したときに呼ぶ
+		void resize(size_t idx, SizeF size)
+		{
+			if (m_childSizes[idx] != size)
 			{
-				Vec2 pos;
+				m_childSizes[idx] = size;
+				m_dirty = true;
+			}
+		}
 
-				Vec2 offset;
-			};
+		// 次の子に割り当てられる幅 (前回の解決結果から)
+		Optional<double> nextCellWidth() const
+		{
+			size_t idx = m_childSizes.size();
+			if (m_dirty ||
+				idx >= m_cache->childRects.size())
+			{
+				return none;
+			}
+			return m_cache->childRects[idx].w;
+		}
 
-			struct NextSize
+		// コンテナの大きさを返す
+		// 子の大きさが前回から変わっていれば解決し直してキャッシュを更新する
+		SizeF finish(bool& resolved)
+		{
+			resolved = needsSolve();
+			if (resolved)
 			{
-				Size size;
+				solve();
+			}
+			return {
+				Max(m_extent.x, m_cache->size.x),
+				Max(m_extent.y, m_cache->size.y)
 			};
+		}
 
-			String m_id;
-
-			size_t m_randomId;
+	private:
 
-			InputContext* m_input;
+		LayoutType m_type;
 
-			WindowState m_state = WindowState::Default;
+		Array<LayoutTrack> m_tracks;
 
-			ResizeFlag m_resizeFlag = ResizeFlag::None;
+		Alignment m_crossAlign;
 
-			bool m_isContentHovered = false;
+		double m_space;
 
-			bool m_firstFrame = true;
+		Vec2 m_origin;
 
-			Optional<WindowLayout> m_layout;
+		Optional<double> m_availableWidth;
 
-			std::array<ScrollBar, 2> m_scrollBars;
+		LayoutCache* m_cache;
 
-			Rect m_contentLocalRect{ 0, 0, 0, 0 };
+		bool m_dirty;
 
-			ControlContainer m_controls;
+		Array<SizeF> m_childSizes;
 
-			std::map<size_t, std::shared_ptr<IControl>> m_savedControls;
+		SizeF m_extent{ 0, 0 };
 
-			size_t m_nextControlIdx = 0;
+		RectF m_prevRect{ 0, 0, 0, 0 };
 
-			Optional<NextSize> m_nextSize;
+		double m_rowTop = 0.0;
 
-			Optional<NextPosition> m_nextPos;
+		double m_rowHeight = 0.0;
 
-			void draw() const;
+		LayoutTrack track(size_t idx) const
+		{
+			if (m_type == LayoutType::Grid)
+			{
+				return m_tracks[idx % m_tracks.size()];
+			}
+			return idx < m_tracks.size() ? m_tracks[idx] : LayoutTrack{ };
+		}
 
-			void updateWindowState();
+		// キャッシュが使えないときの仮の配置 (次のフレームで解決後の位置に移動する)
+		RectF placeProvisional(size_t idx, SizeF size)
+		{
+			switch (m_type)
+			{
+			case LayoutType::Row:
+				return { idx == 0 ? 0.0 : m_prevRect.rightX() + m_space, 0.0, size };
+			case LayoutType::Column:
+				return { 0.0, idx == 0 ? 0.0 : m_prevRect.bottomY() + m_space, size };
+			case LayoutType::Grid:
+			default:
+				if (idx != 0 && idx % m_tracks.size() == 0)
+				{
+					m_rowTop += m_rowHeight + m_space;
+					m_rowHeight = 0.0;
+				}
+				m_rowHeight = Max(m_rowHeight, size.y);
+				return { idx % m_tracks.size() == 0 ? 0.0 : m_prevRect.rightX() + m_space, m_rowTop, size };
+			}
+		}
 
-			void handleMovingState();
+		static void Distribute(Array<double>& sizes, const Array<LayoutTrack>& tracks, double extra)
+		{
+			Array<size_t> active;
+			for (size_t i = 0; i < sizes.size(); i++)
+			{
+				if (tracks[i].weight > 0.0 && sizes[i] < tracks[i].maxSize)
+				{
+					active.push_back(i);
+				}
+			}
 
-			void handleResizingState();
+			// 最大値に達する要素を確定させてから、残りを比率で分配し直す
+			while (extra > 0.0 && not active.empty())
+			{
+				double totalWeight = 0.0;
+				for (size_t i : active)
+				{
+					totalWeight += tracks[i].weight;
+				}
 
-			void updateLayout();
+				double used = 0.0;
+				Array<size_t> next;
+				for (size_t i : active)
+				{
+					if (sizes[i] + extra * tracks[i].weight / totalWeight >= tracks[i].maxSize)
+					{
+						used += tracks[i].maxSize - sizes[i];
+						sizes[i] = tracks[i].maxSize;
+					}
+					else
+					{
+						next.push_back(i);
+					}
+				}
 
-			void updateSize();
+				if (next.size() == active.size())
+				{
+					for (size_t i : active)
+					{
+						sizes[i] += extra * tracks[i].weight / totalWeight;
+					}
+					break;
+				}
 
-			void updatePosition();
+				extra -= used;
+				active = std::move(next);
+			}
+		}
 
-			IControl& nextControlImpl(const std::shared_ptr<IControl>& control);
+		static std::pair<double, double> Align(double cellPos, double cellSize, double size, Alignment align)
+		{
+			// 最大値で縮めたセルからはみ出さないよう、子もセルに収める
+			size = Min(size, cellSize);
 
-			IControl& nextStatelessControlImpl(const std::type_info& type, ControlGenerator& generator);
+			switch (align)
+			{
+			case Alignment::Center:
+				return { cellPos + (cellSize - size) * 0.5, size };
+			case Alignment::End:
+				return { cellPos + cellSize - size, size };
+			case Alignment::Stretch:
+				return { cellPos, cellSize };
+			case Alignment::Start:
+			default:
+				return { cellPos, size };
+			}
+		}
 
-			IControl& nextStatefulControlImpl(size_t id, ControlGenerator& generator);
-		};
-	}
+		void solve()
+		{
+			const size_t count = m_childSizes.size();
+			Array<RectF> rects(count);
+			SizeF size{ 0, 0 };
 
-	class Layer
-	{
-	public:
-
-		using container_type = HashTable<String, std::unique_ptr<WindowImpl>>;
-
-		Layer(WindowLayer type)
-			: type(type)
-		{ }
-
-	public:
-
-		const WindowLayer type;
-
-		const container_type& container() const { return m_container; }
+			switch (m_type)
+			{
+			case LayoutType::Row:
+			{
+				Array<LayoutTrack> tracks(count);
+				Array<double> widths(count);
+				double height = 0.0;
+				double total = count > 0 ? m_space * (count - 1) : 0.0;
+				for (size_t i = 0; i < count; i++)
+				{
+					tracks[i] = track(i);
+					widths[i] = Clamp<double>(m_childSizes[i].x, tracks[i].minSize, tracks[i].maxSize);
+					height = Max(height, m_childSizes[i].y);
+					total += widths[i];
+				}
+				if (m_availableWidth)
+				{
+					Distribute(widths, tracks, *m_availableWidth - total);
+				}
 
-		void frameBegin(InputContext& input);
+				double x = 0.0;
+				for (size_t i = 0; i < count; i++)
+				{
+					auto [rx, rw] = Align(x, widths[i], m_childSizes[i].x, tracks[i].align);
+					auto [ry, rh] = Align(0.0, height, m_childSizes[i].y, m_crossAlign);
+					rects[i] = { rx, ry, rw, rh };
+					x += widths[i] + m_space;
+				}
+				size = { count > 0 ? x - m_space : 0.0, height };
+				break;
+			}
+			case LayoutType::Column:
+			{
+				double width = 0.0;
+				for (auto& childSize : m_childSizes)
+				{
+					width = Max(width, childSize.x);
+				}
+				if (m_availableWidth && m_crossAlign == Alignment::Stretch)
+				{
+					width = Max(width, *m_availableWidth);
+				}
 
-		void frameEnd();
+				double y = 0.0;
+				for (size_t i = 0; i < count; i++)
+				{
+					LayoutTrack t = track(i);
+					double height = Clamp<double>(m_childSizes[i].y, t.minSize, t.maxSize);
+					auto [ry, rh] = Align(y, height, m_childSizes[i].y, t.align);
+					auto [rx, rw] = Align(0.0, width, m_childSizes[i].x, m_crossAlign);
+					rects[i] = { rx, ry, rw, rh };
+					y += height + m_space;
+				}
+				size = { width, count > 0 ? y - m_space : 0.0 };
+				break;
+			}
+			case LayoutType::Grid:
+			{
+				const size_t columns = m_tracks.size();
+				const size_t rows = (count + columns - 1) / columns;
+				Array<double> widths(columns, 0.0);
+				Array<double> heights(rows, 0.0);
+				for (size_t i = 0; i < count; i++)
+				{
+					widths[i % columns] = Max(widths[i % columns], m_childSizes[i].x);
+					heights[i / columns] = Max(heights[i / columns], m_childSizes[i].y);
+				}
 
-		WindowImpl& defineWindow(const StringView id, const StringView name, const Font& font);
+				double total = m_space * (columns - 1);
+				for (size_t c = 0; c < columns; c++)
+				{
+					widths[c] = Clamp<double>(widths[c], m_tracks[c].minSize, m_tracks[c].maxSize);
+					total += widths[c];
+				}
+				if (m_availableWidth)
+				{
+					Distribute(widths, m_tracks, *m_availableWidth - total);
+				}
 
-	private:
+				Array<double> xs(columns, 0.0);
+				for (size_t c = 1; c < columns; c++)
+				{
+					xs[c] = xs[c - 1] + widths[c - 1] + m_space;
+				}
 
-		container_type m_container;
+				double y = 0.0;
+				for (size_t r = 0; r < rows; r++)
+				{
+					for (size_t c = 0; c < columns && r * columns + c < count; c++)
+					{
+						size_t i = r * columns + c;
+						auto [rx, rw] = Align(xs[c], widths[c], m_childSizes[i].x, m_tracks[c].align);
+						auto [ry, rh] = Align(y, heights[r], m_childSizes[i].y, m_crossAlign);
+						rects[i] = { rx, ry, rw, rh };
+					}
+					y += heights[r] + m_space;
+				}
+				size = {
+					count > 0 ? xs.back() + widths.back() : 0.0,
+					rows > 0 ? y - m_space : 0.0
+				};
+				break;
+			}
+			}
 
-		std::list<String> m_windowOrder;
+			m_cache->availableWidth = m_availableWidth;
+			m_cache->childSizes = m_childSizes;
+			m_cache->childRects = std::move(rects);
+			m_cache->size = size;
+		}
+	};
 
-		InputContext* m_input;
+	// 整形済みの文字列
+	struct Caption
+	{
+		// ラベルからは参照するだけで複製しない
+		std::shared_ptr<const DrawableText> text;
 
-		container_type::iterator createWindow(const StringView id, const StringView name, const Font& font);
+		Size size{ 0, 0 };
 
-		void deleteUnusedWindow();
+		bool used = false;
 	};
 
-	namespace detail
+	// フレームの終わりに使われなかった要素を削除し、残りの使用済みフラグを戻す
+	template<class Container>
+	static void EraseUnused(Container& container)
 	{
-		class GUIImpl
+		for (auto itr = container.begin(); itr != container.end();)
 		{
-		public:
-
-			Font font = SimpleGUI::GetFont();
-
-			std::array<Layer, 3>& layers() { return m_layers; }
-
-			void frameBegin();
-
-			void frameEnd();
-
-			Layer& getLayer(WindowLayer layer);
-
-			WindowImpl& defineWindow(WindowLayer layer, const StringView id, const StringView name);
-
-		private:
-
-			std::array<Layer, 3> m_layers{
-				Layer{ WindowLayer::Background },
-				Layer{ WindowLayer::Normal },
-				Layer{ WindowLayer::Foreground }
-			};
-
-			InputContext m_input;
-		};
+			if (itr->second.used)
+			{
+				itr->second.used = false;
+				itr++;
+			}
+			else
+			{
+				itr = container.erase(itr);
+			}
+		}
 	}
 
-	static StringView ToString(WindowLayer layer)
+	// IDを付けたコントロールのコンテンツ座標での位置
+	// 上端の順に並べ、IDからの検索はハッシュ表で行う
+	class PositionIndex
 	{
-		return std::array{ U"Background", U"Normal", U"Foreground" } [static_cast<int32>(layer)] ;
-	}
+	public:
 
-	static CursorStyle ToCursorStyle(ResizeFlag flag)
-	{
-		switch (flag)
+		struct Entry
 		{
-		case ResizeFlag::Top:
-		case ResizeFlag::Bottom:
-			return CursorStyle::ResizeUpDown;
-		case ResizeFlag::Top | ResizeFlag::Right:
-		case ResizeFlag::Bottom | ResizeFlag::Left:
-			return CursorStyle::ResizeNESW;
-		case ResizeFlag::Right:
-		case ResizeFlag::Left:
-			return CursorStyle::ResizeLeftRight;
-		case ResizeFlag::Right | ResizeFlag::Bottom:
-		case ResizeFlag::Left | ResizeFlag::Top:
-			return CursorStyle::ResizeNWSE;
-		default:
-			return CursorStyle::Default;
-		}
-	}
+			size_t id;
 
-	// InputContext
+			RectF rect;
+		};
 
-	bool InputContext::hover(const WindowImpl& window)
-	{
-		if (m_hoveredItemId == 0)
+		void clear()
 		{
-			m_hoveredItemId = window.randomId();
-			return true;
+			m_entries.clear();
+			m_lookup.clear();
 		}
 
-		if (m_hoveredItemId == window.randomId())
+		void add(size_t id, const RectF& rect)
 		{
-			return true;
+			m_entries.push_back({ id, rect });
 		}
 
-		return false;
-	}
-
-	bool InputContext::capture(const WindowImpl& window, bool capture)
-	{
-		if (m_hoveredItemId == 0 ||
-			m_hoveredItemId == window.randomId())
+		// 追加し終わったら呼ぶ
+		void finish()
 		{
-			m_captured = capture;
-			if (capture)
+			// ほとんどの場合は上から順に追加されるので並べ替えは不要
+			auto byTop = [](const Entry& a, const Entry& b) { return a.rect.y < b.rect.y; };
+			if (not std::is_sorted(m_entries.begin(), m_entries.end(), byTop))
 			{
-				m_hoveredItemId = window.randomId();
+				std::stable_sort(m_entries.begin(), m_entries.end(), byTop);
 			}
-			else
+
+			m_lookup.clear();
+			m_lookup.reserve(m_entries.size());
+			for (size_t i = 0; i < m_entries.size(); i++)
 			{
-				m_hoveredItemId = 0;
+				m_lookup[m_entries[i].id] = i;
 			}
-			return true;
 		}
 
-		return false;
-	}
-
-	Optional<Vec2> InputContext::getCursorPos() const
-	{
-		if (m_hoveredItemId == 0)
+		Optional<RectF> find(size_t id) const
 		{
-			return m_cursorPos;
+			auto itr = m_lookup.find(id);
+			if (itr == m_lookup.end())
+			{
+				return none;
+			}
+			return m_entries[itr->second].rect;
 		}
 
-		return none;
-	}
-
-	Optional<Vec2> InputContext::getCursorPos(const WindowImpl& window) const
-	{
-		if (m_hoveredItemId == 0 ||
-			m_hoveredItemId == window.randomId())
+		// 下端がtopより下にあるコントロールのうち一番上のもの
+		const Entry* firstVisible(double top) const
 		{
-			return m_cursorPos;
-		}
-
-		return none;
-	}
+			auto itr = std::lower_bound(m_entries.begin(), m_entries.end(), top,
+				[](const Entry& e, double y) { return e.rect.y < y; });
 
-	void InputContext::reset()
-	{
-		m_hoveredItemId = 0;
-		m_captured = false;
-	}
-
-	void InputContext::frameBegin()
-	{
-		m_cursorPos = Cursor::PosF();
+			// 上端が見えていなくても下端が見えていれば表示中とみなす
+			if (itr != m_entries.begin() &&
+				std::prev(itr)->rect.bottomY() > top)
+			{
+				itr--;
+			}
 
-		if (not m_captured)
-		{
-			m_hoveredItemId = 0;
+			return itr == m_entries.end() ? nullptr : &*itr;
 		}
-	}
 
-	// WindowImpl
+	private:
 
-	WindowImpl::WindowImpl(InputContext& input, const StringView id, const StringView name, const Font& font)
-		: window({
-			.displayName = String{ name },
-			.rect = { 0, 0, Config::DefaultWindowSize },
-			.font = font
-		})
-		, m_scrollBars({
-			ScrollBar{Orientation::Horizontal},
-			ScrollBar{Orientation::Vertical}
-		})
-		, m_controls()
-		, m_input(&input)
-		, m_id(id)
-		, m_randomId(RandomUint64())
-	{
-		updateLayout();
-	}
+		Array<Entry> m_entries;
 
-	Optional<Vec2> WindowImpl::getLocalCursorPos() const
-	{
-		if (auto globalCursorPos = m_input->getCursorPos(*this))
-		{
-			if (m_state == WindowState::Default &&
-				m_isContentHovered)
-			{
-				return globalCursorPos->movedBy(-m_layout->contentRect.pos - m_contentLocalRect.pos);
-			}
-		}
-	}
+		HashTable<size_t, size_t> m_lookup;
+	};
 
-	void WindowImpl::frameBegin(InputContext& input)
+	namespace detail
 	{
-		m_input = &input;
-
-		updateWindowState();
-		handleMovingState();
-		handleResizingState();
-		updateLayout();
-
-		for (auto& scrollBar : m_scrollBars)
+		// 同じテンプレートIDのウィンドウで共有する測定結果
+		struct WindowTemplate
 		{
-			scrollBar.update(input.getCursorPos(*this).map([this](Vec2 v) { return v.movedBy(-m_layout->clientRect.pos); }));
-		}
+			std::map<size_t, LayoutCache> layoutCaches;
 
-		window.defined = false;
-		window.lineRect = { window.padding, window.padding, 0, 0 };
-		m_contentLocalRect = {
-			-static_cast<int32>(m_scrollBars[0].value()),
-			-static_cast<int32>(m_scrollBars[1].value()),
-			0, 0
+			HashTable<size_t, Caption> captions;
 		};
-		m_nextControlIdx = 0;
-		window.sameLine = false;
 
-		m_nextPos = none;
-		m_nextSize = none;
-	}
+		using ControlGenerator = std::function<IControl* ()>;
 
-	void WindowImpl::frameEnd()
-	{
-		m_controls.resize(m_nextControlIdx);
-		if (not m_controls.empty())
+		template<class ControlType>
+		static ControlGenerator DefaultGenerator()
 		{
-			m_contentLocalRect.size += { window.padding, window.padding };
+			return []() -> IControl* { return new ControlType(); };
 		}
 
-		updateSize();
-		updatePosition();
-		updateLayout();
-		draw();
-		if (m_resizeFlag != ResizeFlag::None)
+		class WindowImpl : Uncopyable
 		{
-			Cursor::RequestStyle(ToCursorStyle(m_resizeFlag));
-		}
+		public:
 
-		m_firstFrame = false;
-	}
+			using Config = Config::Window;
 
-	void WindowImpl::draw() const
-	{
-		if (not (window.flags & WindowFlag::NoBackground))
-		{
-			RoundRect{ window.rect, Config::Roundness }
-				.drawFrame(0, Config::FrameThickness, Config::FrameColor)
-				.draw(Config::BackColor);
+			using ControlContainer = Array<std::shared_ptr<IControl>>;
 
-			if (not (window.flags & WindowFlag::NoTitlebar))
-			{
-				auto& titleabarRect = m_layout->titlebarRect;
-				auto titlebarText = window.font(window.displayName);
+			WindowImpl(InputContext& input, const StringView id, const StringView name, const Font& font);
 
-				// 背景
-				Rect{ titleabarRect.pos, titleabarRect.w, Config::Roundness }
-					.rounded(Config::Roundness, Config::Roundness, 0, 0)
-					.draw(Config::TitlebarTopColor);
-				titleabarRect
-					.stretched(-Config::Roundness, 0, 1, 0)
-					.draw(Arg::top = Config::TitlebarTopColor, Arg::bottom = Config::TitlebarBottomColor);
-				Rect{ titleabarRect.x, titleabarRect.bottomY() - Config::FrameThickness, titleabarRect.w, Config::FrameThickness }
-					.draw(Config::FrameColor);
+		public:
 
-				// テキスト
-				RectF textRegion(
-					Arg::topCenter = titleabarRect.topCenter(),
-					Min(titlebarText.region().w, titleabarRect.w - Config::Roundness * 2.0),
+			Window window;
+
+			const String& id() const { return m_id; }
+
+			size_t randomId() const { return m_randomId; }
+
+			const Rect& rect() const { return window.rect; }
+
+			// レイヤー内での重なり順 (大きいほど手前)
+			uint64 zOrder = 0;
+
+			// 当たり判定の外接矩形 (非表示のときは空)
+			Rect hitBounds() const
+			{
+				if (window.flags & WindowFlag::Hide)
+				{
+					return { 0, 0, 0, 0 };
+				}
+				if (window.isResizable() && not isCollapsed())
+				{
+					return displayRect().stretched(Config::ResizeGripSize);
+				}
+				return displayRect();
+			}
+
+			bool hitTest(Vec2 pos) const
+			{
+				if (displayRect().contains(pos))
+				{
+					return true;
+				}
+				for (auto& grip : m_layout->resizeGripRect)
+				{
+					if (grip.contains(pos))
+					{
+						return true;
+					}
+				}
+				return false;
+			}
+
+			// 折りたたまれているときはタイトルバーのみの矩形
+			Rect displayRect() const
+			{
+				if (isCollapsed())
+				{
+					return { window.rect.pos, window.rect.w, titlebarHeight() };
+				}
+				return window.rect;
+			}
+
+			bool isCollapsed() const { return m_collapsed && window.isCollapsible(); }
+
+			int32 titlebarHeight() const
+			{
+				if (window.hasTitlebar())
+				{
+					return window.font.height();
+				}
+				else
+				{
+					return 0;
+				}
+			}
+
+			Size minSize() const
+			{
+				if (window.flags & WindowFlag::NoBackground)
+				{
+					return { 0, 0 };
+				}
+				else if (
+					window.flags & WindowFlag::NoScrollbar ||
+					window.flags & WindowFlag::AutoResize)
+				{
+					return {
+						Config::Roundness * 2,
+						Max(Config::Roundness, titlebarHeight()) + Config::Roundness
+					};
+				}
+				else
+				{
+					constexpr static int32 ContentMinSize = ScrollBar::MinLength + ScrollBar::Thickness;
+					return {
+						Max(Config::Roundness * 2, ContentMinSize),
+						Max(Config::Roundness * 2, titlebarHeight() + ContentMinSize)
+					};
+				}
+			}
+
+			Optional<Vec2> getLocalCursorPos() const;
+
+			void frameBegin(InputContext& input);
+
+			void frameEnd();
+
+			// 中身を評価するときはtrue
+			// 非表示・折りたたみ・画面外のときは前回の中身を保ったままfalseを返す
+			bool beginContent();
+
+			template<std::derived_from<IControl> ControlType>
+			inline IControl& nextControl(const std::shared_ptr<ControlType>& control)
+			{
+				return reinterpret_cast<ControlType&>(nextControlImpl(control));
+			}
+
+			template<std::derived_from<IControl> ControlType>
+			inline ControlType& nextStatelessControl(ControlGenerator generator = DefaultGenerator<ControlType>())
+			{
+				return reinterpret_cast<ControlType&>(nextStatelessControlImpl(
+					typeid(ControlType),
+					generator
+				));
+			}
+
+			template<std::derived_from<IControl> ControlType>
+			inline ControlType& nextStatefulControl(size_t id, ControlGenerator generator = DefaultGenerator<ControlType>())
+			{
+				setNextItemId(id);
+				s3d::detail::HashCombine(id, typeid(ControlType).hash_code());
+				return reinterpret_cast<ControlType&>(nextStatefulControlImpl(
+					id,
+					generator
+				));
+			}
+
+			// 実際に更新したときはtrue (測定パス中はfalse)
+			bool updateControl(IControl& control);
+
+			// placeRect()で配置済みのコントロールを更新する
+			bool updateControlAt(IControl& control, Rect localRect);
+
+			// 見出しの後ろから始まるセクションのスコープに入る (閉じているときは前回の中身を残すだけ)
+			// openedは閉じた状態から開いたフレームでtrue
+			void beginSection(size_t id, bool open, bool opened);
+
+			// 評価中のセクションを閉じる
+			void endSection();
+
+			// 閉じ忘れたセクションを子領域などの終わりでまとめて閉じる
+			void endOpenSections();
+
+			void beginChild(size_t id, SizeF size);
+
+			void endChild();
+
+			// 評価中の子領域が縦に末尾までスクロールされているか
+			bool childScrolledToEnd() const;
+
+			// 評価中の子領域の内容の高さを先に決め、末尾までスクロールする
+			void scrollChildToEnd(double contentHeight);
+
+			// 評価中の子領域の内容の大きさを先に決め、矩形 (子領域のコンテンツ座標) が見えるまでスクロールする
+			void scrollChildToShow(const RectF& rect, SizeF contentSize);
+
+			// コンテンツ座標のareaの左上から行送りでコントロールを配置する範囲を開始する
+			// 中のコントロールは独立したスコープに属し、内容の大きさには含めない
+			void beginFloating(size_t id, const RectF& area);
+
+			// 開始してから配置したコントロールの外接矩形 (コンテンツ座標)
+			RectF endFloating();
+
+			// MeasurePassが指定され、自動リサイズ・初回フレームのときは測定パスを開始してtrueを返す
+			bool beginMeasure();
+
+			// 測定パスの評価中か (コントロールの副作用はこの間は起こさない)
+			bool isMeasuring() const { return m_measuring; }
+
+			// 測定結果からウィンドウの大きさと位置を確定させる
+			void endMeasure();
+
+			Rect pushRect(SizeF size);
+
+			// 行送りを使わずにコンテンツ座標の矩形に配置する
+			Rect placeRect(const RectF& contentRect);
+
+			// 評価中の子領域で表示されている範囲 (子領域のコンテンツ座標)
+			RectF childViewport() const;
+
+			RectF contentViewport() const;
+
+			// コンテンツ領域のローカル座標を画面座標にする
+			Vec2 toScreenPos(Vec2 localPos) const
+			{
+				return m_layout ? localPos + m_layout->contentRect.pos : localPos;
+			}
+
+			// 次のコントロールが使える幅 (決まらないときはnone)
+			Optional<double> availableWidth() const;
+
+			void beginLayout(LayoutType type, size_t id, const Array<LayoutTrack>& tracks, Alignment crossAlign);
+
+			void endLayout(LayoutType type);
+
+			void setPos(Vec2 pos, Vec2 offset);
+
+			void setSize(Size size);
+
+			void setTemplate(std::shared_ptr<WindowTemplate> windowTemplate);
+
+			// 次に取得するコントロールがpushRect()するときのID
+			void setNextItemId(size_t id)
+			{
+				m_nextItemId = id;
+				m_nextItemIdClaimed = false;
+			}
+
+			void scrollTo(size_t id) { m_scrollRequest = id; }
+
+			// 整形済みの文字列 (テンプレートがあればテンプレートで共有)
+			const Caption& caption(const StringView text);
+
+			// 評価中の表 (beginTable()からendTable()まで)
+			Table* activeTable() const { return m_activeTable; }
+
+			void setActiveTable(Table* table) { m_activeTable = table; }
+
+			// 評価中のノードグラフ (beginNodeGraph()からendNodeGraph()まで)
+			NodeGraphCanvas* activeNodeGraph() const { return m_activeNodeGraph; }
+
+			void setActiveNodeGraph(NodeGraphCanvas* canvas) { m_activeNodeGraph = canvas; }
+
+		private:
+
+			Table* m_activeTable = nullptr;
+
+			NodeGraphCanvas* m_activeNodeGraph = nullptr;
+
+			struct NextPosition
+			{
+				Vec2 pos;
+
+				Vec2 offset;
+			};
+
+			struct NextSize
+			{
+				Size size;
+			};
+
+			struct ActiveLayout
+			{
+				LayoutContainer container;
+
+				// 入れ子のときの親コンテナでの子の番号
+				Optional<size_t> parentIndex;
+
+				// 最上位のコンテナを開始したときに前の行に続けて配置していたか
+				bool sameLine = false;
+
+				size_t id;
+
+				LayoutCache* cache;
+			};
+
+			// 状態を持たないコントロールを位置で対応付ける範囲
+			// セクションごとに分けることで、開閉しても後ろのコントロールを作り直さない
+			struct ControlScope
+			{
+				ControlContainer controls;
+
+				size_t nextIdx = 0;
+
+				// 前回開いていたときの中身の高さ
+				double extent = 0.0;
+
+				bool used = false;
+			};
+
+			struct ActiveScope
+			{
+				ControlScope* scope;
+
+				bool isSection = false;
+
+				// 開いたフレームでは前回の高さを確保する
+				bool restoreExtent = false;
+
+				double bodyTop = 0.0;
+			};
+
+			// フレームをまたいで保持する子領域の状態
+			struct ChildRegion
+			{
+				ControlScope scope;
+
+				std::array<ScrollBar, 2> scrollBars{
+					ScrollBar{ Orientation::Horizontal },
+					ScrollBar{ Orientation::Vertical }
+				};
+
+				SizeF contentSize{ 0, 0 };
+
+				// スクロールバーを除いた表示領域の大きさ
+				Size viewportSize{ 0, 0 };
+
+				// ホイールの判定に使う前回の表示領域 (画面座標)
+				Rect visibleRect{ 0, 0, 0, 0 };
+
+				// 前回のフレームで開始された順番 (大きいほど内側)
+				size_t order = 0;
+
+				bool used = false;
+
+				bool scrollable() const
+				{
+					return contentSize.x > viewportSize.x
+						|| contentSize.y > viewportSize.y;
+				}
+			};
+
+			// 評価中の子領域と、戻すための親の状態
+			struct ActiveChild
+			{
+				ChildRegion* region;
+
+				// 親のコンテンツ領域でのローカル座標
+				Rect localRect;
+
+				size_t clipIndex;
+
+				RectF lineRect;
+
+				bool sameLine;
+
+				Vec2 contentOrigin;
+
+				SizeF contentSize;
+
+				Array<ActiveLayout> layoutStack;
+
+				size_t layoutScope;
+			};
+
+			// beginFloating()の範囲と、戻すための状態
+			struct ActiveFloating
+			{
+				RectF area;
+
+				RectF lineRect;
+
+				bool sameLine;
+
+				SizeF contentSize;
+
+				Array<ActiveLayout> layoutStack;
+
+				size_t layoutScope;
+			};
+
+			struct DrawItem
+			{
+				std::shared_ptr<IControl> control;
+
+				// controlが空のときは子領域の枠とスクロールバー
+				const ChildRegion* child = nullptr;
+
+				Rect childRect{ 0, 0, 0, 0 };
+
+				// m_clipRectsの番号 (クリップしないときはnone)
+				Optional<size_t> clip;
+			};
+
+			String m_id;
+
+			size_t m_randomId;
+
+			InputContext* m_input;
+
+			WindowState m_state = WindowState::Default;
+
+			ResizeFlag m_resizeFlag = ResizeFlag::None;
+
+			bool m_isContentHovered = false;
+
+			bool m_firstFrame = true;
+
+			bool m_collapsed = false;
+
+			// このフレームでは中身を評価していない
+			bool m_contentSkipped = false;
+
+			// 前回評価した中身でsetPos()かsetSize()が呼ばれた
+			bool m_placedByCode = false;
+
+			SizeF m_prevContentSize{ 0, 0 };
+
+			Optional<WindowLayout> m_layout;
+
+			std::array<ScrollBar, 2> m_scrollBars;
+
+			// コンテンツ座標での浮動原点 (スクロール位置)
+			// コントロールの座標はこの位置からの相対座標で表す
+			Vec2 m_contentOrigin{ 0, 0 };
+
+			SizeF m_contentSize{ 0, 0 };
+
+			// 評価中の行の矩形 (コンテンツ座標)
+			RectF m_lineRect{ 0, 0, 0, 0 };
+
+			Array<ActiveLayout> m_layoutStack;
+
+			// 最上位のレイアウトコンテナのキャッシュを区別する、評価中の子領域などのID
+			size_t m_layoutScope = 0;
+
+			// テンプレートと異なる結果になったコンテナはこちらに持つ
+			std::map<size_t, LayoutCache> m_layoutCaches;
+
+			std::shared_ptr<WindowTemplate> m_template;
+
+			HashTable<size_t, Caption> m_captions;
+
+			// このフレームでレイアウトコンテナが解決し直されたか
+			bool m_layoutResolved = false;
+
+			// 前のフレームでレイアウトが収束していなかったか
+			bool m_layoutUnsettled = false;
+
+			bool m_measuring = false;
+
+			// このフレームで描画するコントロール (評価順)
+			Array<DrawItem> m_controls;
+
+			std::map<size_t, std::shared_ptr<IControl>> m_savedControls;
+
+			ControlScope m_rootScope;
+
+			std::map<size_t, ControlScope> m_sectionScopes;
+
+			Array<ActiveScope> m_scopeStack;
+
+			std::map<size_t, ChildRegion> m_children;
+
+			Array<ActiveChild> m_childStack;
+
+			Array<ActiveFloating> m_floatingStack;
+
+			// 子領域の表示範囲 (コンテンツ領域でのローカル座標)
+			Array<Rect> m_clipRects;
+
+			size_t m_childOrder = 0;
+
+			// ホイールでスクロールさせる子領域
+			Optional<size_t> m_wheelTarget;
+
+			Optional<NextSize> m_nextSize;
+
+			Optional<NextPosition> m_nextPos;
+
+			// 前回評価したときの位置 (評価中はm_nextPositionsに追加する)
+			PositionIndex m_positions;
+
+			PositionIndex m_nextPositions;
+
+			Optional<size_t> m_nextItemId;
+
+			// m_nextItemIdを付けるコントロールを取得済みか
+			bool m_nextItemIdClaimed = false;
+
+			Optional<size_t> m_scrollRequest;
+
+			// ScrollAnchorの基準にしたコントロールとそのコンテンツ座標での上端
+			Optional<PositionIndex::Entry> m_anchor;
+
+			void draw() const;
+
+			void updateWindowState();
+
+			void handleMovingState();
+
+			void handleResizingState();
+
+			void updateLayout();
+
+			void resetContent();
+
+			void finishContent();
+
+			void updateSize();
+
+			void updatePosition();
+
+			Rect toLocalRect(const RectF& contentRect) const;
+
+			// 行の矩形を更新し、公開しているwindow.lineRectにも丸めて反映する
+			void setLineRect(const RectF& lineRect);
+
+			Vec2 nextLinePos() const;
+
+			void extendContent(const RectF& contentRect);
+
+			// コントロールを取得するときに、前のコントロールのIDが残っていれば捨てる
+			void claimNextItemId();
+
+			// 行送りで配置した矩形を行と内容の大きさに反映する (sameLineのときは前の行に続ける)
+			void advanceLine(const RectF& contentRect, bool sameLine);
+
+			void pushDrawItem(DrawItem item);
+
+			Optional<size_t> findWheelTarget() const;
+
+			void updateChildLayout(ChildRegion& region, Size size);
+
+			// 評価中の子領域のスクロール位置を表示領域と座標系に反映する
+			void applyChildScroll();
+
+			// 中身が確定した後にスクロール位置を合わせる
+			void updateScroll();
+
+			IControl& nextControlImpl(const std::shared_ptr<IControl>& control);
+
+			IControl& nextStatelessControlImpl(const std::type_info& type, ControlGenerator& generator);
+
+			IControl& nextStatefulControlImpl(size_t id, ControlGenerator& generator);
+		};
+	}
+
+	// ウィンドウの当たり判定に使う一様グリッド
+	// 外接矩形か重なり順が変わったウィンドウだけを入れ直す
+	class WindowIndex
+	{
+	public:
+
+		constexpr static int32 CellSize = 256;
+
+		// これより多くのセルにまたがるウィンドウはグリッドに入れない
+		constexpr static int32 MaxCellsPerWindow = 64;
+
+		void update(WindowImpl& window, WindowLayer layer);
+
+		void remove(const WindowImpl& window);
+
+		// 一番手前で点を含むウィンドウ
+		WindowImpl* hitTest(Vec2 pos) const;
+
+	private:
+
+		struct Entry
+		{
+			WindowImpl* window;
+
+			uint64 zKey;
+
+			Rect bounds;
+		};
+
+		struct IndexedWindow
+		{
+			Rect bounds;
+
+			uint64 zKey;
+
+			bool large;
+		};
+
+		// 各セルはzKeyの降順
+		HashTable<uint64, Array<Entry>> m_cells;
+
+		Array<Entry> m_largeWindows;
+
+		HashTable<const WindowImpl*, IndexedWindow> m_windows;
+
+		static uint64 CellKey(int32 x, int32 y)
+		{
+			return (static_cast<uint64>(static_cast<uint32>(x)) << 32) | static_cast<uint32>(y);
+		}
+
+		static std::pair<Point, Point> CellRange(const Rect& bounds)
+		{
+			return {
+				{ FloorDiv(bounds.x, CellSize), FloorDiv(bounds.y, CellSize) },
+				{ FloorDiv(bounds.x + bounds.w - 1, CellSize), FloorDiv(bounds.y + bounds.h - 1, CellSize) }
+			};
+		}
+
+		static int32 FloorDiv(int32 a, int32 b)
+		{
+			return a >= 0 ? a / b : -((-a + b - 1) / b);
+		}
+
+		static void Insert(Array<Entry>& entries, const Entry& entry)
+		{
+			auto itr = std::upper_bound(entries.begin(), entries.end(), entry.zKey,
+				[](uint64 zKey, const Entry& e) { return zKey > e.zKey; });
+			entries.insert(itr, entry);
+		}
+
+		static void Erase(Array<Entry>& entries, const WindowImpl* window)
+		{
+			entries.remove_if([window](const Entry& e) { return e.window == window; });
+		}
+	};
+
+	class Layer
+	{
+	public:
+
+		using container_type = HashTable<String, std::unique_ptr<WindowImpl>>;
+
+		Layer(WindowLayer type)
+			: type(type)
+		{ }
+
+	public:
+
+		const WindowLayer type;
+
+		const container_type& container() const { return m_container; }
+
+		void frameBegin(InputContext& input);
+
+		void frameEnd(WindowIndex& index);
+
+		WindowImpl& defineWindow(const StringView id, const StringView name, const Font& font);
+
+	private:
+
+		container_type m_container;
+
+		std::list<String> m_windowOrder;
+
+		InputContext* m_input;
+
+		uint64 m_nextZOrder = 0;
+
+		container_type::iterator createWindow(const StringView id, const StringView name, const Font& font);
+
+		void deleteUnusedWindow(WindowIndex& index);
+	};
+
+	namespace detail
+	{
+		class GUIImpl
+		{
+		public:
+
+			Font font = SimpleGUI::GetFont();
+
+			std::array<Layer, 3>& layers() { return m_layers; }
+
+			void frameBegin();
+
+			void frameEnd();
+
+			Layer& getLayer(WindowLayer layer);
+
+			WindowImpl& defineWindow(WindowLayer layer, const StringView id, const StringView name);
+
+			std::shared_ptr<WindowTemplate> getTemplate(const StringView id);
+
+		private:
+
+			std::array<Layer, 3> m_layers{
+				Layer{ WindowLayer::Background },
+				Layer{ WindowLayer::Normal },
+				Layer{ WindowLayer::Foreground }
+			};
+
+			InputContext m_input;
+
+			WindowIndex m_windowIndex;
+
+			HashTable<String, std::shared_ptr<WindowTemplate>> m_templates;
+		};
+	}
+
+	static StringView ToString(WindowLayer layer)
+	{
+		return std::array{ U"Background", U"Normal", U"Foreground" } [static_cast<int32>(layer)] ;
+	}
+
+	static Rect IntersectRect(const Rect& a, const Rect& b)
+	{
+		const Point tl{ Max(a.x, b.x), Max(a.y, b.y) };
+		const Point br{ Min(a.x + a.w, b.x + b.w), Min(a.y + a.h, b.y + b.h) };
+		return { tl, Max(br.x - tl.x, 0), Max(br.y - tl.y, 0) };
+	}
+
+	static CursorStyle ToCursorStyle(ResizeFlag flag)
+	{
+		switch (flag)
+		{
+		case ResizeFlag::Top:
+		case ResizeFlag::Bottom:
+			return CursorStyle::ResizeUpDown;
+		case ResizeFlag::Top | ResizeFlag::Right:
+		case ResizeFlag::Bottom | ResizeFlag::Left:
+			return CursorStyle::ResizeNESW;
+		case ResizeFlag::Right:
+		case ResizeFlag::Left:
+			return CursorStyle::ResizeLeftRight;
+		case ResizeFlag::Right | ResizeFlag::Bottom:
+		case ResizeFlag::Left | ResizeFlag::Top:
+			return CursorStyle::ResizeNWSE;
+		default:
+			return CursorStyle::Default;
+		}
+	}
+
+	// InputContext
+
+	bool InputContext::hover(const WindowImpl& window)
+	{
+		if (m_hoveredItemId == 0)
+		{
+			m_hoveredItemId = window.randomId();
+			return true;
+		}
+
+		if (m_hoveredItemId == window.randomId())
+		{
+			return true;
+		}
+
+		return false;
+	}
+
+	bool InputContext::capture(const WindowImpl& window, bool capture)
+	{
+		if (m_hoveredItemId == 0 ||
+			m_hoveredItemId == window.randomId())
+		{
+			m_captured = capture;
+			if (capture)
+			{
+				m_hoveredItemId = window.randomId();
+			}
+			else
+			{
+				m_hoveredItemId = 0;
+			}
+			return true;
+		}
+
+		return false;
+	}
+
+	Optional<Vec2> InputContext::getCursorPos() const
+	{
+		if (m_hoveredItemId == 0)
+		{
+			return m_cursorPos;
+		}
+
+		return none;
+	}
+
+	Optional<Vec2> InputContext::getCursorPos(const WindowImpl& window) const
+	{
+		if (m_hoveredItemId == 0 ||
+			m_hoveredItemId == window.randomId())
+		{
+			return m_cursorPos;
+		}
+
+		return none;
+	}
+
+	void InputContext::reset()
+	{
+		m_hoveredItemId = 0;
+		m_captured = false;
+	}
+
+	void InputContext::frameBegin()
+	{
+		m_cursorPos = Cursor::PosF();
+
+		if (not m_captured)
+		{
+			m_hoveredItemId = 0;
+		}
+	}
+
+	// WindowImpl
+
+	WindowImpl::WindowImpl(InputContext& input, const StringView id, const StringView name, const Font& font)
+		: window({
+			.displayName = String{ name },
+			.rect = { 0, 0, Config::DefaultWindowSize },
+			.font = font
+		})
+		, m_scrollBars({
+			ScrollBar{Orientation::Horizontal},
+			ScrollBar{Orientation::Vertical}
+		})
+		, m_controls()
+		, m_children()
+		, m_input(&input)
+		, m_id(id)
+		, m_randomId(RandomUint64())
+	{
+		updateLayout();
+	}
+
+	Optional<Vec2> WindowImpl::getLocalCursorPos() const
+	{
+		if (auto globalCursorPos = m_input->getCursorPos(*this))
+		{
+			if (m_state == WindowState::Default &&
+				m_isContentHovered)
+			{
+				return globalCursorPos->movedBy(-m_layout->contentRect.pos);
+			}
+		}
+
+		return none;
+	}
+
+	void WindowImpl::frameBegin(InputContext& input)
+	{
+		m_input = &input;
+
+		m_wheelTarget = findWheelTarget();
+		updateWindowState();
+		handleMovingState();
+		handleResizingState();
+		updateLayout();
+
+		if (not isCollapsed())
+		{
+			for (auto& scrollBar : m_scrollBars)
+			{
+				scrollBar.update(input.getCursorPos(*this).map([this](Vec2 v) { return v.movedBy(-m_layout->clientRect.pos); }));
+			}
+		}
+
+		window.defined = false;
+		m_prevContentSize = m_contentSize;
+		m_contentSkipped = false;
+		resetContent();
+		m_layoutResolved = false;
+		m_measuring = false;
+
+		m_nextPos = none;
+		m_nextSize = none;
+	}
+
+	void WindowImpl::resetContent()
+	{
+		setLineRect({ window.padding, window.padding, 0, 0 });
+		m_contentOrigin = {
+			Math::Floor(m_scrollBars[0].value()),
+			Math::Floor(m_scrollBars[1].value())
+		};
+		m_contentSize = { 0, 0 };
+		m_layoutStack.clear();
+		m_layoutScope = 0;
+		m_childStack.clear();
+		m_clipRects.clear();
+		m_floatingStack.clear();
+		m_activeTable = nullptr;
+		m_activeNodeGraph = nullptr;
+		m_childOrder = 0;
+		m_controls.clear();
+		m_nextPositions.clear();
+		m_nextItemId = none;
+		m_nextItemIdClaimed = false;
+		m_rootScope.nextIdx = 0;
+		m_scopeStack = { ActiveScope{ .scope = &m_rootScope } };
+		window.sameLine = false;
+	}
+
+	void WindowImpl::finishContent()
+	{
+		while (not m_childStack.empty())
+		{
+			endChild();
+		}
+
+		while (not m_layoutStack.empty())
+		{
+			endLayout(m_layoutStack.back().container.type());
+		}
+
+		endOpenSections();
+		m_rootScope.controls.resize(m_rootScope.nextIdx);
+		m_nextPositions.finish();
+		if (not m_controls.empty())
+		{
+			m_contentSize += { window.padding, window.padding };
+		}
+	}
+
+	bool WindowImpl::beginMeasure()
+	{
+		// 呼び出し側のコードを2回実行するので、明示的に指定されたときだけ測定する
+		if (not (window.flags & WindowFlag::MeasurePass))
+		{
+			return false;
+		}
+
+		if (not (m_firstFrame ||
+			window.flags & WindowFlag::AutoResize ||
+			m_layoutUnsettled))
+		{
+			return false;
+		}
+
+		m_measuring = true;
+		return true;
+	}
+
+	void WindowImpl::endMeasure()
+	{
+		assert(m_measuring);
+
+		// 測定した大きさでウィンドウの大きさ・位置・スクロールの制約を先に確定させる
+		finishContent();
+		updateSize();
+		updatePosition();
+		updateLayout();
+
+		// 確定したスクロール位置を原点にして配置パスをやり直す
+		resetContent();
+		m_layoutResolved = false;
+		m_measuring = false;
+	}
+
+	bool WindowImpl::beginContent()
+	{
+		// 中身の中で位置や大きさを決めているウィンドウは、画面外でも評価しないと戻ってこられない
+		bool placedByCode = m_placedByCode || m_nextPos || m_nextSize;
+		bool offscreen = not m_firstFrame && not placedByCode && not displayRect().intersects(Scene::Rect());
+
+		m_contentSkipped = window.flags & WindowFlag::Hide || isCollapsed() || offscreen;
+		if (not m_contentSkipped)
+		{
+			m_placedByCode = false;
+		}
+		return not m_contentSkipped;
+	}
+
+	void WindowImpl::frameEnd()
+	{
+		if (m_contentSkipped)
+		{
+			// 評価しなかったフレームは前回のコントロールとレイアウトを保持する
+			m_contentSize = m_prevContentSize;
+		}
+		else
+		{
+			finishContent();
+			m_layoutUnsettled = m_layoutResolved;
+
+			// テンプレートで共有しているものはGUIImplでまとめて整理する
+			EraseUnused(m_layoutCaches);
+			EraseUnused(m_sectionScopes);
+			EraseUnused(m_children);
+			EraseUnused(m_captions);
+		}
+
+		updateSize();
+		updatePosition();
+		updateLayout();
+		if (not m_contentSkipped)
+		{
+			std::swap(m_positions, m_nextPositions);
+			updateScroll();
+		}
+		m_scrollRequest = none;
+
+		if (window.flags & WindowFlag::Hide)
+		{
+			m_firstFrame = false;
+			return;
+		}
+
+		draw();
+		if (m_resizeFlag != ResizeFlag::None)
+		{
+			Cursor::RequestStyle(ToCursorStyle(m_resizeFlag));
+		}
+
+		m_firstFrame = false;
+	}
+
+	void WindowImpl::draw() const
+	{
+		if (not (window.flags & WindowFlag::NoBackground))
+		{
+			RoundRect{ displayRect(), Config::Roundness }
+				.drawFrame(0, Config::FrameThickness, Config::FrameColor)
+				.draw(Config::BackColor);
+
+			if (not (window.flags & WindowFlag::NoTitlebar))
+			{
+				auto& titleabarRect = m_layout->titlebarRect;
+				auto titlebarText = window.font(window.displayName);
+
+				// 背景
+				if (isCollapsed())
+				{
+					titleabarRect
+						.rounded(Config::Roundness)
+						.draw(Config::TitlebarTopColor);
+				}
+				else
+				{
+					Rect{ titleabarRect.pos, titleabarRect.w, Config::Roundness }
+						.rounded(Config::Roundness, Config::Roundness, 0, 0)
+						.draw(Config::TitlebarTopColor);
+					titleabarRect
+						.stretched(-Config::Roundness, 0, 1, 0)
+						.draw(Arg::top = Config::TitlebarTopColor, Arg::bottom = Config::TitlebarBottomColor);
+					Rect{ titleabarRect.x, titleabarRect.bottomY() - Config::FrameThickness, titleabarRect.w, Config::FrameThickness }
+						.draw(Config::FrameColor);
+				}
+
+				// 折りたたみボタン
+				auto& collapseButtonRect = m_layout->collapseButtonRect;
+				if (window.isCollapsible())
+				{
+					Triangle{
+						collapseButtonRect.center(),
+						collapseButtonRect.h * Config::CollapseButtonScale * 2,
+						isCollapsed() ? 90_deg : 180_deg
+					}.draw(Config::CollapseButtonColor);
+				}
+
+				// テキスト
+				RectF textRegion(
+					Arg::topCenter = titleabarRect.topCenter(),
+					Min(titlebarText.region().w, titleabarRect.w - Max(Config::Roundness, collapseButtonRect.w) * 2.0),
 					titleabarRect.h
 				);
 				titlebarText.draw(textRegion, Config::TitlebarLabelColor);
 			}
-		}
+		}
+
+		// 評価していない中身は描画しない (画面外か折りたたまれている)
+		if (m_contentSkipped || isCollapsed())
+		{
+			return;
+		}
+
+		{
+			ScopedViewport2D sv{ m_layout->clientRect };
+			{
+				// 配置後にスクロール位置が制約で動いた分を補正
+				const Vec2 scrollOrigin{
+					Math::Floor(m_scrollBars[0].value()),
+					Math::Floor(m_scrollBars[1].value())
+				};
+				const Vec2 offset = m_contentOrigin - scrollOrigin;
+				Transformer2D t{ Mat3x2::Translate(offset), Transformer2D::Target::SetLocal };
+
+				// 子領域があるときだけシザー矩形で切り抜く
+				Optional<ScopedRenderStates2D> scissorState;
+				Rect prevScissorRect;
+				if (m_clipRects)
+				{
+					scissorState.emplace(RasterizerState::SolidCullNoneScissor);
+					prevScissorRect = Graphics2D::GetScissorRect();
+				}
+
+				bool scissorSet = false;
+				Optional<size_t> currentClip;
+				for (auto& item : m_controls)
+				{
+					if (m_clipRects && (not scissorSet || currentClip != item.clip))
+					{
+						// クリップが変わったときだけ設定し直す
+						Rect scissorRect = m_layout->contentRect;
+						if (item.clip)
+						{
+							scissorRect = IntersectRect(scissorRect, m_clipRects[*item.clip].movedBy(m_layout->contentRect.pos + offset.asPoint()));
+						}
+						Graphics2D::SetScissorRect(scissorRect);
+						currentClip = item.clip;
+						scissorSet = true;
+					}
+
+					if (item.control)
+					{
+						item.control->draw();
+					}
+					else
+					{
+						Transformer2D ct{ Mat3x2::Translate(item.childRect.pos) };
+						for (auto& scrollBar : item.child->scrollBars)
+						{
+							scrollBar.draw();
+						}
+						Rect{ item.childRect.size }
+							.drawFrame(SasaGUI::Config::Child::FrameThickness, 0, SasaGUI::Config::Child::FrameColor);
+					}
+				}
+
+				if (scissorState)
+				{
+					Graphics2D::SetScissorRect(prevScissorRect);
+				}
+			}
+			{
+				Transformer2D t{ Mat3x2::Identity(), Transformer2D::Target::SetLocal };
+				for (auto& scrollBar : m_scrollBars)
+				{
+					scrollBar.draw();
+				}
+			}
+		}
+	}
+
+	void WindowImpl::claimNextItemId()
+	{
+		// 前のコントロールに付けたIDが配置されないまま残っていれば捨てる
+		if (m_nextItemIdClaimed)
+		{
+			m_nextItemId = none;
+		}
+		m_nextItemIdClaimed = m_nextItemId.has_value();
+	}
+
+	IControl& WindowImpl::nextControlImpl(const std::shared_ptr<IControl>& control)
+	{
+		claimNextItemId();
+		pushDrawItem({ .control = control });
+
+		return *control;
+	}
+
+	IControl& WindowImpl::nextStatelessControlImpl(const std::type_info& type, ControlGenerator& generator)
+	{
+		claimNextItemId();
+
+		auto& scope = *m_scopeStack.back().scope;
+
+		if (scope.nextIdx < scope.controls.size() &&
+			typeid(*scope.controls[scope.nextIdx]) != type)
+		{
+			scope.controls.resize(scope.nextIdx);
+		}
+
+		if (scope.nextIdx >= scope.controls.size())
+		{
+			scope.controls.emplace_back(std::shared_ptr<IControl>(generator()));
+			// Console << U"[+Control] " << Unicode::FromUTF8(type.name());
+		}
+
+		auto& control = scope.controls[scope.nextIdx];
+
+		scope.nextIdx++;
+		pushDrawItem({ .control = control });
+
+		return *control;
+	}
+
+	IControl& WindowImpl::nextStatefulControlImpl(size_t id, ControlGenerator& generator)
+	{
+		claimNextItemId();
+
+		s3d::detail::HashCombine(id, m_randomId);
+
+		auto controlItr = m_savedControls.find(id);
+		if (controlItr == m_savedControls.end())
+		{
+			auto [tmp, _] = m_savedControls.emplace(
+				id,
+				std::shared_ptr<IControl>(generator())
+			);
+			controlItr = tmp;
+			// Console << U"[+Control] " << id;
+		}
+
+		auto& control = controlItr->second;
+
+		pushDrawItem({ .control = control });
+
+		return *control;
+	}
+
+	void WindowImpl::updateWindowState()
+	{
+		m_isContentHovered = false;
+
+		// 非表示のウィンドウは入力を受け取らない
+		if (window.flags & WindowFlag::Hide)
+		{
+			m_resizeFlag = ResizeFlag::None;
+			if (m_state != WindowState::Default)
+			{
+				m_state = WindowState::Default;
+				m_input->capture(*this, false);
+			}
+			return;
+		}
+
+		Rect& windowRect = window.rect;
+		if (auto cursor = m_input->getCursorPos(*this))
+		{
+			if (displayRect().contains(*cursor))
+			{
+				m_input->hover(*this);
+				window.requestMoveToFront |= MouseL.down();
+			}
+
+			switch (m_state)
+			{
+			case SasaGUI::WindowState::Default:
+
+				m_resizeFlag = ResizeFlag::None;
+				for (int32 i = 0; i < static_cast<int32>(Side::Count); i++)
+				{
+					auto& grip = m_layout->resizeGripRect[i];
+
+					if (grip.contains(*cursor))
+					{
+						m_resizeFlag |= static_cast<ResizeFlag>(1 << i);
+					}
+				}
+				if (m_resizeFlag != ResizeFlag::None)
+				{
+					if (window.isResizable() && MouseL.down())
+					{
+						m_state = WindowState::Resizing;
+						window.requestMoveToFront = true;
+						m_input->capture(*this, true);
+					}
+					m_input->hover(*this);
+					break;
+				}
+
+				if (m_layout->titlebarRect.contains(*cursor))
+				{
+					if (window.isCollapsible() &&
+						m_layout->collapseButtonRect.contains(*cursor))
+					{
+						Cursor::RequestStyle(CursorStyle::Hand);
+						m_collapsed ^= MouseL.down();
+						break;
+					}
+
+					if (window.isMovable() && MouseL.down())
+					{
+						m_state = WindowState::Moving;
+						m_input->capture(*this, true);
+					}
+					break;
+				}
+
+				// 子領域の上ではその子領域をスクロールする
+				if (m_layout->contentRect.contains(*cursor) && not m_wheelTarget)
+				{
+					m_scrollBars[0].scroll(Mouse::WheelH() * window.font.height() * Config::ScrollSpeed);
+					m_scrollBars[1].scroll(Mouse::Wheel() * window.font.height() * Config::ScrollSpeed);
+				}
+
+				if (m_scrollBars[0].rect().contains(*cursor))
+				{
+					if (MouseL.down())
+					{
+						m_state = WindowState::Scrolling;
+						m_input->capture(*this, true);
+					}
+					break;
+				}
+
+				if (m_scrollBars[0].rect().contains(*cursor))
+				{
+					if (MouseL.down())
+					{
+						m_state = WindowState::Scrolling;
+						m_input->capture(*this, true);
+					}
+					break;
+				}
+
+				m_isContentHovered = m_layout->contentRect.contains(*cursor);
+
+				break;
+			case SasaGUI::WindowState::Moving:
+			case SasaGUI::WindowState::Resizing:
+			case SasaGUI::WindowState::Scrolling:
+				if (not MouseL.pressed())
+				{
+					m_state = WindowState::Default;
+					m_input->capture(*this, false);
+				}
+				break;
+			}
+		}
+	}
+
+	void WindowImpl::handleMovingState()
+	{
+		if (m_state != WindowState::Moving)
+		{
+			return;
+		}
+
+		window.rect.pos += Cursor::Delta();
+	}
+
+	void WindowImpl::handleResizingState()
+	{
+		if (m_state != WindowState::Resizing)
+		{
+			return;
+		}
+
+		auto delta = Cursor::Delta();
+		Size min = minSize();
+
+		if (m_resizeFlag & ResizeFlag::Left)
+		{
+			delta.x = Min(delta.x, window.rect.w - min.x);
+			window.rect.x += delta.x;
+			window.rect.w -= delta.x;
+		}
+		else if (m_resizeFlag & ResizeFlag::Right)
+		{
+			window.rect.w = Max(window.rect.w + delta.x, min.x);
+		}
+
+		if (m_resizeFlag & ResizeFlag::Top)
+		{
+			delta.y = Min(delta.y, window.rect.h - min.y);
+			window.rect.y += delta.y;
+			window.rect.h -= delta.y;
+		}
+		else if (m_resizeFlag & ResizeFlag::Bottom)
+		{
+			window.rect.h = Max(window.rect.h + delta.y, min.y);
+		}
+	}
+
+	void WindowImpl::updateLayout()
+	{
+		if (isCollapsed())
+		{
+			// タイトルバーのみ
+			Rect client{
+				window.rect.x,
+				window.rect.y + titlebarHeight(),
+				window.rect.w,
+				0
+			};
+			m_layout = WindowLayout{
+				.titlebarRect = {
+					window.rect.pos,
+					window.rect.w,
+					titlebarHeight()
+				},
+				.collapseButtonRect = {
+					window.rect.pos,
+					titlebarHeight(),
+					titlebarHeight()
+				},
+				.clientRect = client,
+				.contentRect = client
+			};
+			return;
+		}
+
+		if (not window.hasTitlebar())
+		{
+			m_layout = WindowLayout{
+				.titlebarRect = { 0, 0, 0, 0 },
+				.clientRect = window.rect,
+				.contentRect = window.rect
+			};
+
+			// ResizeGrip
+
+			if (window.isResizable())
+			{
+				// Top
+				m_layout->resizeGripRect[0] = {
+					window.rect.leftX() - Config::ResizeGripSize,
+					window.rect.topY() - Config::ResizeGripSize,
+					window.rect.w + Config::ResizeGripSize * 2,
+					Config::ResizeGripSize
+				};
+				// Right
+				m_layout->resizeGripRect[1] = {
+					window.rect.rightX(),
+					window.rect.topY() - Config::ResizeGripSize,
+					Config::ResizeGripSize,
+					window.rect.h + Config::ResizeGripSize * 2,
+				};
+				// Bottom
+				m_layout->resizeGripRect[2] = {
+					window.rect.leftX() - Config::ResizeGripSize,
+					window.rect.bottomY(),
+					window.rect.w + Config::ResizeGripSize * 2,
+					Config::ResizeGripSize
+				};
+				// Left
+				m_layout->resizeGripRect[3] = {
+					window.rect.leftX() - Config::ResizeGripSize,
+					window.rect.topY() - Config::ResizeGripSize,
+					Config::ResizeGripSize,
+					window.rect.h + Config::ResizeGripSize * 2,
+				};
+			}
+		}
+		else
+		{
+			Rect client{
+				window.rect.x,
+				window.rect.y + titlebarHeight(),
+				window.rect.w,
+				window.rect.h - titlebarHeight()
+			};
+			m_layout = WindowLayout{
+				.titlebarRect = {
+					window.rect.pos,
+					window.rect.w,
+					titlebarHeight()
+				},
+				.collapseButtonRect = window.isCollapsible()
+					? Rect{ window.rect.pos, titlebarHeight(), titlebarHeight() }
+					: Rect{ 0, 0, 0, 0 },
+				.clientRect = client,
+				.contentRect = client
+			};
+
+			// ResizeGrip
+
+			if (window.isResizable())
+			{
+				// Top
+				m_layout->resizeGripRect[0] = {
+					window.rect.leftX() - Config::ResizeGripSize,
+					window.rect.topY(),
+					window.rect.w + Config::ResizeGripSize * 2,
+					Config::ResizeGripSize
+				};
+				// Right
+				m_layout->resizeGripRect[1] = {
+					window.rect.rightX(),
+					window.rect.topY(),
+					Config::ResizeGripSize,
+					window.rect.h + Config::ResizeGripSize,
+				};
+				// Bottom
+				m_layout->resizeGripRect[2] = {
+					window.rect.leftX() - Config::ResizeGripSize,
+					window.rect.bottomY(),
+					window.rect.w + Config::ResizeGripSize * 2,
+					Config::ResizeGripSize
+				};
+				// Left
+				m_layout->resizeGripRect[3] = {
+					window.rect.leftX() - Config::ResizeGripSize,
+					window.rect.topY(),
+					Config::ResizeGripSize,
+					window.rect.h + Config::ResizeGripSize,
+				};
+			}
+		}
+
+		//スクロールバー
+
+		bool hbar = false;
+		bool vbar = false;
+
+		if (not (window.flags & WindowFlag::NoScrollbar))
+		{
+			hbar = m_contentSize.x > m_layout->contentRect.w;
+			vbar = m_contentSize.y > m_layout->contentRect.h;
+
+			// バーの表示によってコントロールが隠れるときはスクロールバーを表示
+
+			if (hbar)
+			{
+				vbar |= m_contentSize.y > m_layout->contentRect.h - ScrollBar::Thickness;
+			}
+			if (vbar)
+			{
+				hbar |= m_contentSize.x > m_layout->contentRect.w - ScrollBar::Thickness;
+			}
+		}
+
+		// バーの大きさとコントロールが表示できる領域を決定
+
+		if (hbar && vbar)
+		{
+			m_scrollBars[0].updateLayout({
+				0,
+				m_layout->clientRect.h - ScrollBar::Thickness,
+				m_layout->clientRect.w - ScrollBar::Thickness,
+				ScrollBar::Thickness
+			});
+			m_scrollBars[1].updateLayout({
+				m_layout->clientRect.w - ScrollBar::Thickness,
+				0,
+				ScrollBar::Thickness,
+				m_layout->clientRect.h - ScrollBar::Thickness
+			});
+			m_layout->contentRect.h -= ScrollBar::Thickness;
+			m_layout->contentRect.w -= ScrollBar::Thickness;
+		}
+		else
+		{
+			if (hbar)
+			{
+				m_layout->contentRect.h -= ScrollBar::Thickness;
+			}
+
+			if (vbar)
+			{
+				m_layout->contentRect.w -= ScrollBar::Thickness;
+			}
+
+			m_scrollBars[0].updateLayout({
+				0,
+				m_layout->clientRect.h - ScrollBar::Thickness,
+				m_layout->clientRect.w - ScrollBar::Thickness,
+				ScrollBar::Thickness
+			});
+
+			m_scrollBars[1].updateLayout({
+				m_layout->clientRect.w - ScrollBar::Thickness,
+				0,
+				ScrollBar::Thickness,
+				m_layout->clientRect.h - ScrollBar::Thickness
+			});
+		}
+
+		// スクロールバーの上限, 下限を更新
+
+		if (hbar)
+		{
+			m_scrollBars[1].updateConstraints(0.0, m_contentSize.y + ScrollBar::Thickness, m_layout->contentRect.h);
+		}
+		else
+		{
+			m_scrollBars[1].updateConstraints(0.0, m_contentSize.y, m_layout->contentRect.h);
+		}
+
+		if (vbar)
+		{
+			m_scrollBars[0].updateConstraints(0.0, m_contentSize.x + ScrollBar::Thickness, m_layout->contentRect.w);
+		}
+		else
+		{
+			m_scrollBars[0].updateConstraints(0.0, m_contentSize.x, m_layout->contentRect.w);
+		}
+	}
+
+	void WindowImpl::updateSize()
+	{
+		Size& windowSize = window.rect.size;
+
+		if (m_nextSize)
+		{
+			Size min = minSize();
+			windowSize.x = Max(m_nextSize->size.x, min.x);
+			windowSize.y = Max(m_nextSize->size.y, min.y);
+		}
+		else if (m_firstFrame || window.flags & WindowFlag::AutoResize)
+		{
+			windowSize = {
+				static_cast<int32>(Min(Math::Ceil(m_contentSize.x), Config::MaxLocalCoord)),
+				static_cast<int32>(Min(Math::Ceil(m_contentSize.y), Config::MaxLocalCoord))
+			};
+			windowSize.y += titlebarHeight();
+
+			Size min = minSize();
+			windowSize.x = Max(windowSize.x, min.x);
+			windowSize.y = Max(windowSize.y, min.y);
+		}
+	}
+
+	void WindowImpl::updatePosition()
+	{
+		if (m_nextPos)
+		{
+			window.rect.pos = (m_nextPos->pos - window.rect.size * m_nextPos->offset).asPoint();
+		}
+		m_nextPos = none;
+	}
+
+	bool WindowImpl::updateControl(IControl& control)
+	{
+		return updateControlAt(control, pushRect(control.computeSize()));
+	}
+
+	bool WindowImpl::updateControlAt(IControl& control, Rect localRect)
+	{
+		if (m_measuring)
+		{
+			return false;
+		}
+
+		Optional<Vec2> localCursorPos = getLocalCursorPos();
+
+		if (not m_childStack.empty())
+		{
+			// 子領域の外に出たコントロールは更新も描画もしない
+			const Rect& clipRect = m_clipRects[m_childStack.back().clipIndex];
+			if (not clipRect.intersects(localRect))
+			{
+				if (m_controls && m_controls.back().control.get() == &control)
+				{
+					m_controls.pop_back();
+				}
+				return false;
+			}
+
+			if (localCursorPos && not clipRect.contains(*localCursorPos))
+			{
+				localCursorPos = none;
+			}
+		}
+
+		control.update(localRect, localCursorPos);
+		return true;
+	}
+
+	void WindowImpl::beginSection(size_t id, bool open, bool opened)
+	{
+		auto& scope = m_sectionScopes[id];
+		scope.used = true;
+
+		// 閉じているセクションは中身を評価しないので前回のコントロールを残す
+		if (not open)
+		{
+			return;
+		}
+
+		scope.nextIdx = 0;
+		m_scopeStack.push_back(ActiveScope{
+			.scope = &scope,
+			.isSection = true,
+			.restoreExtent = opened,
+			.bodyTop = m_lineRect.bottomY()
+		});
+	}
+
+	void WindowImpl::endSection()
+	{
+		if (not m_scopeStack.back().isSection)
+		{
+			return;
+		}
+
+		ActiveScope section = m_scopeStack.back();
+		m_scopeStack.pop_back();
+
+		auto& scope = *section.scope;
+		scope.controls.resize(scope.nextIdx);
+
+		double extent = m_lineRect.bottomY() - section.bodyTop;
+		if (section.restoreExtent && extent < scope.extent)
+		{
+			// 開いた直後は前回の高さを確保してスクロールバーを安定させる
+			extendContent({ m_lineRect.x, section.bodyTop, 0, scope.extent });
+		}
+		scope.extent = extent;
+	}
+
+	void WindowImpl::endOpenSections()
+	{
+		while (m_scopeStack.back().isSection)
+		{
+			endSection();
+		}
+	}
+
+	void WindowImpl::updateScroll()
+	{
+		auto& vbar = m_scrollBars[1];
+
+		// 基準のコントロールが動いた分だけスクロールして表示位置を保つ
+		if (window.flags & WindowFlag::ScrollAnchor && m_anchor)
+		{
+			if (auto rect = m_positions.find(m_anchor->id))
+			{
+				m_scrollBars[0].shift(rect->x - m_anchor->rect.x);
+				vbar.shift(rect->y - m_anchor->rect.y);
+			}
+		}
+
+		if (m_scrollRequest)
+		{
+			if (auto rect = m_positions.find(*m_scrollRequest))
+			{
+				// 見えていない方向にだけ動かす
+				for (auto& bar : m_scrollBars)
+				{
+					const bool horizontal = bar.orientation == Orientation::Horizontal;
+					const double pos = horizontal ? rect->x : rect->y;
+					const double size = horizontal ? rect->w : rect->h;
+					const double target = bar.value();
+					if (pos - window.padding < target)
+					{
+						bar.scroll(pos - window.padding - target);
+					}
+					else if (pos + size + window.padding > target + bar.viewportSize())
+					{
+						bar.scroll(Min(pos - window.padding, pos + size + window.padding - bar.viewportSize()) - target);
+					}
+				}
+			}
+		}
+
+		m_anchor = none;
+		if (window.flags & WindowFlag::ScrollAnchor)
+		{
+			if (auto entry = m_positions.firstVisible(vbar.value()))
+			{
+				m_anchor = *entry;
+			}
+		}
+	}
+
+	Rect WindowImpl::pushRect(SizeF size)
+	{
+		RectF contentRect;
+
+		if (not m_layoutStack.empty())
+		{
+			// レイアウトコンテナの中ではコンテナが位置を決める
+			contentRect = m_layoutStack.back().container.place(size);
+			window.sameLine = false;
+			extendContent(contentRect);
+		}
+		else
+		{
+			// コントロールの位置をコンテンツ座標で計算
+			contentRect = { nextLinePos(), size };
+			advanceLine(contentRect, window.sameLine);
+		}
+
+		// IDが付いていれば位置を記録する (子領域の中は座標系が違うので除く)
+		if (m_nextItemId && m_childStack.empty())
+		{
+			m_nextPositions.add(*m_nextItemId, contentRect);
+		}
+		m_nextItemId = none;
+
+		return toLocalRect(contentRect);
+	}
+
+	void WindowImpl::advanceLine(const RectF& contentRect, bool sameLine)
+	{
+		RectF lineRect = sameLine ? m_lineRect : RectF{ contentRect.pos, 0, 0 };
+		window.sameLine = false;
+
+		// m_contentSizeと行の大きさを更新
+		Vec2 br = contentRect.br();
+		extendContent(contentRect);
+		lineRect.w = Max(lineRect.w, br.x - lineRect.x);
+		lineRect.h = Max(lineRect.h, br.y - lineRect.y);
+		setLineRect(lineRect);
+	}
+
+	Rect WindowImpl::placeRect(const RectF& contentRect)
+	{
+		extendContent(contentRect);
+		m_nextItemId = none;
+		return toLocalRect(contentRect);
+	}
+
+	RectF WindowImpl::childViewport() const
+	{
+		assert(not m_childStack.empty());
+
+		auto& region = *m_childStack.back().region;
+		return {
+			Math::Floor(region.scrollBars[0].value()),
+			Math::Floor(region.scrollBars[1].value()),
+			region.viewportSize
+		};
+	}
+
+	Vec2 WindowImpl::nextLinePos() const
+	{
+		if (window.sameLine)
+		{
+			return m_lineRect.tr().movedBy(window.space, 0);
+		}
+
+		Vec2 newLinePos = m_lineRect.bl();
+		if (m_lineRect.area() > 0.0)
+		{
+			newLinePos.y += window.space;
+		}
+		return newLinePos;
+	}
+
+	Optional<double> WindowImpl::availableWidth() const
+	{
+		if (not m_layoutStack.empty())
+		{
+			return m_layoutStack.back().container.nextCellWidth();
+		}
+
+		if (not m_floatingStack.empty())
+		{
+			return Max(0.0, m_floatingStack.back().area.rightX() - nextLinePos().x);
+		}
+
+		if (not m_childStack.empty())
+		{
+			int32 childWidth = m_childStack.back().localRect.w - ScrollBar::Thickness;
+			return Max(0.0, childWidth - window.padding - nextLinePos().x);
+		}
+
+		// 自動リサイズでは幅が中身で決まる
+		if (window.flags & WindowFlag::AutoResize)
+		{
+			return none;
+		}
+
+		// スクロールバーの表示の有無で幅が振動しないよう、常にバーの分を除く
+		int32 clientWidth = m_layout->clientRect.w;
+		if (not (window.flags & WindowFlag::NoScrollbar))
+		{
+			clientWidth -= ScrollBar::Thickness;
+		}
+		return Max(0.0, clientWidth - window.padding - nextLinePos().x);
+	}
+
+	void WindowImpl::extendContent(const RectF& contentRect)
+	{
+		Vec2 br = contentRect.br();
+		m_contentSize.x = Max(m_contentSize.x, br.x);
+		m_contentSize.y = Max(m_contentSize.y, br.y);
+	}
+
+	void WindowImpl::pushDrawItem(DrawItem item)
+	{
+		if (not m_childStack.empty())
+		{
+			item.clip = m_childStack.back().clipIndex;
+		}
+		m_controls.push_back(std::move(item));
+	}
+
+	Optional<size_t> WindowImpl::findWheelTarget() const
+	{
+		auto cursor = m_input->getCursorPos(*this);
+		if (not cursor)
+		{
+			return none;
+		}
+
+		// 入れ子のときは後に開始された内側の子領域を優先する
+		Optional<size_t> target;
+		size_t targetOrder = 0;
+		for (auto& [id, region] : m_children)
+		{
+			if (region.scrollable() &&
+				region.visibleRect.contains(*cursor) &&
+				(not target || region.order > targetOrder))
+			{
+				target = id;
+				targetOrder = region.order;
+			}
+		}
+		return target;
+	}
+
+	void WindowImpl::updateChildLayout(ChildRegion& region, Size size)
+	{
+		bool hbar = region.contentSize.x > size.x;
+		bool vbar = region.contentSize.y > size.y;
+		if (hbar)
+		{
+			vbar |= region.contentSize.y > size.y - ScrollBar::Thickness;
+		}
+		if (vbar)
+		{
+			hbar |= region.contentSize.x > size.x - ScrollBar::Thickness;
+		}
+
+		region.viewportSize = {
+			size.x - (vbar ? ScrollBar::Thickness : 0),
+			size.y - (hbar ? ScrollBar::Thickness : 0)
+		};
+
+		region.scrollBars[0].updateLayout({
+			0,
+			size.y - ScrollBar::Thickness,
+			size.x - ScrollBar::Thickness,
+			ScrollBar::Thickness
+		});
+		region.scrollBars[1].updateLayout({
+			size.x - ScrollBar::Thickness,
+			0,
+			ScrollBar::Thickness,
+			size.y - ScrollBar::Thickness
+		});
+
+		region.scrollBars[0].updateConstraints(0.0, region.contentSize.x + (vbar ? ScrollBar::Thickness : 0), region.viewportSize.x);
+		region.scrollBars[1].updateConstraints(0.0, region.contentSize.y + (hbar ? ScrollBar::Thickness : 0), region.viewportSize.y);
+	}
+
+	void WindowImpl::beginChild(size_t id, SizeF size)
+	{
+		if (size.x <= 0.0)
+		{
+			size.x = availableWidth().value_or(0.0);
+		}
+
+		// 親の中では子領域全体を1つのコントロールとして配置する
+		setNextItemId(id);
+		Rect localRect = pushRect(size);
+
+		auto& region = m_children[id];
+		region.used = true;
+		region.scope.nextIdx = 0;
+
+		updateChildLayout(region, localRect.size);
+
+		Rect clipRect{ localRect.pos, region.viewportSize };
+		if (not m_childStack.empty())
+		{
+			clipRect = IntersectRect(clipRect, m_clipRects[m_childStack.back().clipIndex]);
+		}
+
+		if (not m_measuring)
+		{
+			Optional<Vec2> cursor = getLocalCursorPos();
+			if (not m_childStack.empty() &&
+				cursor &&
+				not m_clipRects[m_childStack.back().clipIndex].contains(*cursor))
+			{
+				cursor = none;
+			}
+
+			for (auto& scrollBar : region.scrollBars)
+			{
+				scrollBar.update(cursor.map([&](Vec2 v) { return v.movedBy(-localRect.pos); }));
+			}
+
+			if (m_wheelTarget == id)
+			{
+				region.scrollBars[0].scroll(Mouse::WheelH() * window.font.height() * Config::ScrollSpeed);
+				region.scrollBars[1].scroll(Mouse::Wheel() * window.font.height() * Config::ScrollSpeed);
+			}
+
+			region.visibleRect = clipRect.movedBy(m_layout->contentRect.pos);
+			region.order = m_childOrder++;
+		}
+
+		m_clipRects.push_back(clipRect);
+		m_childStack.push_back(ActiveChild{
+			.region = &region,
+			.localRect = localRect,
+			.clipIndex = m_clipRects.size() - 1,
+			.lineRect = m_lineRect,
+			.sameLine = window.sameLine,
+			.contentOrigin = m_contentOrigin,
+			.contentSize = m_contentSize,
+			.layoutStack = std::move(m_layoutStack),
+			.layoutScope = m_layoutScope
+		});
+		m_scopeStack.push_back(ActiveScope{ .scope = &region.scope });
+		m_layoutScope = id;
+
+		// 子領域のコンテンツ座標に切り替える
+		const Vec2 scroll{
+			Math::Floor(region.scrollBars[0].value()),
+			Math::Floor(region.scrollBars[1].value())
+		};
+		m_contentOrigin = scroll - localRect.pos;
+		m_contentSize = { 0, 0 };
+		m_layoutStack.clear();
+		setLineRect({ window.padding, window.padding, 0, 0 });
+		window.sameLine = false;
+	}
+
+	void WindowImpl::endChild()
+	{
+		assert(not m_childStack.empty());
+
+		while (not m_layoutStack.empty())
+		{
+			endLayout(m_layoutStack.back().container.type());
+		}
+		endOpenSections();
+
+		ActiveChild child = std::move(m_childStack.back());
+		m_childStack.pop_back();
+		m_scopeStack.pop_back();
+
+		auto& region = *child.region;
+		region.scope.controls.resize(region.scope.nextIdx);
+		if (region.scope.nextIdx > 0)
+		{
+			m_contentSize += { window.padding, window.padding };
+		}
+		region.contentSize = m_contentSize;
+
+		// 親の状態に戻す
+		setLineRect(child.lineRect);
+		window.sameLine = child.sameLine;
+		m_contentOrigin = child.contentOrigin;
+		m_contentSize = child.contentSize;
+		m_layoutStack = std::move(child.layoutStack);
+		m_layoutScope = child.layoutScope;
+
+		if (not m_measuring)
+		{
+			pushDrawItem({ .child = &region, .childRect = child.localRect });
+		}
+	}
+
+	bool WindowImpl::childScrolledToEnd() const
+	{
+		assert(not m_childStack.empty());
+
+		return m_childStack.back().region->scrollBars[1].atEnd();
+	}
+
+	void WindowImpl::scrollChildToEnd(double contentHeight)
+	{
+		assert(not m_childStack.empty());
+
+		auto& child = m_childStack.back();
+		auto& region = *child.region;
+
+		// 今回追加された分とendChild()で足される余白を先に反映する
+		region.contentSize.y = Max(region.contentSize.y, contentHeight + window.padding);
+		updateChildLayout(region, child.localRect.size);
+
+		auto& vbar = region.scrollBars[1];
+		vbar.moveTo(vbar.maximum());
+
+		applyChildScroll();
+	}
+
+	void WindowImpl::scrollChildToShow(const RectF& rect, SizeF contentSize)
+	{
+		assert(not m_childStack.empty());
+
+		auto& child = m_childStack.back();
+		auto& region = *child.region;
+
+		// 今回の内容の大きさとendChild()で足される余白を先に反映する
+		region.contentSize.x = Max(region.contentSize.x, contentSize.x + window.padding);
+		region.contentSize.y = Max(region.contentSize.y, contentSize.y + window.padding);
+		updateChildLayout(region, child.localRect.size);
+
+		const std::array<std::pair<double, double>, 2> ranges{ {
+			{ rect.x, rect.w },
+			{ rect.y, rect.h }
+		} };
+		for (size_t i = 0; i < 2; i++)
+		{
+			auto& bar = region.scrollBars[i];
+			const auto [pos, size] = ranges[i];
+			if (pos < bar.value())
+			{
+				bar.moveTo(pos);
+			}
+			else if (pos + size > bar.value() + bar.viewportSize())
+			{
+				bar.moveTo(pos + size - bar.viewportSize());
+			}
+		}
+
+		applyChildScroll();
+	}
+
+	void WindowImpl::applyChildScroll()
+	{
+		auto& child = m_childStack.back();
+		auto& region = *child.region;
+
+		// スクロールバーが現れて表示領域が変わることがある
+		Rect clipRect{ child.localRect.pos, region.viewportSize };
+		if (m_childStack.size() >= 2)
+		{
+			clipRect = IntersectRect(clipRect, m_clipRects[m_childStack[m_childStack.size() - 2].clipIndex]);
+		}
+		m_clipRects[child.clipIndex] = clipRect;
+
+		m_contentOrigin = Vec2{
+			Math::Floor(region.scrollBars[0].value()),
+			Math::Floor(region.scrollBars[1].value())
+		} - child.localRect.pos;
+	}
+
+	void WindowImpl::beginFloating(size_t id, const RectF& area)
+	{
+		auto& scope = m_sectionScopes[id];
+		scope.used = true;
+		scope.nextIdx = 0;
+
+		m_floatingStack.push_back(ActiveFloating{
+			.area = area,
+			.lineRect = m_lineRect,
+			.sameLine = window.sameLine,
+			.contentSize = m_contentSize,
+			.layoutStack = std::move(m_layoutStack),
+			.layoutScope = m_layoutScope
+		});
+		m_scopeStack.push_back(ActiveScope{ .scope = &scope });
+		m_layoutScope = id;
+
+		// 左上からの外接矩形を測るため、内容の大きさを左上から数え直す
+		m_contentSize = area.pos;
+		m_layoutStack.clear();
+		setLineRect({ area.pos, 0, 0 });
+		window.sameLine = false;
+	}
+
+	RectF WindowImpl::endFloating()
+	{
+		assert(not m_floatingStack.empty());
+
+		while (not m_layoutStack.empty())
+		{
+			endLayout(m_layoutStack.back().container.type());
+		}
+		endOpenSections();
+
+		ActiveFloating floating = std::move(m_floatingStack.back());
+		m_floatingStack.pop_back();
+
+		auto& scope = *m_scopeStack.back().scope;
+		scope.controls.resize(scope.nextIdx);
+		m_scopeStack.pop_back();
+
+		const RectF bounds{ floating.area.pos, m_contentSize - floating.area.pos };
+
+		setLineRect(floating.lineRect);
+		window.sameLine = floating.sameLine;
+		m_contentSize = floating.contentSize;
+		m_layoutStack = std::move(floating.layoutStack);
+		m_layoutScope = floating.layoutScope;
+
+		return bounds;
+	}
+
+	void WindowImpl::beginLayout(LayoutType type, size_t id, const Array<LayoutTrack>& tracks, Alignment crossAlign)
+	{
+		// コンテナ自体は位置を記録しないので、付いていたIDはここで消費する
+		m_nextItemId = none;
+
+		// 同じIDでも親のコンテナや子領域が違えば別のキャッシュを使う
+		s3d::detail::HashCombine(id, m_layoutStack.empty() ? m_layoutScope : m_layoutStack.back().id);
+
+		// 一度テンプレートと異なる結果になったコンテナは自分のキャッシュを使う
+		auto privateItr = m_layoutCaches.find(id);
+		auto& cache = m_template && privateItr == m_layoutCaches.end()
+			? m_template->layoutCaches[id]
+			: m_layoutCaches[id];
+		cache.used = true;
+
+		Vec2 origin;
+		Optional<double> availableWidth = this->availableWidth();
+		Optional<size_t> parentIndex;
+		const bool sameLine = window.sameLine;
+
+		if (m_layoutStack.empty())
+		{
+			// 子が行送りの状態を変えるので、配置した位置をここで決めておく
+			origin = nextLinePos();
+			window.sameLine = false;
+		}
+		else
+		{
+			// 入れ子のコンテナは前回の大きさで親に配置してもらう
+			auto& parent = m_layoutStack.back().container;
+			parentIndex = parent.nextIndex();
+			origin = parent.place(cache.size).pos;
+		}
+
+		m_layoutStack.push_back(ActiveLayout{
+			.container = LayoutContainer{ type, tracks, crossAlign, static_cast<double>(window.space), origin, availableWidth, cache },
+			.parentIndex = parentIndex,
+			.sameLine = sameLine,
+			.id = id,
+			.cache = &cache
+		});
+	}
+
+	void WindowImpl::endLayout([[maybe_unused]] LayoutType type)
+	{
+		assert(not m_layoutStack.empty());
+		assert(m_layoutStack.back().container.type() == type);
+
+		ActiveLayout layout = std::move(m_layoutStack.back());
+		m_layoutStack.pop_back();
+
+		// 共有しているキャッシュが他のウィンドウで解決済みなら、上書きせずに自分のキャッシュに分ける
+		if (layout.container.needsSolve() &&
+			layout.cache->solvedBy != 0 &&
+			layout.cache->solvedBy != m_randomId)
+		{
+			layout.cache = &m_layoutCaches[layout.id];
+			layout.cache->used = true;
+			layout.container.rebind(*layout.cache);
+		}
+
+		bool resolved;
+		SizeF size = layout.container.finish(resolved);
+		m_layoutResolved |= resolved;
+		if (resolved && m_template)
+		{
+			layout.cache->solvedBy = m_randomId;
+		}
+
+		if (layout.parentIndex)
+		{
+			m_layoutStack.back().container.resize(*layout.parentIndex, size);
+			extendContent({ layout.container.origin(), size });
+		}
+		else
+		{
+			// 開始したときの位置にそのまま確保する
+			advanceLine({ layout.container.origin(), size }, layout.sameLine);
+		}
+	}
+
+	RectF WindowImpl::contentViewport() const
+	{
+		return { m_contentOrigin, m_layout->contentRect.size };
+	}
+
+	Rect WindowImpl::toLocalRect(const RectF& contentRect) const
+	{
+		// 表示領域から十分に離れたコントロールは座標を丸めてint32に収める
+		return {
+			static_cast<int32>(Clamp(contentRect.x - m_contentOrigin.x, -Config::MaxLocalCoord, Config::MaxLocalCoord)),
+			static_cast<int32>(Clamp(contentRect.y - m_contentOrigin.y, -Config::MaxLocalCoord, Config::MaxLocalCoord)),
+			static_cast<int32>(Min(contentRect.w, Config::MaxLocalCoord)),
+			static_cast<int32>(Min(contentRect.h, Config::MaxLocalCoord))
+		};
+	}
+
+	void WindowImpl::setLineRect(const RectF& lineRect)
+	{
+		m_lineRect = lineRect;
+		window.lineRect = {
+			static_cast<int32>(Clamp(lineRect.x, -Config::MaxLocalCoord, Config::MaxLocalCoord)),
+			static_cast<int32>(Clamp(lineRect.y, -Config::MaxLocalCoord, Config::MaxLocalCoord)),
+			static_cast<int32>(Min(lineRect.w, Config::MaxLocalCoord)),
+			static_cast<int32>(Min(lineRect.h, Config::MaxLocalCoord))
+		};
+	}
+
+	void WindowImpl::setPos(Vec2 pos, Vec2 offset)
+	{
+		m_placedByCode = true;
+		m_nextPos = NextPosition{
+			pos, offset
+		};
+	}
+
+	void WindowImpl::setSize(Size size)
+	{
+		m_placedByCode = true;
+		m_nextSize = NextSize{
+			size
+		};
+	}
+
+	void WindowImpl::setTemplate(std::shared_ptr<WindowTemplate> windowTemplate)
+	{
+		if (m_template == windowTemplate)
+		{
+			return;
+		}
+
+		// 別のテンプレートの結果は使えないので自分のキャッシュも捨てる
+		m_template = std::move(windowTemplate);
+		m_layoutCaches.clear();
+		m_captions.clear();
+	}
+
+	const Caption& WindowImpl::caption(const StringView text)
+	{
+		auto& captions = m_template ? m_template->captions : m_captions;
+
+		size_t key = text.hash();
+		s3d::detail::HashCombine(key, window.font.id().value());
+
+		auto& caption = captions[key];
+		if (not caption.text ||
+			caption.text->text != text ||
+			caption.text->font.id() != window.font.id())
+		{
+			caption.text = std::make_shared<const DrawableText>(window.font(text));
+			caption.size = caption.text->region().size.asPoint();
+		}
+		caption.used = true;
+		return caption;
+	}
+
+	// WindowIndex
+
+	void WindowIndex::update(WindowImpl& window, WindowLayer layer)
+	{
+		const Rect bounds = window.hitBounds();
+		const uint64 zKey = (static_cast<uint64>(layer) << 56) | window.zOrder;
+
+		auto itr = m_windows.find(&window);
+		if (itr != m_windows.end())
+		{
+			if (itr->second.bounds == bounds &&
+				itr->second.zKey == zKey)
+			{
+				return;
+			}
+			remove(window);
+		}
+
+		if (bounds.w <= 0 || bounds.h <= 0)
+		{
+			return;
+		}
+
+		const auto [minCell, maxCell] = CellRange(bounds);
+		const bool large = static_cast<int64>(maxCell.x - minCell.x + 1) * (maxCell.y - minCell.y + 1) > MaxCellsPerWindow;
+		const Entry entry{ &window, zKey, bounds };
+
+		if (large)
+		{
+			Insert(m_largeWindows, entry);
+		}
+		else
+		{
+			for (int32 y = minCell.y; y <= maxCell.y; y++)
+			{
+				for (int32 x = minCell.x; x <= maxCell.x; x++)
+				{
+					Insert(m_cells[CellKey(x, y)], entry);
+				}
+			}
+		}
+
+		m_windows.emplace(&window, IndexedWindow{ bounds, zKey, large });
+	}
+
+	void WindowIndex::remove(const WindowImpl& window)
+	{
+		auto itr = m_windows.find(&window);
+		if (itr == m_windows.end())
+		{
+			return;
+		}
+
+		const auto& indexed = itr->second;
+		if (indexed.large)
+		{
+			Erase(m_largeWindows, &window);
+		}
+		else
+		{
+			const auto [minCell, maxCell] = CellRange(indexed.bounds);
+			for (int32 y = minCell.y; y <= maxCell.y; y++)
+			{
+				for (int32 x = minCell.x; x <= maxCell.x; x++)
+				{
+					auto cell = m_cells.find(CellKey(x, y));
+					Erase(cell->second, &window);
+					if (cell->second.empty())
+					{
+						m_cells.erase(cell);
+					}
+				}
+			}
+		}
+
+		m_windows.erase(itr);
+	}
+
+	WindowImpl* WindowIndex::hitTest(Vec2 pos) const
+	{
+		const Point point = pos.asPoint();
+		const Entry* result = nullptr;
+
+		// 各リストは手前から並んでいるので最初に当たったものだけを比べる
+		auto find = [&](const Array<Entry>& entries) {
+			for (auto& entry : entries)
+			{
+				if (result && entry.zKey < result->zKey)
+				{
+					return;
+				}
+				if (entry.bounds.contains(point) && entry.window->hitTest(pos))
+				{
+					result = &entry;
+					return;
+				}
+			}
+		};
+
+		auto cell = m_cells.find(CellKey(FloorDiv(point.x, CellSize), FloorDiv(point.y, CellSize)));
+		if (cell != m_cells.end())
+		{
+			find(cell->second);
+		}
+		find(m_largeWindows);
+
+		return result ? result->window : nullptr;
+	}
+
+	// Layer
+
+	void Layer::frameBegin(InputContext& input)
+	{
+		m_input = &input;
+
+		std::list<String> front;
+		for (auto itr = m_windowOrder.rbegin(); itr != m_windowOrder.rend();)
+		{
+			auto& impl = *m_container.at(*itr);
+
+			impl.frameBegin(*m_input);
+
+			if (impl.window.requestMoveToFront)
+			{
+				front.emplace_back(std::move(*itr));
+				m_windowOrder.erase(--(itr.base()));
+				impl.window.requestMoveToFront = false;
+			}
+			else
+			{
+				itr++;
+			}
+		}
+		for (auto& id : front)
+		{
+			m_container.at(id)->zOrder = m_nextZOrder++;
+		}
+		m_windowOrder.splice(m_windowOrder.end(), std::move(front));
+	}
+
+	void Layer::frameEnd(WindowIndex& index)
+	{
+		deleteUnusedWindow(index);
+		for (auto& id : m_windowOrder)
+		{
+			auto& window = *m_container.at(id);
+			window.frameEnd();
+			index.update(window, type);
+		}
+	}
+
+	WindowImpl& Layer::defineWindow(const StringView id, const StringView name, const Font& font)
+	{
+		auto itr = m_container.find(id);
+
+		if (itr == m_container.end())
+		{
+			itr = createWindow(id, name, font);
+		}
+
+		auto& impl = *itr->second;
+		impl.window.defined = true;
+		return impl;
+	}
+
+	Layer::container_type::iterator Layer::createWindow(const StringView id, const StringView name, const Font& font)
+	{
+		auto [itr, _] = m_container.emplace(
+				id,
+				std::make_unique<WindowImpl>(*m_input, id, name, font)
+		);
+		m_windowOrder.emplace_back(String{ id });
+		itr->second->zOrder = m_nextZOrder++;
+
+		// Console << U"[" << ToString(type) << U"][+] " << itr->first;
+
+		return itr;
+	}
+
+	void Layer::deleteUnusedWindow(WindowIndex& index)
+	{
+		m_windowOrder.remove_if([&, this](const String& id) {
+			auto itr = m_container.find(id);
+
+			if (itr->second->window.defined)
+			{
+				return false;
+			}
+
+			if (m_input->hoveredItemId() == itr->second->randomId())
+			{
+				m_input->reset();
+			}
+
+			index.remove(*itr->second);
+			m_container.erase(itr);
+
+			// Console << U"[" << ToString(type) << U"][-] " << id;
+			return true;
+		});
+	}
+
+	// GUIImpl
+
+	void GUIImpl::frameBegin()
+	{
+		m_input.frameBegin();
+
+		// カーソルの下で一番手前のウィンドウを先に決めておく
+		if (not m_input.m_captured)
+		{
+			if (auto window = m_windowIndex.hitTest(m_input.m_cursorPos))
+			{
+				m_input.m_hoveredItemId = window->randomId();
+			}
+		}
+
+		for (auto layerItr = m_layers.rbegin(); layerItr != m_layers.rend(); layerItr++)
+		{
+			layerItr->frameBegin(m_input);
+		}
+	}
+
+	void GUIImpl::frameEnd()
+	{
+		for (auto& layer : m_layers)
+		{
+			layer.frameEnd(m_windowIndex);
+		}
+
+		// 共有している結果は全てのウィンドウが終わってから整理する
+		for (auto itr = m_templates.begin(); itr != m_templates.end();)
+		{
+			auto& windowTemplate = *itr->second;
+			if (itr->second.use_count() == 1)
+			{
+				itr = m_templates.erase(itr);
+				continue;
+			}
+
+			for (auto& [id, cache] : windowTemplate.layoutCaches)
+			{
+				cache.solvedBy = 0;
+			}
+			EraseUnused(windowTemplate.layoutCaches);
+			EraseUnused(windowTemplate.captions);
+			itr++;
+		}
+		// Print << m_input.m_hoveredItemId << (m_input.m_captured ? U"🔒" : U"");
+	}
+
+	Layer& GUIImpl::getLayer(WindowLayer layer)
+	{
+		return m_layers[static_cast<int32>(layer)];
+	}
+
+	WindowImpl& GUIImpl::defineWindow(WindowLayer layer, const StringView id, const StringView name)
+	{
+		return getLayer(layer).defineWindow(id, name, font);
+	}
+
+	std::shared_ptr<detail::WindowTemplate> GUIImpl::getTemplate(const StringView id)
+	{
+		auto itr = m_templates.find(id);
+		if (itr == m_templates.end())
+		{
+			itr = m_templates.emplace(id, std::make_shared<WindowTemplate>()).first;
+		}
+		return itr->second;
+	}
+
+	// GUIManager
+
+	GUIManager::GUIManager()
+		: m_impl(std::make_unique<GUIImpl>())
+	{
+		m_defaultWindow = &m_impl
+			->defineWindow(WindowLayer::Background, U"DefaultWindow", U"DefaultWindow");
+		m_defaultWindow->window.flags =
+			WindowFlag::NoTitlebar
+			| WindowFlag::NoResize
+			| WindowFlag::NoMove
+			| WindowFlag::NoBackground;
+	}
+
+	const Font& GUIManager::getFont() const
+	{
+		return m_impl->font;
+	}
+
+	void GUIManager::setFont(const Font& newFont)
+	{
+		m_impl->font = newFont;
+	}
+
+	void GUIManager::frameBegin()
+	{
+		m_stack.clear();
+		m_stack.push_back(m_defaultWindow);
+
+		m_impl->frameBegin();
+
+		// DefaultWindowの定義(延命)
+		m_defaultWindow = &m_impl
+			->defineWindow(WindowLayer::Background, U"DefaultWindow", U"DefaultWindow");
+	}
+
+	void GUIManager::frameEnd()
+	{
+		// DefaultWindowの位置&座標を更新
+		m_defaultWindow->setPos({ 0, 0 }, { 0, 0 });
+		m_defaultWindow->setSize(Scene::Size());
+
+		m_impl->frameEnd();
+
+		//for (auto [idx, layer] : Indexed(m_impl->layers()))
+		//{
+		//	const HSV color{ ((double)idx / 4 * 360), 0.8, 1.0 };
+		//	for (auto& [id, impl] : layer.container())
+		//	{
+		//		auto& window = impl->window;
+
+		//		window.rect.drawFrame(1, 0, color);
+		//		Line{ window.rect.tl(), window.rect.br() }.draw(color);
+		//		Line{ window.rect.bl(), window.rect.tr() }.draw(color);
+
+		//		SimpleGUI::GetFont()(U"{}:{}"_fmt(id, window.displayName))
+		//			.draw(Arg::bottomLeft = window.rect.tl(), color);
+		//	}
+		//}
+	}
+
+	bool GUIManager::windowBegin(const StringView name, WindowFlag flags)
+	{
+		return windowBegin(name, U"", flags);
+	}
+
+	bool GUIManager::windowBegin(const StringView name, const StringView templateId, WindowFlag flags)
+	{
+		WindowLayer layer = flags & WindowFlag::AlwaysForeground
+			? WindowLayer::Foreground
+			: WindowLayer::Normal;
+		auto windowImpl = &m_impl
+			->defineWindow(layer, name, name);
+		windowImpl->window.flags = flags;
+		windowImpl->setTemplate(templateId.isEmpty()
+			? nullptr
+			: m_impl->getTemplate(templateId));
+		m_stack.push_back(windowImpl);
+		return windowImpl->beginContent();
+	}
+
+	void GUIManager::windowEnd()
+	{
+		m_stack.pop_back();
+	}
+
+	bool GUIManager::beginMeasure()
+	{
+		return getCurrentWindowImpl().beginMeasure();
+	}
+
+	void GUIManager::endMeasure()
+	{
+		getCurrentWindowImpl().endMeasure();
+	}
+
+	void GUIManager::setWindowSize(Size size)
+	{
+		getCurrentWindowImpl().setSize(size);
+	}
+
+	void GUIManager::setWindowDisplayName(const StringView name)
+	{
+		getCurrentWindowImpl().window.displayName = name;
+	}
+
+	const Window& GUIManager::getDefaultWindow() const
+	{
+		return m_defaultWindow->window;
+	}
+
+	const Window& GUIManager::getCurrentWindow() const
+	{
+		return m_stack.back()->window;
+	}
+
+	RectF GUIManager::getContentViewport() const
+	{
+		return m_stack.back()->contentViewport();
+	}
+
+	void GUIManager::sameLine()
+	{
+		getCurrentWindowImpl().window.sameLine = true;
+	}
+
+	void GUIManager::setNextItemId(const StringView id)
+	{
+		getCurrentWindowImpl().setNextItemId(id.hash());
+	}
+
+	void GUIManager::scrollTo(const StringView id)
+	{
+		getCurrentWindowImpl().scrollTo(id.hash());
+	}
+
+	void GUIManager::setWindowPos(Vec2 pos, Vec2 offset)
+	{
+		getCurrentWindowImpl().setPos(pos, offset);
+	}
+
+	GUIManager::~GUIManager()
+	{ }
+
+	// Dummy
+
+	void GUIManager::dummy(SizeF size)
+	{
+		getCurrentWindowImpl()
+			.pushRect(size);
+	}
+
+	// Layout
+
+	void GUIManager::beginRow(const StringView id, const Array<LayoutTrack>& tracks, Alignment crossAlign)
+	{
+		getCurrentWindowImpl()
+			.beginLayout(LayoutType::Row, id.hash(), tracks, crossAlign);
+	}
+
+	void GUIManager::endRow()
+	{
+		getCurrentWindowImpl()
+			.endLayout(LayoutType::Row);
+	}
+
+	void GUIManager::beginColumn(const StringView id, const Array<LayoutTrack>& tracks, Alignment crossAlign)
+	{
+		getCurrentWindowImpl()
+			.beginLayout(LayoutType::Column, id.hash(), tracks, crossAlign);
+	}
+
+	void GUIManager::endColumn()
+	{
+		getCurrentWindowImpl()
+			.endLayout(LayoutType::Column);
+	}
+
+	void GUIManager::beginGrid(const StringView id, const Array<LayoutTrack>& columns, Alignment crossAlign)
+	{
+		getCurrentWindowImpl()
+			.beginLayout(LayoutType::Grid, id.hash(), columns, crossAlign);
+	}
+
+	void GUIManager::endGrid()
+	{
+		getCurrentWindowImpl()
+			.endLayout(LayoutType::Grid);
+	}
+
+	void GUIManager::beginChild(const StringView id, SizeF size)
+	{
+		getCurrentWindowImpl()
+			.beginChild(id.hash(), size);
+	}
+
+	void GUIManager::endChild()
+	{
+		getCurrentWindowImpl()
+			.endChild();
+	}
+
+	// Button
+
+	class Button : public IControl
+	{
+	public:
+
+		String label;
+
+		bool clicked() const
+		{
+			return m_clicked;
+		}
+
+	private:
+
+		Rect m_rect;
+
+		bool m_mouseOver = false;
+
+		bool m_clicked = false;
+
+		Size computeSize() const override
+		{
+			return SimpleGUI::ButtonRegion(label, { 0, 0 }).size.asPoint();
+		}
+
+		void update(Rect rect, Optional<Vec2> cursorPos) override
+		{
+			m_rect = rect;
+
+			m_mouseOver = cursorPos && rect.contains(*cursorPos);
+			m_clicked = m_mouseOver && MouseL.down();
+		}
+
+		void draw() const
+		{
+			Mat3x2 cursorMat = m_mouseOver
+				? Mat3x2::Translate(Cursor::PosF())
+				: Mat3x2::Translate(Cursor::PosF() + Vec2{ 1, 1 });
+			const Transformer2D _{ Mat3x2::Translate(m_rect.pos), cursorMat, Transformer2D::Target::PushLocal };
+			[[maybe_unused]]
+			bool unused = SimpleGUI::Button(label, { 0, 0 }, m_rect.w);
+		}
+	};
+
+	bool GUIManager::button(StringView label)
+	{
+		auto& window = getCurrentWindowImpl();
+
+		auto& button = window.nextStatelessControl<Button>();
+		button.label = label;
+
+		return window.updateControl(button)
+			&& button.clicked();
+	}
+
+	// SimpleTextBox
+
+	class SimpleTextBox : public IControl
+	{
+	public:
+
+		double width = 200;
+
+		Optional<size_t> maxChars = unspecified;
+
+		TextEditState& state()
+		{
+			return m_state;
+		}
+
+	private:
+
+		mutable TextEditState m_state;
+
+		Vec2 m_pos;
+
+		double m_renderWidth;
+
+		bool m_mouseOver = false;
+
+		Size computeSize() const override
+		{
+			return SimpleGUI::TextBoxRegion(m_pos, width).size.asPoint();
+		}
+
+		void update(Rect rect, Optional<Vec2> cursorPos) override
+		{
+			m_pos = rect.pos;
+			m_renderWidth = rect.w;
+			m_mouseOver = cursorPos && rect.contains(*cursorPos);
+		}
+
+		void draw() const
+		{
+			Mat3x2 cursorMat = m_mouseOver
+				? Mat3x2::Translate(Cursor::PosF())
+				: Mat3x2::Translate(Cursor::PosF() + Vec2{ 1, 1 });
+			const Transformer2D _{ Mat3x2::Translate(m_pos), cursorMat, Transformer2D::Target::PushLocal };
+			SimpleGUI::TextBox(m_state, { 0, 0 }, m_renderWidth, maxChars);
+		}
+	};
+
+	TextEditState& GUIManager::simpleTextBox(const StringView id, double width, const Optional<size_t>& maxChars)
+	{
+		auto& window = getCurrentWindowImpl();
+
+		auto& textBox = window.nextStatefulControl<SimpleTextBox>(id.hash());
+		textBox.width = width;
+		textBox.maxChars = maxChars;
+
+		window.updateControl(textBox);
+		return textBox.state();
+	}
+
+	// Label
+
+	class Label : public IControl
+	{
+	public:
+
+		DrawableText text;
+
+		ColorF color;
+
+	private:
+
+		Vec2 m_pos;
+
+		Size computeSize() const override
+		{
+			return text.region().size.asPoint();
+		}
+
+		void update(Rect rect, Optional<Vec2>) override
+		{
+			m_pos = rect.pos;
+		}
+
+		void draw() const
+		{
+			text.draw(m_pos, color);
+		}
+	};
+
+	void GUIManager::label(const StringView text, ColorF color)
+	{
+		auto& window = getCurrentWindowImpl();
+		auto& label = window.nextStatelessControl<Label>();
+
+		label.text = window.window.font(text);
+		label.color = color;
+
+		window.updateControl(label);
+	}
+
+	// 整形済みの文字列を共有して表示するラベル
+	class CaptionLabel : public IControl
+	{
+	public:
+
+		std::shared_ptr<const DrawableText> text;
+
+		Size size{ 0, 0 };
+
+		ColorF color;
+
+	private:
+
+		Vec2 m_pos;
+
+		Size computeSize() const override
+		{
+			return size;
+		}
+
+		void update(Rect rect, Optional<Vec2>) override
+		{
+			m_pos = rect.pos;
+		}
+
+		void draw() const
+		{
+			text->draw(m_pos, color);
+		}
+	};
+
+	void GUIManager::caption(const StringView text, ColorF color)
+	{
+		auto& window = getCurrentWindowImpl();
+		auto& label = window.nextStatelessControl<CaptionLabel>();
+
+		auto& caption = window.caption(text);
+		label.text = caption.text;
+		label.size = caption.size;
+		label.color = color;
+
+		window.updateControl(label);
+	}
+
+	// WrappedLabel
+
+	class WrappedLabel : public IControl
+	{
+	public:
+
+		ColorF color;
+
+		void setText(const Font& font, const StringView text, const Optional<double>& width)
+		{
+			// 文字列・フォント・幅が前回と同じなら改行位置を再利用
+			if (m_font.id() == font.id() &&
+				m_width == width &&
+				m_text == text)
+			{
+				return;
+			}
+
+			m_font = font;
+			m_text = text;
+			m_width = width;
+			breakLines();
+		}
+
+	private:
+
+		Font m_font;
+
+		String m_text;
+
+		Optional<double> m_width;
+
+		Array<DrawableText> m_lines;
+
+		Size m_size{ 0, 0 };
+
+		Vec2 m_pos;
+
+		Size computeSize() const override
+		{
+			return m_size;
+		}
+
+		void update(Rect rect, Optional<Vec2>) override
+		{
+			m_pos = rect.pos;
+		}
+
+		void draw() const override
+		{
+			const int32 lineHeight = m_font.height();
+			for (auto [idx, line] : Indexed(m_lines))
+			{
+				line.draw(m_pos.movedBy(0, lineHeight * static_cast<double>(idx)), color);
+			}
+		}
+
+		void breakLines()
+		{
+			const Array<double> advances = m_font.getXAdvances(m_text);
+			const size_t length = m_text.size();
+			const double maxWidth = m_width.value_or(std::numeric_limits<double>::infinity());
+
+			m_lines.clear();
+			double textWidth = 0.0;
+
+			auto pushLine = [&](size_t begin, size_t end)
+			{
+				// 行末の空白は幅に含めない
+				while (end > begin && IsSpace(m_text[end - 1]))
+				{
+					end--;
+				}
+				double lineWidth = 0.0;
+				for (size_t i = begin; i < end; i++)
+				{
+					lineWidth += advances[i];
+				}
+				textWidth = Max(textWidth, lineWidth);
+				m_lines.push_back(m_font(m_text.substr(begin, end - begin)));
+			};
+
+			size_t lineBegin = 0;
+			size_t lastBreak = 0; // 0のとき行内に改行できる位置がない
+			double x = 0.0;
+
+			for (size_t i = 0; i < length; i++)
+			{
+				const char32 ch = m_text[i];
+
+				if (ch == U'\n')
+				{
+					pushLine(lineBegin, i);
+					lineBegin = i + 1;
+					lastBreak = 0;
+					x = 0.0;
+					continue;
+				}
+
+				if (i > lineBegin && CanBreakBefore(m_text[i - 1], ch))
+				{
+					lastBreak = i;
+				}
+
+				// 空白は行末にぶら下げる
+				if (x + advances[i] > maxWidth &&
+					i > lineBegin &&
+					not IsSpace(ch))
+				{
+					size_t breakPos = lastBreak;
+					if (breakPos <= lineBegin)
+					{
+						// 改行できる位置がないときは強制的に折り返し、行頭禁則文字は前の文字ごと追い出す
+						breakPos = i;
+						if (IsLineStartProhibited(ch) && breakPos - 1 > lineBegin)
+						{
+							breakPos--;
+						}
+					}
+
+					pushLine(lineBegin, breakPos);
+
+					lineBegin = breakPos;
+					while (lineBegin < i && IsSpace(m_text[lineBegin]))
+					{
+						lineBegin++;
+					}
+					lastBreak = 0;
+
+					x = 0.0;
+					for (size_t k = lineBegin; k < i; k++)
+					{
+						x += advances[k];
+					}
+				}
+
+				x += advances[i];
+			}
+			pushLine(lineBegin, length);
+
+			m_size = {
+				static_cast<int32>(Math::Ceil(textWidth)),
+				m_font.height() * static_cast<int32>(m_lines.size())
+			};
+		}
+
+		static bool IsSpace(char32 ch)
+		{
+			return ch == U' ' || ch == U'\t' || ch == U'\u3000';
+		}
+
+		static bool IsWide(char32 ch)
+		{
+			return
+				(U'\u2E80' <= ch && ch <= U'\u9FFF') ||
+				(U'\uAC00' <= ch && ch <= U'\uD7AF') ||
+				(U'\uF900' <= ch && ch <= U'\uFAFF') ||
+				(U'\uFF00' <= ch && ch <= U'\uFFEF') ||
+				(U'\U00020000' <= ch && ch <= U'\U0003FFFF');
+		}
+
+		// 行頭禁則文字
+		static bool IsLineStartProhibited(char32 ch)
+		{
+			constexpr StringView Chars = U"、。，．,.:;!?)]}・：；？！‼⁇⁈⁉゛゜ヽヾゝゞ々〻ー‐゠–〜～）］｝〕〉》」』】〙〗〟’”｠»ぁぃぅぇぉっゃゅょゎゕゖァィゥェォッャュョヮヵヶㇰㇱㇲㇳㇴㇵㇶㇷㇸㇹㇺㇻㇼㇽㇾㇿ";
+			return Chars.indexOf(ch) != StringView::npos;
+		}
+
+		// 行末禁則文字
+		static bool IsLineEndProhibited(char32 ch)
+		{
+			constexpr StringView Chars = U"([{（［｛〔〈《「『【〘〖〝‘“｟«";
+			return Chars.indexOf(ch) != StringView::npos;
+		}
+
+		static bool CanBreakBefore(char32 prev, char32 ch)
+		{
+			if (IsLineStartProhibited(ch) ||
+				IsLineEndProhibited(prev) ||
+				IsSpace(ch))
+			{
+				return false;
+			}
+
+			return IsSpace(prev) || IsWide(prev) || IsWide(ch);
+		}
+	};
+
+	void GUIManager::wrappedLabel(const StringView text, ColorF color)
+	{
+		auto& window = getCurrentWindowImpl();
+		auto& label = window.nextStatelessControl<WrappedLabel>();
+
+		label.setText(window.window.font, text, window.availableWidth());
+		label.color = color;
+
+		window.updateControl(label);
+	}
+
+	// CollapsingHeader
+
+	class CollapsingHeader : public IControl
+	{
+	public:
+
+		using Config = Config::CollapsingHeader;
+
+		DrawableText labelText;
+
+		// 見出しの幅 (ラベルより狭いときはラベルの幅)
+		double width = 0.0;
+
+		bool isOpen() const { return m_open; }
+
+		// このフレームで開いたときはtrue
+		bool opened() const { return m_toggled && m_open; }
+
+	private:
+
+		bool m_open = false;
+
+		bool m_toggled = false;
+
+		bool m_mouseOver = false;
+
+		Rect m_rect;
+
+		int32 arrowAreaWidth() const
+		{
+			return labelText.font.height();
+		}
+
+		Size computeSize() const override
+		{
+			Size labelSize = labelText.region().size.asPoint();
+			return {
+				Max(labelSize.x + arrowAreaWidth() + Config::Padding * 2, static_cast<int32>(width)),
+				labelSize.y + Config::Padding * 2
+			};
+		}
+
+		void update(Rect rect, Optional<Vec2> cursorPos) override
+		{
+			m_rect = rect;
+			m_mouseOver = cursorPos && rect.contains(*cursorPos);
+			m_toggled = m_mouseOver && MouseL.down();
+			m_open ^= m_toggled;
+
+			if (m_mouseOver)
+			{
+				Cursor::RequestStyle(CursorStyle::Hand);
+			}
+		}
+
+		void draw() const override
+		{
+			m_rect
+				.rounded(Config::Roundness)
+				.draw(m_mouseOver ? Config::HoveredBackgroundColor : Config::BackgroundColor);
+
+			const double arrowCenterX = m_rect.x + Config::Padding + arrowAreaWidth() * 0.5;
+			Triangle{
+				Vec2{ arrowCenterX, m_rect.centerY() },
+				arrowAreaWidth() * Config::ArrowScale * 2,
+				m_open ? 180_deg : 90_deg
+			}.draw(Config::ArrowColor);
+
+			labelText
+				.draw(Arg::leftCenter = Vec2{ m_rect.x + Config::Padding + arrowAreaWidth(), m_rect.centerY() }, Config::LabelColor);
+		}
+	};
+
+	bool GUIManager::collapsingHeader(const StringView id, const StringView label)
+	{
+		auto& window = getCurrentWindowImpl();
+
+		auto& header = window.nextStatefulControl<CollapsingHeader>(id.hash());
+		header.labelText = window.window.font(label);
+		header.width = window.availableWidth().value_or(0.0);
+
+		bool updated = window.updateControl(header);
+
+		window.beginSection(id.hash(), header.isOpen(), updated && header.opened());
+		return header.isOpen();
+	}
+
+	void GUIManager::endCollapsingHeader()
+	{
+		getCurrentWindowImpl().endSection();
+	}
+
+	// Image
+
+	class Image : public IControl
+	{
+	public:
+
+		std::variant<Texture, TextureRegion> texture;
+
+		ColorF diffuse;
+
+		Optional<SamplerState> sampler;
+
+	private:
+
+		Vec2 m_pos;
+
+		Size computeSize() const override
+		{
+			return std::visit([](const auto& tex) {
+				return tex.region(0.0, 0.0).size.asPoint();
+			}, texture);
+		}
+
+		void update(Rect rect, Optional<Vec2>) override
+		{
+			m_pos = rect.pos;
+		}
+
+		void draw() const
+		{
+			Optional<ScopedRenderStates2D> state;
+			if (sampler)
+			{
+				state.emplace(*sampler);
+			}
+
+			std::visit([this](const auto& tex) {
+				tex.draw(m_pos, diffuse);
+			}, texture);
+		}
+	};
+
+	void GUIManager::image(Texture texture, ColorF diffuse)
+	{
+		auto& window = getCurrentWindowImpl();
+		auto& image = window.nextStatelessControl<Image>();
+
+		image.texture = texture;
+		image.diffuse = diffuse;
+		image.sampler = none;
+
+		window.updateControl(image);
+	}
+
+	void GUIManager::image(TextureRegion texture, ColorF diffuse)
+	{
+		auto& window = getCurrentWindowImpl();
+		auto& image = window.nextStatelessControl<Image>();
+
+		image.texture = texture;
+		image.diffuse = diffuse;
+		image.sampler = none;
+
+		window.updateControl(image);
+	}
+
+	// CheckBox
+
+	class CheckBox : public IControl
+	{
+	public:
+
+		using Config = Config::CheckBox;
+
+		bool* ref;
+
+		DrawableText labelText;
+
+		bool valueChanged() const { return m_valueChanged; }
+
+	private:
+
+		bool m_value = false;
+
+		bool m_valueChanged = false;
+
+		RectF m_checkRect;
+
+		Vec2 m_labelLeftCenter;
+
+		Size computeSize() const override
+		{
+			Size labelSize = labelText.region().size.asPoint();
+			return { labelSize.x + checkboxSize(), labelSize.y };
+		}
+
+		void update(Rect rect, Optional<Vec2> cursorPos) override
+		{
+			m_checkRect = RectF{ Arg::leftCenter = rect.leftCenter(), static_cast<RectF::size_type::value_type>(checkboxSize()) };
+			m_labelLeftCenter = m_checkRect.rightCenter();
+			m_valueChanged = false;
+
+			if (cursorPos &&
+				rect.contains(*cursorPos))
+			{
+				Cursor::RequestStyle(CursorStyle::Hand);
+				m_valueChanged = MouseL.down();
+				*ref ^= m_valueChanged;
+			}
+
+			m_value = *ref;
+			ref = nullptr;
+		}
+
+		void draw() const override
+		{
+			m_checkRect.drawFrame(1, Palette::Black);
+			if (m_value)
+			{
+				Vec2 center = m_checkRect.center();
+				int32 size = checkboxSize();
+				drawCheckLine(m_checkRect.center(), checkboxSize() * Config::CheckLineScale);
+			}
+			labelText
+				.draw(Arg::leftCenter = m_labelLeftCenter, Palette::Black);
+		}
+
+		int32 checkboxSize() const
+		{
+			return static_cast<int32>(labelText.font.height() * Config::BoxScale);
+		}
+
+		void drawCheckLine(Vec2 center, double scale) const
+		{
+			LineString line(Arg::reserve = Config::CheckLine.size());
+			for (Vec2 p : Config::CheckLine)
+			{
+				line.push_back(center + p * scale);
+			}
+			line.draw(LineStyle::Uncapped, Config::CheckLineTickness * scale, Palette::Black);
+		}
+	};
+
+	bool GUIManager::checkbox(bool& checked, const StringView label)
+	{
+		auto& window = getCurrentWindowImpl();
+		auto& checkbox = window.nextStatelessControl<CheckBox>();
+
+		checkbox.ref = &checked;
+		checkbox.labelText = window.window.font(label);
+
+		return window.updateControl(checkbox)
+			&& checkbox.valueChanged();
+	}
+
+	// RadioButton
+
+	class RadioButton : public IControl
+	{
+	public:
+
+		using Config = Config::RadioButton;
+
+		bool selected;
+
+		DrawableText labelText;
+
+		bool clicked() const { return m_clicked; }
+
+	private:
+
+		bool m_hovered;
+
+		bool m_clicked = false;
+
+		Circle m_circle;
+
+		Vec2 m_labelLeftCenter;
+
+		Size computeSize() const override
+		{
+			Size labelSize = labelText.region().size.asPoint();
+			return { labelSize.x + circleSize() + Config::CircleMargin, labelSize.y };
+		}
+
+		void update(Rect rect, Optional<Vec2> cursorPos) override
+		{
+			m_circle = { Arg::leftCenter = rect.leftCenter(), static_cast<RectF::size_type::value_type>(circleSize()) / 2 };
+			m_labelLeftCenter = m_circle.right() + Vec2{ Config::CircleMargin, 0 };
+
+			m_hovered = cursorPos && rect.contains(*cursorPos);
+			m_clicked = m_hovered && MouseL.down();
+			selected |= m_clicked;
+
+			if (m_hovered)
+			{
+				Cursor::RequestStyle(CursorStyle::Hand);
+			}
+		}
+
+		void draw() const override
+		{
+			ColorF color, frameColor;
+			if (selected)
+			{
+				color = Config::CheckedCircleColor;
+				frameColor = Config::CheckedFrameColor;
+			}
+			else if (m_hovered)
+			{
+				color = Config::HoveredCircleColor;
+				frameColor = Config::HoveredFrameColor;
+			}
+			else
+			{
+				color = Config::CircleColor;
+				frameColor = Config::FrameColor;
+			}
+
+			m_circle
+				.draw(color)
+				.drawFrame(Config::CircleFrameThickness, frameColor);
+			if (selected)
+			{
+				Circle{ m_circle.center, m_circle.r * Config::InnerCircleScale }
+				.draw(frameColor);
+			}
+			labelText
+				.draw(Arg::leftCenter = m_labelLeftCenter, Config::LabelColor);
+		}
+
+		int32 circleSize() const
+		{
+			return static_cast<int32>(labelText.font.height() * Config::CircleScale);
+		}
+	};
+
+	bool GUIManager::radiobutton(bool selected, const StringView label)
+	{
+		auto& window = getCurrentWindowImpl();
+		auto& radioButton = window.nextStatelessControl<RadioButton>();
+
+		radioButton.selected = selected;
+		radioButton.labelText = window.window.font(label);
+
+		return window.updateControl(radioButton)
+			&& radioButton.clicked();
+	}
+
+	// Tab
+
+	class Tab : public IControl
+	{
+	public:
+
+		using Config = Config::Tab;
+
+		size_t selectedIdx = 0;
+
+		void init(const Array<String>& tabNames)
+		{
+			assert(tabNames);
+
+			m_tabs.clear();
+			m_tabs.reserve(tabNames.size());
+
+			int32 tabHeight = 0;
+			Point tabPos = { Config::FrameThickness, Config::FrameThickness };
+			auto& font = SimpleGUI::GetFont();
+			for (auto& name : tabNames)
+			{
+				auto& tab = m_tabs.emplace_back(TabItem{
+					.label = font(name)
+				});
+
+				Size labelSize = tab.label.region().size.asPoint();
+				tab.localRect.pos = tabPos;
+				tab.localRect.w = Max(labelSize.x + Config::TabR * 2, Config::TabMinWidth);
+
+				tabPos.x += tab.localRect.w
+					+ Config::FrameThickness
+					+ Config::TabSpace
+					+ Config::FrameThickness;
+
+				tabHeight = Max(tabHeight, labelSize.y);
+			}
+			for (auto& tab : m_tabs)
+			{
+				tab.localRect.h = tabHeight;
+			}
+		}
+
+	private:
+
+		struct TabItem
+		{
+			Rect localRect;
+
+			DrawableText label;
+
+			Rect globalRect;
+
+			bool mouseOver = false;
+		};
+
+		Array<TabItem> m_tabs;
+
+		Size computeSize() const override
+		{
+			return m_tabs.back().localRect.br() + Size{ Config::FrameThickness, Config::FrameThickness };
+		}
+
+		void update(Rect rect, Optional<Vec2> cursorPos) override
+		{
+			for (auto [idx, tab] : IndexedRef(m_tabs))
+			{
+				tab.globalRect = tab.localRect.movedBy(rect.pos);
+				tab.mouseOver = cursorPos && tab.globalRect.contains(*cursorPos);
+
+				if (tab.mouseOver && MouseL.down())
+				{
+					selectedIdx = idx;
+				}
+			}
+		}
+
+		void draw() const override
+		{
+			for (auto [idx, tab] : IndexedRef(m_tabs))
+			{
+				bool selected = idx == selectedIdx;
+
+				// タブ内部
+
+				if (selected)
+				{
+					tab.globalRect
+						.stretched(0, 0, Config::FrameThickness, 0)
+						.rounded(Config::TabR, Config::TabR, 0, 0)
+						.draw(Config::SelectedTabColor);
+				}
+				else
+				{
+					tab.globalRect
+						.rounded(Config::TabR, Config::TabR, 0, 0)
+						.draw(tab.mouseOver ? Config::HoveredTabColor : Config::TabColor);
+				}
+
+				// タブ枠線
+
+				LineString frame;
+				{
+					Polygon p = tab.globalRect
+						.stretched(Config::FrameThickness * 0.5, Config::FrameThickness * 0.5, 0, Config::FrameThickness * 0.5)
+						.rounded(Config::TabR + Config::FrameThickness * 0.5, Config::TabR + Config::FrameThickness * 0.5, 0, 0);
+					auto& outer = p.outer();
+					frame.reserve(outer.size());
+					frame.push_back(outer.back());
+					frame.insert(frame.cend(), outer.begin(), outer.end() - 1);
+				}
+				frame.draw(LineStyle::Uncapped, Config::FrameThickness, Config::FrameColor);
+
+				// タブ文字列
+
+				tab.label.drawAt(tab.globalRect.center(), Config::LabelColor);
+			}
+
+			// タブ下部下線
+
+			if (selectedIdx < m_tabs.size())
+			{
+				// 選択されているタブの下は空ける
+
+				auto& firstTab = m_tabs.front();
+				auto& selectedTab = m_tabs[selectedIdx];
+				auto& lastTab = m_tabs.back();
+				Rect{ firstTab.globalRect.leftX() - Config::FrameThickness, firstTab.globalRect.bottomY(), selectedTab.localRect.leftX(), Config::FrameThickness }
+				.draw(Config::FrameColor);
+				Rect{ selectedTab.globalRect.br(), lastTab.localRect.rightX() - selectedTab.localRect.rightX() + Config::FrameThickness, Config::FrameThickness }
+				.draw(Config::FrameColor);
+			}
+			else
+			{
+				// 範囲外のときは空けない
+
+				auto& firstTab = m_tabs.front();
+				auto& lastTab = m_tabs.back();
+				Rect{
+					firstTab.globalRect.leftX() - Config::FrameThickness,
+					firstTab.globalRect.bottomY(),
+					lastTab.localRect.rightX() + Config::FrameThickness,
+					Config::FrameThickness
+				}.draw(Config::FrameColor);
+			}
+		}
+	};
+
+	size_t& GUIManager::tab(const StringView id, Array<String> tabNames)
+	{
+		assert(tabNames);
+		auto& window = getCurrentWindowImpl();
+		auto& tab = window.nextStatefulControl<Tab>(id.hash());
+
+		tab.init(tabNames);
+
+		window.updateControl(tab);
+		return tab.selectedIdx;
+	}
+
+	// Table
+
+	// ブロックごとに並べ替えてから併合し、ブロックと併合の間で取り消しを確認する
+	// (並列アルゴリズムの比較関数からは抜けられないため)
+	template<class Less>
+	static bool StableSortCancellable(Array<size_t>& order, const Less& less, const std::atomic<bool>& cancel)
+	{
+		constexpr size_t BlockSize = 1 << 16;
+		const size_t count = order.size();
+
+		Array<size_t> starts;
+		for (size_t start = 0; start < count; start += BlockSize)
+		{
+			starts.push_back(start);
+		}
+		std::for_each(std::execution::par, starts.begin(), starts.end(), [&](size_t start)
+		{
+			if (not cancel)
+			{
+				std::stable_sort(order.begin() + start, order.begin() + Min(count, start + BlockSize), less);
+			}
+		});
+
+		for (size_t width = BlockSize; width < count; width *= 2)
+		{
+			if (cancel)
+			{
+				return false;
+			}
+
+			starts.clear();
+			for (size_t start = 0; start + width < count; start += width * 2)
+			{
+				starts.push_back(start);
+			}
+			std::for_each(std::execution::par, starts.begin(), starts.end(), [&](size_t start)
+			{
+				if (not cancel)
+				{
+					std::inplace_merge(
+						order.begin() + start,
+						order.begin() + start + width,
+						order.begin() + Min(count, start + width * 2),
+						less);
+				}
+			});
+		}
+		return not cancel;
+	}
+
+	class Table : public IControl
+	{
+	public:
+
+		using Config = Config::Table;
+
+		~Table()
+		{
+			*m_sortCancel = true;
+		}
+
+		// 評価中の行 (表示されている範囲)
+		size_t nextRow = 0;
+
+		size_t endRow = 0;
+
+		size_t currentRow = 0;
+
+		size_t nextColumn = 0;
+
+		// データソースから作った列 (データソースか列の数が変わったときだけ作り直す)
+		const Array<TableColumn>& sourceColumns(const ITableSource& source)
+		{
+			if (m_source != &source || m_sourceColumns.size() != source.columnCount())
+			{
+				m_source = &source;
+				m_sourceColumns.resize(source.columnCount());
+				for (size_t i = 0; i < m_sourceColumns.size(); i++)
+				{
+					m_sourceColumns[i] = TableColumn{ .label = source.columnName(i) };
+					if (source.sortable(i))
+					{
+						m_sourceColumns[i].less = [&source, i](size_t a, size_t b) { return source.less(i, a, b); };
+					}
+				}
+			}
+			return m_sourceColumns;
+		}
+
+		void init(const Array<TableColumn>& columns, size_t rowCount, const Font& font)
+		{
+			m_columns = &columns;
+			m_rowHeight = font.height() + Config::CellPadding * 2.0;
+
+			if (m_labels.size() != columns.size())
+			{
+				m_labels.clear();
+				m_widths.clear();
+				for (auto& column : columns)
+				{
+					m_labels.push_back(font(column.label));
+					m_widths.push_back(Max(column.width, Config::MinColumnWidth));
+				}
+				m_sortColumn = none;
+				m_resizingColumn = none;
+				m_order.clear();
+
+				// 前の列での並べ替えの結果は使わない
+				*m_sortCancel = true;
+				m_sortPending = false;
+			}
+			else
+			{
+				for (size_t i = 0; i < columns.size(); i++)
+				{
+					if (m_labels[i].text != columns[i].label)
+					{
+						m_labels[i] = font(columns[i].label);
+					}
+				}
+			}
+
+			// 並べ替えが終わっていれば新しい順番に切り替える (取り消したものは捨てて、待っていた並べ替えを始める)
+			if (m_sortTask.isValid() && m_sortTask.isReady())
+			{
+				Array<size_t> order = m_sortTask.get();
+				if (not *m_sortCancel && order.size() == rowCount)
+				{
+					m_order = std::move(order);
+				}
+				if (m_sortPending)
+				{
+					startSort();
+				}
+			}
+
+			if (m_rowCount != rowCount)
+			{
+				m_rowCount = rowCount;
+				m_order.clear();
+				if (m_sortColumn)
+				{
+					startSort();
+				}
+			}
+		}
+
+		size_t rowCount() const { return m_rowCount; }
+
+		size_t columnCount() const { return m_widths.size(); }
+
+		double rowHeight() const { return m_rowHeight; }
+
+		double contentWidth() const
+		{
+			double width = 0.0;
+			for (double w : m_widths)
+			{
+				width += w;
+			}
+			return width;
+		}
+
+		// 並べ替えた後のi番目の行のデータ上の番号
+		size_t rowAt(size_t i) const
+		{
+			return m_order.empty() ? i : m_order[i];
+		}
+
+		// 子領域のコンテンツ座標でのセルの矩形 (先頭の行はヘッダーの下)
+		RectF cellRect(size_t row, size_t column) const
+		{
+			double x = 0.0;
+			for (size_t i = 0; i < column; i++)
+			{
+				x += m_widths[i];
+			}
+			return { x, m_rowHeight * (row + 1), m_widths[column], m_rowHeight };
+		}
+
+		void updateHeader(Rect rect, Optional<Vec2> cursorPos)
+		{
+			m_headerRect = rect;
+			m_hoveredColumn = none;
+
+			if (m_resizingColumn)
+			{
+				if (MouseL.pressed())
+				{
+					double& width = m_widths[*m_resizingColumn];
+					width = Max(width + Cursor::DeltaF().x, Config::MinColumnWidth);
+				}
+				else
+				{
+					m_resizingColumn = none;
+				}
+				Cursor::RequestStyle(CursorStyle::ResizeLeftRight);
+				return;
+			}
+
+			if (not cursorPos || not rect.contains(*cursorPos))
+			{
+				return;
+			}
+
+			double x = rect.x;
+			for (size_t i = 0; i < m_widths.size(); i++)
+			{
+				const double right = x + m_widths[i];
+				const auto& column = (*m_columns)[i];
+
+				if (column.resizable && Abs(cursorPos->x - right) <= Config::ResizeHandleWidth)
+				{
+					Cursor::RequestStyle(CursorStyle::ResizeLeftRight);
+					if (MouseL.down())
+					{
+						m_resizingColumn = i;
+					}
+					return;
+				}
+
+				if (x <= cursorPos->x && cursorPos->x < right)
+				{
+					m_hoveredColumn = i;
+					if (column.less)
+					{
+						Cursor::RequestStyle(CursorStyle::Hand);
+						if (MouseL.down())
+						{
+							requestSort(i);
+						}
+					}
+					return;
+				}
+
+				x = right;
+			}
+		}
+
+		void drawHeader() const
+		{
+			m_headerRect.draw(Config::HeaderColor);
+
+			double x = m_headerRect.x;
+			for (size_t i = 0; i < m_widths.size(); i++)
+			{
+				const RectF cell{ x, m_headerRect.y, m_widths[i], m_headerRect.h };
+				x += m_widths[i];
+
+				if (m_hoveredColumn == i)
+				{
+					cell.draw(Config::HoveredHeaderColor);
+				}
+
+				m_labels[i].draw(cell.stretched(-Config::CellPadding), Config::LabelColor);
+
+				if (m_sortColumn == i)
+				{
+					const double size = m_labels[i].font.height() * Config::SortArrowScale;
+					Triangle{
+						Vec2{ cell.rightX() - Config::CellPadding - size, cell.centerY() },
+						size * 2,
+						m_descending ? 180_deg : 0_deg
+					}.draw(m_sortTask.isValid() ? Config::SortingArrowColor : Config::SortArrowColor);
+				}
+
+				Line{ cell.tr(), cell.br() }.draw(1, Config::BorderColor);
+			}
+
+			Line{ m_headerRect.bl(), m_headerRect.br() }.draw(1, Config::BorderColor);
+		}
+
+	private:
+
+		// init()を呼んだフレームの間だけ有効
+		const Array<TableColumn>* m_columns = nullptr;
+
+		const ITableSource* m_source = nullptr;
+
+		Array<TableColumn> m_sourceColumns;
+
+		Array<DrawableText> m_labels;
+
+		Array<double> m_widths;
+
+		double m_rowHeight = 0.0;
+
+		size_t m_rowCount = 0;
+
+		// 並べ替えた順番 (空のときはデータの順)
+		Array<size_t> m_order;
+
+		// 実行中の並べ替えを取り消す (AsyncTaskの破棄は完了を待つので、破棄する前にも立てる)
+		std::shared_ptr<std::atomic<bool>> m_sortCancel = std::make_shared<std::atomic<bool>>(false);
+
+		// 実行中の並べ替えが終わったら始める
+		bool m_sortPending = false;
+
+		Optional<size_t> m_sortColumn;
+
+		bool m_descending = false;
+
+		std::function<bool(size_t, size_t)> m_less;
+
+		// 同時に実行する並べ替えは1つまで
+		AsyncTask<Array<size_t>> m_sortTask;
+
+		Optional<size_t> m_resizingColumn;
+
+		Optional<size_t> m_hoveredColumn;
+
+		Rect m_headerRect{ 0, 0, 0, 0 };
+
+		void requestSort(size_t column)
+		{
+			if (m_sortColumn == column)
+			{
+				m_descending = not m_descending;
+			}
+			else
+			{
+				m_sortColumn = column;
+				m_descending = false;
+			}
+			m_less = (*m_columns)[column].less;
+			startSort();
+		}
+
+		void startSort()
+		{
+			// 実行中の並べ替えは取り消し、終わってから新しい条件で始める
+			if (m_sortTask.isValid() && not m_sortTask.isReady())
+			{
+				*m_sortCancel = true;
+				m_sortPending = true;
+				return;
+			}
+			m_sortPending = false;
+
+			m_sortCancel = std::make_shared<std::atomic<bool>>(false);
+			m_sortTask = Async([less = m_less, descending = m_descending, count = m_rowCount, cancel = m_sortCancel]()
+			{
+				Array<size_t> order(count);
+				std::iota(order.begin(), order.end(), size_t{ 0 });
+
+				const bool completed = descending
+					? StableSortCancellable(order, [&](size_t a, size_t b) { return less(b, a); }, *cancel)
+					: StableSortCancellable(order, less, *cancel);
+				return completed ? order : Array<size_t>{};
+			});
+		}
+
+		// ヘッダーはendTable()でTableHeaderとして配置する
+
+		Size computeSize() const override
+		{
+			return { 0, 0 };
+		}
+
+		void update(Rect, Optional<Vec2>) override
+		{ }
+
+		void draw() const override
+		{ }
+	};
+
+	// 行の上に重ねて描くため、表の最後に配置する
+	class TableHeader : public IControl
+	{
+	public:
+
+		Table* table = nullptr;
+
+	private:
+
+		Size computeSize() const override
+		{
+			return { 0, 0 };
+		}
+
+		void update(Rect rect, Optional<Vec2> cursorPos) override
+		{
+			table->updateHeader(rect, cursorPos);
+		}
+
+		void draw() const override
+		{
+			table->drawHeader();
+		}
+	};
+
+	class TableCell : public IControl
+	{
+	public:
+
+		using Config = Config::Table;
+
+		DrawableText text;
+
+		ColorF color;
+
+		bool alternate = false;
+
+	private:
+
+		Rect m_rect{ 0, 0, 0, 0 };
+
+		Size computeSize() const override
+		{
+			return m_rect.size;
+		}
+
+		void update(Rect rect, Optional<Vec2>) override
+		{
+			m_rect = rect;
+		}
+
+		void draw() const override
+		{
+			m_rect.draw(alternate ? Config::AlternateRowColor : Config::RowColor);
+			text.draw(m_rect.stretched(-Config::CellPadding), color);
+			Line{ m_rect.tr(), m_rect.br() }.draw(1, Config::BorderColor);
+		}
+	};
+
+	static void BeginTable(detail::WindowImpl& window, Table& table, const StringView id, const Array<TableColumn>& columns, size_t rowCount, SizeF size)
+	{
+		assert(window.activeTable() == nullptr);
+
+		table.init(columns, rowCount, window.window.font);
+
+		size_t bodyId = id.hash();
+		s3d::detail::HashCombine(bodyId, typeid(Table).hash_code());
+		window.beginChild(bodyId, size);
+
+		// 表示されている行だけを評価する
+		const RectF viewport = window.childViewport();
+		const double rowHeight = table.rowHeight();
+		table.nextRow = Min(rowCount, static_cast<size_t>(Max(0.0, viewport.y / rowHeight)));
+		table.endRow = Min(rowCount, static_cast<size_t>(Max(0.0, Math::Ceil((viewport.y + viewport.h - rowHeight) / rowHeight))));
+
+		window.setActiveTable(&table);
+	}
+
+	void GUIManager::beginTable(const StringView id, const Array<TableColumn>& columns, size_t rowCount, SizeF size)
+	{
+		auto& window = getCurrentWindowImpl();
+		auto& table = window.nextStatefulControl<Table>(id.hash());
+		BeginTable(window, table, id, columns, rowCount, size);
+	}
+
+	Optional<size_t> GUIManager::tableRow()
+	{
+		auto& table = *getCurrentWindowImpl().activeTable();
+
+		if (table.nextRow >= table.endRow)
+		{
+			return none;
+		}
+
+		table.currentRow = table.nextRow++;
+		table.nextColumn = 0;
+		return table.rowAt(table.currentRow);
+	}
+
+	void GUIManager::tableCell(const StringView text, ColorF color)
+	{
+		auto& window = getCurrentWindowImpl();
+		auto& table = *window.activeTable();
+
+		if (table.nextColumn >= table.columnCount())
+		{
+			return;
+		}
+
+		auto& cell = window.nextStatelessControl<TableCell>();
+		cell.text = window.window.font(text);
+		cell.color = color;
+		cell.alternate = table.currentRow % 2 == 1;
+
+		window.updateControlAt(cell, window.placeRect(table.cellRect(table.currentRow, table.nextColumn++)));
+	}
+
+	void GUIManager::endTable()
+	{
+		auto& window = getCurrentWindowImpl();
+		auto& table = *window.activeTable();
+
+		// 評価しなかった行の分も確保してスクロールバーを合わせる
+		const RectF viewport = window.childViewport();
+		window.placeRect({ 0, 0, table.contentWidth(), table.rowHeight() * (table.rowCount() + 1) });
+
+		auto& header = window.nextStatelessControl<TableHeader>();
+		header.table = &table;
+		window.updateControlAt(header, window.placeRect({ 0, viewport.y, Max(table.contentWidth(), viewport.w), table.rowHeight() }));
+
+		window.setActiveTable(nullptr);
+		window.endChild();
+	}
+
+	// TableSource
+
+	template<class T>
+	static T ReadValue(const Byte* p)
+	{
+		// ファイル内の値は境界に揃っているとは限らない
+		T value;
+		std::memcpy(&value, p, sizeof(T));
+		return value;
+	}
+
+	template<class Func>
+	static decltype(auto) DispatchColumnType(ColumnType type, Func&& func)
+	{
+		switch (type)
+		{
+		case ColumnType::Int8: return func(std::type_identity<int8>{});
+		case ColumnType::Int16: return func(std::type_identity<int16>{});
+		case ColumnType::Int32: return func(std::type_identity<int32>{});
+		case ColumnType::Int64: return func(std::type_identity<int64>{});
+		case ColumnType::UInt8: return func(std::type_identity<uint8>{});
+		case ColumnType::UInt16: return func(std::type_identity<uint16>{});
+		case ColumnType::UInt32: return func(std::type_identity<uint32>{});
+		case ColumnType::UInt64: return func(std::type_identity<uint64>{});
+		case ColumnType::Float: return func(std::type_identity<float>{});
+		case ColumnType::Double:
+		default: return func(std::type_identity<double>{});
+		}
+	}
+
+	static size_t ColumnTypeSize(ColumnType type)
+	{
+		return DispatchColumnType(type, [](auto tag) { return sizeof(typename decltype(tag)::type); });
+	}
+
+	MappedBinarySource::MappedBinarySource(const FilePathView path, const Array<BinaryColumn>& columns, size_t rowCount)
+	{
+		open(path, columns, rowCount);
+	}
+
+	bool MappedBinarySource::open(const FilePathView path, const Array<BinaryColumn>& columns, size_t rowCount)
+	{
+		m_memory = {};
+		m_file.close();
+		m_columns.clear();
+		m_rowCount = 0;
+
+		if (not m_file.open(path))
+		{
+			return false;
+		}
+
+		// 仮想メモリに割り当てるだけで、読まれたページだけが読み込まれる
+		m_memory = m_file.mapAll();
+		if (not m_memory.data)
+		{
+			m_file.close();
+			return false;
+		}
+
+		m_columns = columns;
+		size_t fitRows = std::numeric_limits<size_t>::max();
+		for (auto& column : m_columns)
+		{
+			const size_t size = ColumnTypeSize(column.type);
+			if (column.stride == 0)
+			{
+				column.stride = size;
+			}
+
+			// 全ての列の値がファイルに収まる行数まで
+			if (column.offset + size > m_memory.size)
+			{
+				fitRows = 0;
+				continue;
+			}
+			fitRows = Min<size_t>(fitRows, (m_memory.size - column.offset - size) / column.stride + 1);
+		}
+
+		if (m_columns.isEmpty())
+		{
+			fitRows = 0;
+		}
+		m_rowCount = rowCount == 0 ? fitRows : Min(rowCount, fitRows);
+		return true;
+	}
+
+	const Byte* MappedBinarySource::valuePtr(size_t row, size_t column) const
+	{
+		auto& c = m_columns[column];
+		return m_memory.data + c.offset + c.stride * row;
+	}
+
+	void MappedBinarySource::formatCell(size_t row, size_t column, String& out) const
+	{
+		const Byte* p = valuePtr(row, column);
+		DispatchColumnType(m_columns[column].type, [&](auto tag) {
+			using T = typename decltype(tag)::type;
+			if constexpr (sizeof(T) == 1)
+			{
+				// 1バイトの整数は文字として扱わない
+				out = Format(static_cast<int32>(ReadValue<T>(p)));
+			}
+			else
+			{
+				out = Format(ReadValue<T>(p));
+			}
+		});
+	}
+
+	bool MappedBinarySource::less(size_t column, size_t a, size_t b) const
+	{
+		const Byte* pa = valuePtr(a, column);
+		const Byte* pb = valuePtr(b, column);
+		return DispatchColumnType(m_columns[column].type, [&](auto tag) {
+			using T = typename decltype(tag)::type;
+			return ReadValue<T>(pa) < ReadValue<T>(pb);
+		});
+	}
+
+	// 引用符の中の改行を飛ばして次の行の先頭を返す
+	static const char* SkipCsvRecord(const char* p, const char* end)
+	{
+		bool quoted = false;
+		while (p < end)
+		{
+			const char c = *p++;
+			if (c == '"')
+			{
+				quoted = not quoted;
+			}
+			else if (c == '\n' && not quoted)
+			{
+				break;
+			}
+		}
+		return p;
+	}
+
+	// 行の先頭から列の値を取り出す (引用符を外す)
+	// 列が足りないときはfalse
+	static bool ReadCsvField(const char* p, const char* end, char delimiter, size_t column, std::string& out)
+	{
+		out.clear();
+
+		size_t index = 0;
+		bool quoted = false;
+		while (p < end)
+		{
+			const char c = *p;
+			if (quoted)
+			{
+				if (c == '"')
+				{
+					if (p + 1 < end && p[1] == '"')
+					{
+						if (index == column)
+						{
+							out.push_back('"');
+						}
+						p += 2;
+						continue;
+					}
+					quoted = false;
+				}
+				else if (index == column)
+				{
+					out.push_back(c);
+				}
+			}
+			else if (c == '"')
+			{
+				quoted = true;
+			}
+			else if (c == delimiter || c == '\n')
+			{
+				if (index == column || c == '\n')
+				{
+					break;
+				}
+				index++;
+			}
+			else if (index == column && c != '\r')
+			{
+				out.push_back(c);
+			}
+			p++;
+		}
+
+		return index == column;
+	}
+
+	MappedCsvSource::MappedCsvSource(const FilePathView path, char delimiter, bool hasHeader)
+	{
+		open(path, delimiter, hasHeader);
+	}
+
+	bool MappedCsvSource::open(const FilePathView path, char delimiter, bool hasHeader)
+	{
+		close();
+
+		if (not m_file.open(path))
+		{
+			return false;
+		}
+
+		m_memory = m_file.mapAll();
+		if (not m_memory.data)
+		{
+			m_file.close();
+			return false;
+		}
+
+		m_delimiter = delimiter;
+
+		const char* begin = reinterpret_cast<const char*>(m_memory.data);
+		const char* end = begin + m_memory.size;
+
+		// 列の数と名前は先頭の行だけから決める
+		std::string field;
+		for (size_t column = 0; ReadCsvField(begin, end, delimiter, column, field); column++)
+		{
+			m_columnNames.push_back(hasHeader
+				? Unicode::FromUTF8(field)
+				: Format(column + 1));
+		}
+		const char* dataBegin = hasHeader ? SkipCsvRecord(begin, end) : begin;
+
+		// 索引ができた行から表示できるよう、行数はまとめて公開する
+		m_indexer = Async([this, begin, end, dataBegin]()
+		{
+			constexpr size_t PublishInterval = IndexInterval * 64;
+
+			const char* p = dataBegin;
+			size_t rows = 0;
+			while (p < end && not m_abort.load(std::memory_order_relaxed))
+			{
+				if (rows % IndexInterval == 0)
+				{
+					std::lock_guard lock{ m_checkpointMutex };
+					m_checkpoints.push_back(p - begin);
+				}
+
+				p = SkipCsvRecord(p, end);
+				rows++;
+
+				if (rows % PublishInterval == 0)
+				{
+					m_rowCount.store(rows, std::memory_order_release);
+				}
+			}
+			m_rowCount.store(rows, std::memory_order_release);
+		});
+
+		return true;
+	}
+
+	void MappedCsvSource::close()
+	{
+		m_abort = true;
+		if (m_indexer.isValid())
+		{
+			m_indexer.get();
+		}
+		m_abort = false;
+
+		m_memory = {};
+		m_file.close();
+		m_columnNames.clear();
+		m_checkpoints.clear();
+		m_rowCount = 0;
+	}
+
+	MappedCsvSource::~MappedCsvSource()
+	{
+		close();
+	}
+
+	const char* MappedCsvSource::rowBegin(size_t row) const
+	{
+		const char* begin = reinterpret_cast<const char*>(m_memory.data);
+		const char* end = begin + m_memory.size;
+
+		uint64 checkpoint;
+		{
+			std::lock_guard lock{ m_checkpointMutex };
+			checkpoint = m_checkpoints[row / IndexInterval];
+		}
+
+		// 記録した行からは最大IndexInterval - 1行だけ読み進める
+		const char* p = begin + checkpoint;
+		for (size_t i = 0; i < row % IndexInterval; i++)
+		{
+			p = SkipCsvRecord(p, end);
+		}
+		return p;
+	}
+
+	void MappedCsvSource::formatCell(size_t row, size_t column, String& out) const
+	{
+		const char* end = reinterpret_cast<const char*>(m_memory.data) + m_memory.size;
+
+		std::string field;
+		ReadCsvField(rowBegin(row), end, m_delimiter, column, field);
+		out = Unicode::FromUTF8(field);
+	}
+
+	void GUIManager::table(const StringView id, const ITableSource& source, SizeF size)
+	{
+		auto& window = getCurrentWindowImpl();
+		auto& table = window.nextStatefulControl<Table>(id.hash());
+		const auto& columns = table.sourceColumns(source);
+		BeginTable(window, table, id, columns, source.rowCount(), size);
+
+		String text;
+		while (auto row = tableRow())
+		{
+			for (size_t i = 0; i < columns.size(); i++)
+			{
+				source.formatCell(*row, i, text);
+				tableCell(text);
+			}
+		}
+
+		endTable();
+	}
+
+	// LogView
+
+	LogSink::LogSink(size_t capacity, size_t queueCapacity)
+		: m_slots(std::make_unique<Slot[]>(Max<size_t>(queueCapacity, 1)))
+		, m_queueCapacity(Max<size_t>(queueCapacity, 1))
+		, m_capacity(Max<size_t>(capacity, 1))
+	{
+		for (size_t i = 0; i < m_queueCapacity; i++)
+		{
+			m_slots[i].sequence.store(i, std::memory_order_relaxed);
+		}
+	}
+
+	// 生産者は書き込む位置を比較交換で確保してから、枠の番号を進めて公開する
+	bool LogSink::push(String text, ColorF color)
+	{
+		uint64 pos = m_enqueuePos.load(std::memory_order_relaxed);
+		Slot* slot;
+		for (;;)
+		{
+			slot = &m_slots[pos % m_queueCapacity];
+			const uint64 sequence = slot->sequence.load(std::memory_order_acquire);
+			const int64 diff = static_cast<int64>(sequence - pos);
+
+			if (diff == 0)
+			{
+				if (m_enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+				{
+					break;
+				}
+			}
+			else if (diff < 0)
+			{
+				// GUIスレッドが一周分取り込んでいない
+				m_dropped.fetch_add(1, std::memory_order_relaxed);
+				return false;
+			}
+			else
+			{
+				pos = m_enqueuePos.load(std::memory_order_relaxed);
+			}
+		}
+
+		slot->line = { std::move(text), color };
+		slot->sequence.store(pos + 1, std::memory_order_release);
+		return true;
+	}
+
+	void LogSink::drain()
+	{
+		// 書き込み中の枠に当たったら、その先は次のフレームで取り込む
+		for (;;)
+		{
+			Slot& slot = m_slots[m_dequeuePos % m_queueCapacity];
+			if (slot.sequence.load(std::memory_order_acquire) != m_dequeuePos + 1)
+			{
+				break;
+			}
+
+			const size_t index = static_cast<size_t>(m_end % m_capacity);
+			if (index < m_lines.size())
+			{
+				m_lines[index] = std::move(slot.line);
+			}
+			else
+			{
+				m_lines.push_back(std::move(slot.line));
+			}
+			slot.sequence.store(m_dequeuePos + m_queueCapacity, std::memory_order_release);
+			m_dequeuePos++;
+
+			m_end++;
+			if (m_end - m_begin > m_capacity)
+			{
+				m_begin = m_end - m_capacity;
+			}
+		}
+	}
+
+	class LogView : public IControl
+	{
+	public:
+
+		// 表示する行を更新する (フィルターは追加された行だけを調べる)
+		void refresh(const LogSink& sink, const StringView filter)
+		{
+			if (filter != m_filter)
+			{
+				m_filter = filter;
+				m_matches.clear();
+				m_matchBegin = 0;
+				m_checkedEnd = 0;
+				m_contentWidth = 0.0;
+			}
+
+			if (m_filter.isEmpty())
+			{
+				return;
+			}
+
+			// 捨てられた行を除く
+			m_matchBegin = std::lower_bound(m_matches.begin() + m_matchBegin, m_matches.end(), sink.beginIndex()) - m_matches.begin();
+			if (m_matchBegin > m_matches.size() / 2)
+			{
+				m_matches.erase(m_matches.begin(), m_matches.begin() + m_matchBegin);
+				m_matchBegin = 0;
+			}
+
+			for (uint64 i = Max(m_checkedEnd, sink.beginIndex()); i < sink.endIndex(); i++)
+			{
+				if (sink[i].text.includes(m_filter))
+				{
+					m_matches.push_back(i);
+				}
+			}
+			m_checkedEnd = sink.endIndex();
+		}
+
+		size_t lineCount(const LogSink& sink) const
+		{
+			return m_filter.isEmpty() ? sink.size() : m_matches.size() - m_matchBegin;
+		}
+
+		// 表示するi番目の行の通し番号
+		uint64 lineAt(const LogSink& sink, size_t i) const
+		{
+			return m_filter.isEmpty() ? sink.beginIndex() + i : m_matches[m_matchBegin + i];
+		}
+
+		// 行を全部整形しないので、表示したことのある行の最大幅を使う
+		double contentWidth() const { return m_contentWidth; }
+
+		void extendWidth(double width)
+		{
+			m_contentWidth = Max(m_contentWidth, width);
+		}
+
+	private:
+
+		String m_filter;
+
+		// フィルターに一致した行の通し番号 (m_matchBegin以降が有効)
+		Array<uint64> m_matches;
+
+		size_t m_matchBegin = 0;
+
+		// フィルターを調べ終えた行の次の通し番号
+		uint64 m_checkedEnd = 0;
+
+		double m_contentWidth = 0.0;
+
+		// 行はLogLineとして配置する
+
+		Size computeSize() const override
+		{
+			return { 0, 0 };
+		}
+
+		void update(Rect, Optional<Vec2>) override
+		{ }
+
+		void draw() const override
+		{ }
+	};
+
+	class LogLine : public IControl
+	{
+	public:
+
+		using Config = Config::LogView;
+
+		DrawableText text;
+
+		ColorF color;
+
+	private:
+
+		Rect m_rect{ 0, 0, 0, 0 };
+
+		Size computeSize() const override
+		{
+			return m_rect.size;
+		}
+
+		void update(Rect rect, Optional<Vec2>) override
+		{
+			m_rect = rect;
+		}
+
+		void draw() const override
+		{
+			text.draw(m_rect.pos.movedBy(Config::TextPadding, 0), color);
+		}
+	};
+
+	void GUIManager::logView(const StringView id, LogSink& sink, SizeF size, const StringView filter)
+	{
+		auto& window = getCurrentWindowImpl();
+
+		sink.drain();
+
+		auto& view = window.nextStatefulControl<LogView>(id.hash());
+		view.refresh(sink, filter);
+
+		size_t bodyId = id.hash();
+		s3d::detail::HashCombine(bodyId, typeid(LogView).hash_code());
+		window.beginChild(bodyId, size);
+
+		const size_t lineCount = view.lineCount(sink);
+		const double lineHeight = window.window.font.height();
+		const double contentHeight = lineHeight * lineCount;
+
+		// 末尾を表示していれば追加された行まで進める
+		if (window.childScrolledToEnd())
+		{
+			window.scrollChildToEnd(contentHeight);
+		}
+
+		// 表示されている行だけを整形する
+		const RectF viewport = window.childViewport();
+		const size_t beginLine = Min(lineCount, static_cast<size_t>(Max(0.0, viewport.y / lineHeight)));
+		const size_t endLine = Min(lineCount, static_cast<size_t>(Max(0.0, Math::Ceil((viewport.y + viewport.h) / lineHeight))));
+
+		for (size_t i = beginLine; i < endLine; i++)
+		{
+			const auto& line = sink[view.lineAt(sink, i)];
+
+			auto& item = window.nextStatelessControl<LogLine>();
+			item.text = window.window.font(line.text);
+			item.color = line.color;
+
+			const double width = item.text.region().w + Config::LogView::TextPadding * 2;
+			view.extendWidth(width);
+			window.updateControlAt(item, window.placeRect({ 0, lineHeight * i, width, lineHeight }));
+		}
+
+		// 整形しなかった行の分も確保してスクロールバーを合わせる
+		window.placeRect({ 0, 0, view.contentWidth(), contentHeight });
+
+		window.endChild();
+	}
+
+	// Plot
+
+	// [first, last)の最小値と最大値 (空でないこと)
+	static std::pair<float, float> MinMaxOf(const float* first, const float* last)
+	{
+		float lo = *first;
+		float hi = *first;
+
+#ifdef SASAGUI_USE_SSE2
+		if (last - first >= 8)
+		{
+			__m128 lo0 = _mm_loadu_ps(first), hi0 = lo0;
+			__m128 lo1 = _mm_loadu_ps(first + 4), hi1 = lo1;
+			first += 8;
+
+			for (; last - first >= 8; first += 8)
+			{
+				const __m128 a = _mm_loadu_ps(first);
+				const __m128 b = _mm_loadu_ps(first + 4);
+				lo0 = _mm_min_ps(lo0, a);
+				hi0 = _mm_max_ps(hi0, a);
+				lo1 = _mm_min_ps(lo1, b);
+				hi1 = _mm_max_ps(hi1, b);
+			}
+
+			alignas(16) float los[4];
+			alignas(16) float his[4];
+			_mm_store_ps(los, _mm_min_ps(lo0, lo1));
+			_mm_store_ps(his, _mm_max_ps(hi0, hi1));
+			lo = std::min({ los[0], los[1], los[2], los[3] });
+			hi = std::max({ his[0], his[1], his[2], his[3] });
+		}
+#endif
+
+		for (; first != last; ++first)
+		{
+			lo = Min(lo, *first);
+			hi = Max(hi, *first);
+		}
+		return { lo, hi };
+	}
+
+	class Plot : public IControl
+	{
+	public:
+
+		using Config = Config::Plot;
+
+		// update()の間だけ有効 (xsが空のときはサンプルの番号をxとする)
+		std::span<const float> xs;
+
+		std::span<const float> ys;
+
+		uint64 version = 0;
+
+		Size size{ 0, 0 };
+
+	private:
+
+		// これが変わらない間は間引いた結果を使い回す
+		struct CacheKey
+		{
+			uint64 version;
+
+			const float* xs;
+
+			const float* ys;
+
+			size_t count;
+
+			Size size;
+
+			double viewBegin;
+
+			double viewEnd;
+
+			bool operator==(const CacheKey&) const = default;
+		};
+
+		Optional<CacheKey> m_cacheKey;
+
+		// コントロールのローカル座標
+		LineString m_line;
+
+		Rect m_rect{ 0, 0, 0, 0 };
+
+		// 表示しているxの範囲 (データ全体を0〜1とする)
+		double m_viewBegin = 0.0;
+
+		double m_viewEnd = 1.0;
+
+		// ドラッグで選択中の範囲 (ローカル座標のx)
+		Optional<double> m_selectionBegin;
+
+		double m_selectionEnd = 0.0;
+
+		size_t count() const
+		{
+			return xs.empty() ? ys.size() : Min(xs.size(), ys.size());
+		}
+
+		double xAt(size_t i) const
+		{
+			return xs.empty() ? static_cast<double>(i) : xs[i];
+		}
+
+		// x以上になる最初のサンプルの番号 (xsは昇順)
+		size_t lowerIndex(double x) const
+		{
+			if (xs.empty())
+			{
+				return static_cast<size_t>(Clamp(Math::Ceil(x), 0.0, static_cast<double>(ys.size())));
+			}
+			return std::lower_bound(xs.begin(), xs.begin() + count(), static_cast<float>(x)) - xs.begin();
+		}
+
+		// xより大きくなる最初のサンプルの番号
+		size_t upperIndex(double x) const
+		{
+			if (xs.empty())
+			{
+				return static_cast<size_t>(Clamp(Math::Floor(x) + 1.0, 0.0, static_cast<double>(ys.size())));
+			}
+			return std::upper_bound(xs.begin(), xs.begin() + count(), static_cast<float>(x)) - xs.begin();
+		}
+
+		Size computeSize() const override
+		{
+			return size;
+		}
+
+		void update(Rect rect, Optional<Vec2> cursorPos) override
+		{
+			m_rect = rect;
+			updateSelection(cursorPos);
+
+			const CacheKey key{
+				.version = version,
+				.xs = xs.data(),
+				.ys = ys.data(),
+				.count = count(),
+				.size = rect.size,
+				.viewBegin = m_viewBegin,
+				.viewEnd = m_viewEnd
+			};
+			if (m_cacheKey != key)
+			{
+				rebuild();
+				m_cacheKey = key;
+			}
+
+			xs = {};
+			ys = {};
+		}
+
+		// 左ドラッグで選択した範囲にズームし、右クリックで全体に戻す
+		void updateSelection(Optional<Vec2> cursorPos)
+		{
+			if (m_selectionBegin)
+			{
+				if (cursorPos)
+				{
+					m_selectionEnd = Clamp(cursorPos->x - m_rect.x, 0.0, static_cast<double>(m_rect.w));
+				}
+
+				if (not MouseL.pressed())
+				{
+					const double width = m_rect.w - Config::Padding * 2;
+					if (Abs(m_selectionEnd - *m_selectionBegin) >= Config::MinSelectionWidth && width > 0)
+					{
+						const double a = Clamp((Min(*m_selectionBegin, m_selectionEnd) - Config::Padding) / width, 0.0, 1.0);
+						const double b = Clamp((Max(*m_selectionBegin, m_selectionEnd) - Config::Padding) / width, 0.0, 1.0);
+						const double range = m_viewEnd - m_viewBegin;
+						m_viewEnd = m_viewBegin + range * b;
+						m_viewBegin = m_viewBegin + range * a;
+					}
+					m_selectionBegin = none;
+				}
+				return;
+			}
+
+			if (not cursorPos || not m_rect.contains(*cursorPos))
+			{
+				return;
+			}
+
+			if (MouseL.down())
+			{
+				m_selectionBegin = m_selectionEnd = cursorPos->x - m_rect.x;
+			}
+			else if (MouseR.down())
+			{
+				m_viewBegin = 0.0;
+				m_viewEnd = 1.0;
+			}
+		}
+
+		void rebuild()
+		{
+			m_line.clear();
+
+			const size_t n = count();
+			const RectF area = RectF{ m_rect.size }.stretched(-Config::Padding);
+			const int32 columns = static_cast<int32>(area.w);
+			if (n == 0 || columns <= 0 || area.h <= 0)
+			{
+				return;
+			}
+
+			const double domainBegin = xAt(0);
+			const double domainEnd = xAt(n - 1);
+			const double x0 = domainBegin + (domainEnd - domainBegin) * m_viewBegin;
+			const double x1 = domainBegin + (domainEnd - domainBegin) * m_viewEnd;
+			const size_t first = lowerIndex(x0);
+			const size_t last = upperIndex(x1);
+			if (first >= last)
+			{
+				return;
+			}
+
+			// 点のxはピクセル、yはデータの値で集めてから縦方向を合わせる
+			if (last - first <= static_cast<size_t>(columns) * 2 || x1 <= x0)
+			{
+				// ピクセルより点が少なければ間引かずにつなぐ
+				const double scale = x1 > x0 ? area.w / (x1 - x0) : 0.0;
+				for (size_t i = first; i < last; i++)
+				{
+					m_line.emplace_back(area.x + (xAt(i) - x0) * scale, ys[i]);
+				}
+			}
+			else
+			{
+				// 1列ごとに最小値と最大値を交互につないで包絡線にする
+				size_t begin = first;
+				for (int32 column = 0; column < columns; column++)
+				{
+					const size_t end = column == columns - 1
+						? last
+						: lowerIndex(x0 + (x1 - x0) * (column + 1) / columns);
+					if (begin < end)
+					{
+						const auto [lo, hi] = MinMaxOf(ys.data() + begin, ys.data() + end);
+						const double x = area.x + column + 0.5;
+						const bool flip = m_line.size() % 4 == 2;
+						m_line.emplace_back(x, flip ? hi : lo);
+						m_line.emplace_back(x, flip ? lo : hi);
+						begin = end;
+					}
+				}
+			}
+
+			double lo = m_line.front().y;
+			double hi = lo;
+			for (const auto& point : m_line)
+			{
+				lo = Min(lo, point.y);
+				hi = Max(hi, point.y);
+			}
+			if (hi - lo < 1e-12)
+			{
+				lo -= 0.5;
+				hi += 0.5;
+			}
+
+			const double scale = area.h / (hi - lo);
+			for (auto& point : m_line)
+			{
+				point.y = area.bottomY() - (point.y - lo) * scale;
+			}
+		}
+
+		void draw() const override
+		{
+			m_rect
+				.draw(Config::BackgroundColor)
+				.drawFrame(1, 0, Config::FrameColor);
+
+			{
+				const Transformer2D transform{ Mat3x2::Translate(m_rect.pos) };
+				m_line.draw(Config::LineThickness, Config::LineColor);
+			}
+
+			if (m_selectionBegin)
+			{
+				RectF{
+					m_rect.x + Min(*m_selectionBegin, m_selectionEnd),
+					m_rect.y,
+					Abs(m_selectionEnd - *m_selectionBegin),
+					m_rect.h
+				}.draw(Config::SelectionColor);
+			}
+		}
+	};
+
+	void GUIManager::plot(const StringView id, std::span<const float> ys, SizeF size, uint64 version)
+	{
+		plot(id, {}, ys, size, version);
+	}
+
+	void GUIManager::plot(const StringView id, std::span<const float> xs, std::span<const float> ys, SizeF size, uint64 version)
+	{
+		auto& window = getCurrentWindowImpl();
+		auto& control = window.nextStatefulControl<Plot>(id.hash());
+
+		if (size.x <= 0.0)
+		{
+			size.x = window.availableWidth().value_or(0.0);
+		}
+
+		control.xs = xs;
+		control.ys = ys;
+		control.version = version;
+		control.size = size.asPoint();
+
+		window.updateControl(control);
+	}
+
+	// Scatter
+
+	// 点を一様な格子に振り分けた索引 (データ座標)
+	static bool IsFinite(const Float2& point)
+	{
+		return std::isfinite(point.x) && std::isfinite(point.y);
+	}
+
+	struct ScatterIndex
+	{
+		RectF bounds{ 0, 0, 1, 1 };
+
+		int32 columns = 1;
+
+		int32 rows = 1;
+
+		// 升目ごとの点の範囲 (itemsの位置, 升目の数 + 1個)
+		Array<uint32> cellStart;
+
+		// 升目の順に並べた点の番号
+		Array<uint32> items;
+
+		// 範囲の外の位置は端の升目にする (int32に収まらない値を変換しないように、doubleのまま収める)
+		Point cellOf(Vec2 pos) const
+		{
+			const auto toCell = [](double v, int32 count)
+			{
+				return std::isnan(v) ? 0 : static_cast<int32>(Clamp(v, 0.0, count - 1.0));
+			};
+			return {
+				toCell((pos.x - bounds.x) / bounds.w * columns, columns),
+				toCell((pos.y - bounds.y) / bounds.h * rows, rows)
+			};
+		}
+
+		// 範囲 (両端を含む) の升目に入っている点の番号をfuncに渡す
+		template<class Func>
+		void forEach(Point minCell, Point maxCell, Func func) const
+		{
+			for (int32 y = minCell.y; y <= maxCell.y; y++)
+			{
+				const size_t row = static_cast<size_t>(y) * columns;
+				for (uint32 i = cellStart[row + minCell.x]; i < cellStart[row + maxCell.x + 1]; i++)
+				{
+					func(items[i]);
+				}
+			}
+		}
+
+		static ScatterIndex Build(const Array<Float2>& points, RectF bounds)
+		{
+			ScatterIndex index;
+			index.bounds = bounds;
+
+			// 1つの升目に平均数個の点が入る細かさにする
+			const int32 size = Clamp(static_cast<int32>(Math::Sqrt(points.size() / 4.0)), 1, 2048);
+			index.columns = size;
+			index.rows = size;
+
+			// 升目ごとに数えてから並べる (有限でない点は索引に入れない)
+			constexpr uint32 Skipped = std::numeric_limits<uint32>::max();
+			Array<uint32> cells(points.size());
+			index.cellStart.resize(static_cast<size_t>(size) * size + 1, 0);
+			for (size_t i = 0; i < points.size(); i++)
+			{
+				if (not IsFinite(points[i]))
+				{
+					cells[i] = Skipped;
+					continue;
+				}
+
+				const Point cell = index.cellOf(points[i]);
+				cells[i] = static_cast<uint32>(cell.y * size + cell.x);
+				index.cellStart[cells[i] + 1]++;
+			}
+			for (size_t i = 1; i < index.cellStart.size(); i++)
+			{
+				index.cellStart[i] += index.cellStart[i - 1];
+			}
+
+			Array<uint32> next(index.cellStart.begin(), index.cellStart.end() - 1);
+			index.items.resize(index.cellStart.back());
+			for (size_t i = 0; i < points.size(); i++)
+			{
+				if (cells[i] != Skipped)
+				{
+					index.items[next[cells[i]]++] = static_cast<uint32>(i);
+				}
+			}
+			return index;
+		}
+	};
+
+	class Scatter : public IControl
+	{
+	public:
+
+		using Config = Config::Scatter;
+
+		// update()の間だけ有効
+		std::span<const Float2> points;
+
+		uint64 version = 0;
+
+		Size size{ 0, 0 };
+
+		Optional<size_t> hoveredPoint() const { return m_hovered; }
+
+	private:
+
+		struct DataKey
+		{
+			uint64 version;
+
+			const Float2* data;
+
+			size_t size;
+
+			bool operator==(const DataKey&) const = default;
+		};
+
+		struct CellsKey
+		{
+			uint64 dataSerial;
+
+			RectF view;
+
+			Size size;
+
+			bool operator==(const CellsKey&) const = default;
+		};
+
+		Optional<DataKey> m_dataKey;
+
+		// 索引を作るスレッドと共有するため、受け取った点を複製して持つ
+		std::shared_ptr<const Array<Float2>> m_points;
+
+		uint64 m_dataSerial = 0;
+
+		RectF m_bounds{ 0, 0, 1, 1 };
+
+		Optional<ScatterIndex> m_index;
+
+		AsyncTask<ScatterIndex> m_indexTask;
+
+		// データが変わって不要になったタスク (完了を待たずに、終わったものから捨てる)
+		Array<AsyncTask<ScatterIndex>> m_staleTasks;
+
+		// 表示しているデータ座標の範囲 (noneのときは全体)
+		Optional<RectF> m_view;
+
+		Optional<CellsKey> m_cellsKey;
+
+		// 点のある升目の左上 (ローカル座標)
+		Array<Float2> m_cells;
+
+		Rect m_rect{ 0, 0, 0, 0 };
+
+		Optional<size_t> m_hovered;
+
+		Vec2 m_hoveredPos{ 0, 0 };
+
+		Optional<Vec2> m_selectionBegin;
+
+		Vec2 m_selectionEnd{ 0, 0 };
+
+		Optional<Vec2> m_panBegin;
+
+		RectF area() const
+		{
+			return RectF{ m_rect.size }.stretched(-Config::Padding);
+		}
+
+		RectF view() const
+		{
+			return m_view.value_or(m_bounds);
+		}
+
+		Vec2 toLocal(Vec2 pos, const RectF& view, const RectF& area) const
+		{
+			return {
+				area.x + (pos.x - view.x) / view.w * area.w,
+				area.bottomY() - (pos.y - view.y) / view.h * area.h
+			};
+		}
+
+		Vec2 toData(Vec2 local, const RectF& view, const RectF& area) const
+		{
+			return {
+				view.x + (local.x - area.x) / area.w * view.w,
+				view.y + (area.bottomY() - local.y) / area.h * view.h
+			};
+		}
+
+		static Vec2 ClampToArea(Vec2 pos, const RectF& area)
+		{
+			return { Clamp(pos.x, area.x, area.rightX()), Clamp(pos.y, area.y, area.bottomY()) };
+		}
+
+		static RectF SelectionRect(Vec2 a, Vec2 b)
+		{
+			return { Min(a.x, b.x), Min(a.y, b.y), Abs(b.x - a.x), Abs(b.y - a.y) };
+		}
+
+		Size computeSize() const override
+		{
+			return size;
+		}
+
+		void update(Rect rect, Optional<Vec2> cursorPos) override
+		{
+			m_rect = rect;
+
+			updateData();
+			points = {};
+
+			if (m_indexTask.isValid() && m_indexTask.isReady())
+			{
+				m_index = m_indexTask.get();
+			}
+			m_staleTasks.remove_if([](const AsyncTask<ScatterIndex>& task) { return task.isReady(); });
+
+			const Optional<Vec2> localCursor = cursorPos.map([&](Vec2 v) { return v - m_rect.pos; });
+			updateView(localCursor);
+
+			const CellsKey key{ m_dataSerial, view(), rect.size };
+			if (m_cellsKey != key)
+			{
+				rebuildCells();
+				m_cellsKey = key;
+			}
+
+			updateHover(localCursor);
+		}
+
+		void updateData()
+		{
+			const DataKey key{ version, points.data(), points.size() };
+			if (m_dataKey == key)
+			{
+				return;
+			}
+			m_dataKey = key;
+			m_dataSerial++;
+
+			auto copied = std::make_shared<Array<Float2>>(points.begin(), points.end());
+
+			// NaNや無限大の点は範囲に含めない (Min/Maxは一度NaNになると戻らない)
+			RectF bounds{ 0, 0, 1, 1 };
+			Vec2 lo{ Math::Inf, Math::Inf };
+			Vec2 hi{ -Math::Inf, -Math::Inf };
+			for (const auto& point : *copied)
+			{
+				if (IsFinite(point))
+				{
+					lo = { Min<double>(lo.x, point.x), Min<double>(lo.y, point.y) };
+					hi = { Max<double>(hi.x, point.x), Max<double>(hi.y, point.y) };
+				}
+			}
+			if (lo.x <= hi.x)
+			{
+				const Vec2 margin = Vec2{ Max(hi.x - lo.x, 1e-6), Max(hi.y - lo.y, 1e-6) } * 0.05;
+				bounds = RectF{ lo - margin, hi - lo + margin * 2 };
+			}
+			m_bounds = bounds;
+			m_points = copied;
+			m_index = none;
+
+			if (m_indexTask.isValid())
+			{
+				m_staleTasks.push_back(std::move(m_indexTask));
+			}
+			m_indexTask = Async([copied, bounds]()
+			{
+				return ScatterIndex::Build(*copied, bounds);
+			});
+		}
+
+		// 左ドラッグで選択した範囲に拡大し、右ドラッグで移動、右クリックで全体に戻す
+		void updateView(Optional<Vec2> localCursor)
+		{
+			const RectF area = this->area();
+			if (area.w <= 0 || area.h <= 0)
+			{
+				return;
+			}
+
+			if (m_selectionBegin)
+			{
+				if (localCursor)
+				{
+					m_selectionEnd = ClampToArea(*localCursor, area);
+				}
+
+				if (not MouseL.pressed())
+				{
+					const RectF selection = SelectionRect(*m_selectionBegin, m_selectionEnd);
+					if (selection.w >= Config::MinSelectionSize && selection.h >= Config::MinSelectionSize)
+					{
+						const RectF current = view();
+						const Vec2 a = toData(selection.bl(), current, area);
+						const Vec2 b = toData(selection.tr(), current, area);
+						m_view = SelectionRect(a, b);
+					}
+					m_selectionBegin = none;
+				}
+				return;
+			}
+
+			if (m_panBegin)
+			{
+				if (MouseR.pressed())
+				{
+					const Vec2 delta = Cursor::DeltaF();
+					const RectF current = view();
+					m_view = current.movedBy(-delta.x / area.w * current.w, delta.y / area.h * current.h);
+				}
+				else
+				{
+					if (localCursor && localCursor->distanceFrom(*m_panBegin) < Config::ClickThreshold)
+					{
+						m_view = none;
+					}
+					m_panBegin = none;
+				}
+				return;
+			}
+
+			if (not localCursor || not RectF{ m_rect.size }.contains(*localCursor))
+			{
+				return;
+			}
+
+			if (MouseL.down())
+			{
+				m_selectionBegin = m_selectionEnd = ClampToArea(*localCursor, area);
+			}
+			else if (MouseR.down())
+			{
+				m_panBegin = *localCursor;
+			}
+		}
+
+		// 同じ升目に入る点は1つだけ描く
+		void rebuildCells()
+		{
+			m_cells.clear();
+
+			const RectF area = this->area();
+			const int32 columns = static_cast<int32>(Math::Ceil(area.w / Config::PointSize));
+			const int32 rows = static_cast<int32>(Math::Ceil(area.h / Config::PointSize));
+			if (not m_points || columns <= 0 || rows <= 0)
+			{
+				return;
+			}
+
+			const RectF view = this->view();
+			Array<uint8> occupied(static_cast<size_t>(columns) * rows, 0);
+
+			auto visit = [&](uint32 i)
+			{
+				// 範囲の外とNaNはintに変換する前に除く
+				const Vec2 local = toLocal((*m_points)[i], view, area);
+				const double cellX = Math::Floor((local.x - area.x) / Config::PointSize);
+				const double cellY = Math::Floor((local.y - area.y) / Config::PointSize);
+				if (not (0.0 <= cellX && cellX < columns && 0.0 <= cellY && cellY < rows))
+				{
+					return;
+				}
+				const int32 x = static_cast<int32>(cellX);
+				const int32 y = static_cast<int32>(cellY);
+
+				auto& cell = occupied[static_cast<size_t>(y) * columns + x];
+				if (not cell)
+				{
+					cell = 1;
+					m_cells.emplace_back(
+						area.x + x * Config::PointSize,
+						area.y + y * Config::PointSize);
+				}
+			};
+
+			if (m_index)
+			{
+				// 表示範囲にかかる索引の升目だけを調べる
+				m_index->forEach(m_index->cellOf(view.pos), m_index->cellOf(view.br()), visit);
+			}
+			else
+			{
+				for (size_t i = 0; i < m_points->size(); i++)
+				{
+					visit(static_cast<uint32>(i));
+				}
+			}
+		}
+
+		void updateHover(Optional<Vec2> localCursor)
+		{
+			m_hovered = none;
+
+			const RectF area = this->area();
+			if (not m_index || not localCursor || not area.contains(*localCursor) || m_selectionBegin || m_panBegin)
+			{
+				return;
+			}
+
+			// カーソルからHoverRadiusピクセル以内の升目だけを調べる
+			const RectF view = this->view();
+			const Vec2 radius{ Config::HoverRadius / area.w * view.w, Config::HoverRadius / area.h * view.h };
+			const Vec2 center = toData(*localCursor, view, area);
+
+			double nearest = Config::HoverRadius * Config::HoverRadius;
+			m_index->forEach(m_index->cellOf(center - radius), m_index->cellOf(center + radius), [&](uint32 i)
+			{
+				const Vec2 local = toLocal((*m_points)[i], view, area);
+				const double distance = local.distanceFromSq(*localCursor);
+				if (distance <= nearest)
+				{
+					nearest = distance;
+					m_hovered = i;
+					m_hoveredPos = local;
+				}
+			});
+		}
+
+		void draw() const override
+		{
+			m_rect
+				.draw(Config::BackgroundColor)
+				.drawFrame(1, 0, Config::FrameColor);
+
+			{
+				const Transformer2D transform{ Mat3x2::Translate(m_rect.pos) };
+
+				for (const auto& cell : m_cells)
+				{
+					RectF{ Vec2{ cell }, Config::PointSize }.draw(Config::PointColor);
+				}
+
+				if (m_hovered)
+				{
+					Circle{ m_hoveredPos, Config::PointSize * 1.5 }.draw(Config::HoveredPointColor);
+				}
+
+				if (m_selectionBegin)
+				{
+					SelectionRect(*m_selectionBegin, m_selectionEnd).draw(Config::SelectionColor);
+				}
+			}
+		}
+	};
+
+	Optional<size_t> GUIManager::scatter(const StringView id, std::span<const Float2> points, SizeF size, uint64 version)
+	{
+		auto& window = getCurrentWindowImpl();
+		auto& control = window.nextStatefulControl<Scatter>(id.hash());
+
+		if (size.x <= 0.0)
+		{
+			size.x = window.availableWidth().value_or(0.0);
+		}
+
+		control.points = points;
+		control.version = version;
+		control.size = size.asPoint();
+
+		if (not window.updateControl(control))
+		{
+			return none;
+		}
+		return control.hoveredPoint();
+	}
+
+	// StripChart
+
+	StripChannel::StripChannel(size_t capacity, ColorF color)
+		: m_samples(std::bit_ceil(Max<size_t>(capacity, size_t{ 1 } << BaseShift)), 0.0f)
+		, m_mask(m_samples.size() - 1)
+		, m_color(color)
+	{
+		for (size_t size = m_samples.size() >> BaseShift; size > 0; size >>= 1)
+		{
+			m_levels.emplace_back(size);
+		}
+	}
+
+	void StripChannel::push(float value)
+	{
+		push(std::span<const float>{ &value, 1 });
+	}
+
+	// 書き込む範囲を先に公開してから書くので、読み手は読んだ後にm_claimedを見れば上書きされたかがわかる
+	void StripChannel::push(std::span<const float> values)
+	{
+		uint64 index = m_written.load(std::memory_order_relaxed);
+		m_claimed.store(index + values.size(), std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+
+		for (float value : values)
+		{
+			storeSample(index++, value);
+		}
+		m_written.store(index, std::memory_order_release);
+	}
+
+	void StripChannel::update()
+	{
+		const uint64 written = m_written.load(std::memory_order_acquire);
+		if (written == m_end)
+		{
+			return;
+		}
+
+		// 追いつけなかった分は捨てて、保持している範囲だけを取り込む
+		const uint64 retained = written - Min<uint64>(written, capacity());
+		uint64 begin = Max(m_end, retained);
+		uint64 end = written;
+		m_begin = Max(m_begin, retained);
+		m_end = written;
+
+		while (begin < end)
+		{
+			rebuildBlocks(begin, end);
+
+			// 読んでいる間に生産者が一周したら、上書きされたサンプルを捨ててそこにかかるブロックを作り直す
+			const uint64 overrun = Min(overwrittenEnd(), m_end);
+			if (overrun <= m_begin)
+			{
+				break;
+			}
+			m_begin = overrun;
+			begin = overrun;
+			end = Min(m_end, ((overrun >> BaseShift) + 1) << BaseShift);
+		}
+	}
+
+	StripChannel::MinMax StripChannel::minMax(uint64 begin, uint64 end) const
+	{
+		begin = Max(begin, m_begin);
+		end = Min(end, m_end);
+
+		// 揃っている位置からは入る限り大きいブロックを使う
+		MinMax result;
+		uint64 firstSample = end;
+		while (begin < end)
+		{
+			const int32 shift = Min(
+				std::countr_zero(begin),
+				static_cast<int32>(std::bit_width(end - begin)) - 1);
+
+			if (shift < BaseShift)
+			{
+				const float value = loadSample(begin);
+				result.min = Min(result.min, value);
+				result.max = Max(result.max, value);
+				firstSample = Min(firstSample, begin);
+				begin++;
+				continue;
+			}
+
+			const size_t level = Min<size_t>(shift - BaseShift, m_levels.size() - 1);
+			const auto& blocks = m_levels[level];
+			const MinMax& value = blocks[(begin >> (BaseShift + level)) & (blocks.size() - 1)];
+			result.min = Min(result.min, value.min);
+			result.max = Max(result.max, value.max);
+			begin += uint64{ 1 } << (BaseShift + level);
+		}
+
+		// ブロックはGUIスレッドのものなので、直接読んだサンプルだけを確かめる
+		if (firstSample < overwrittenEnd())
+		{
+			return {};
+		}
+		return result;
+	}
+
+	float StripChannel::loadSample(uint64 index) const
+	{
+		// 生産者と同時に触ることがあるので、ずれた値にならないように不可分に読み書きする
+		return std::atomic_ref<float>{ const_cast<float&>(m_samples[index & m_mask]) }.load(std::memory_order_relaxed);
+	}
+
+	void StripChannel::storeSample(uint64 index, float value)
+	{
+		std::atomic_ref<float>{ m_samples[index & m_mask] }.store(value, std::memory_order_relaxed);
+	}
+
+	uint64 StripChannel::overwrittenEnd() const
+	{
+		std::atomic_thread_fence(std::memory_order_acquire);
+		const uint64 claimed = m_claimed.load(std::memory_order_relaxed);
+		return claimed - Min<uint64>(claimed, capacity());
+	}
+
+	// [begin, end)にかかるブロックを下の段から作り直す
+	void StripChannel::rebuildBlocks(uint64 begin, uint64 end)
+	{
+		for (size_t level = 0; level < m_levels.size(); level++)
+		{
+			const int32 shift = BaseShift + static_cast<int32>(level);
+			auto& blocks = m_levels[level];
+			const uint64 blockMask = blocks.size() - 1;
+
+			for (uint64 block = begin >> shift; block <= (end - 1) >> shift; block++)
+			{
+				MinMax value;
+				if (level == 0)
+				{
+					const uint64 last = Min(m_end, (block + 1) << shift);
+					for (uint64 i = Max(block << shift, m_begin); i < last; i++)
+					{
+						const float sample = loadSample(i);
+						value.min = Min(value.min, sample);
+						value.max = Max(value.max, sample);
+					}
+				}
+				else
+				{
+					const auto& children = m_levels[level - 1];
+					const uint64 childMask = children.size() - 1;
+					const uint64 middle = (block * 2 + 1) << (shift - 1);
+
+					// 捨てたサンプルだけの前半と、まだサンプルが届いていない後半は使わない
+					if (m_begin < middle)
+					{
+						value = children[(block * 2) & childMask];
+					}
+					if (middle < m_end)
+					{
+						const MinMax& right = children[(block * 2 + 1) & childMask];
+						value.min = Min(value.min, right.min);
+						value.max = Max(value.max, right.max);
+					}
+				}
+				blocks[block & blockMask] = value;
+			}
+		}
+	}
+
+	class StripChart : public IControl
+	{
+	public:
+
+		using Config = Config::StripChart;
+
+		// update()の間だけ有効
+		const Array<StripChannel*>* channels = nullptr;
+
+		size_t samples = 0;
+
+		Size size{ 0, 0 };
+
+	private:
+
+		Rect m_rect{ 0, 0, 0, 0 };
+
+		// ローカル座標
+		Array<LineString> m_lines;
+
+		Array<ColorF> m_colors;
+
+		Size computeSize() const override
+		{
+			return size;
+		}
+
+		void update(Rect rect, Optional<Vec2>) override
+		{
+			m_rect = rect;
+			m_lines.resize(channels->size());
+			m_colors.resize(channels->size());
+
+			const RectF area = RectF{ rect.size }.stretched(-Config::Padding);
+			const int32 columns = static_cast<int32>(area.w);
+			const uint64 span = Max<uint64>(samples, 1);
+
+			// 1列ごとの最小値と最大値を集め、全系列の範囲で縦方向を合わせる
+			Array<Array<StripChannel::MinMax>> envelopes(channels->size());
+			float lo = std::numeric_limits<float>::infinity();
+			float hi = -std::numeric_limits<float>::infinity();
+
+			for (size_t i = 0; i < channels->size(); i++)
+			{
+				const StripChannel& channel = *(*channels)[i];
+				m_colors[i] = channel.color();
+
+				const uint64 end = channel.endIndex();
+				const uint64 start = end - Min(end, span);
+				for (int32 column = 0; column < columns; column++)
+				{
+					// 右端が最新のサンプルになるように合わせる
+					const uint64 offset = span - (end - start);
+					const uint64 first = column * span / columns;
+					const uint64 last = (column + 1) * span / columns;
+					StripChannel::MinMax value;
+					if (last > offset)
+					{
+						value = channel.minMax(start + Max(first, offset) - offset, start + last - offset);
+					}
+					envelopes[i].push_back(value);
+					if (not value.isEmpty())
+					{
+						lo = Min(lo, value.min);
+						hi = Max(hi, value.max);
+					}
+				}
+			}
+
+			if (not (lo <= hi))
+			{
+				lo = 0.0f;
+				hi = 1.0f;
+			}
+			if (hi - lo < 1e-6f)
+			{
+				lo -= 0.5f;
+				hi += 0.5f;
+			}
+			const double scale = area.h / (hi - lo);
+
+			for (size_t i = 0; i < channels->size(); i++)
+			{
+				auto& line = m_lines[i];
+				line.clear();
+				for (int32 column = 0; column < columns; column++)
+				{
+					const auto& value = envelopes[i][column];
+					if (value.isEmpty())
+					{
+						continue;
+					}
+
+					// 最小値と最大値を交互につないで包絡線にする
+					const double x = area.x + column + 0.5;
+					const double yMin = area.bottomY() - (value.min - lo) * scale;
+					const double yMax = area.bottomY() - (value.max - lo) * scale;
+					const bool flip = line.size() % 4 == 2;
+					line.emplace_back(x, flip ? yMax : yMin);
+					line.emplace_back(x, flip ? yMin : yMax);
+				}
+			}
+
+			channels = nullptr;
+		}
+
+		void draw() const override
+		{
+			m_rect
+				.draw(Config::BackgroundColor)
+				.drawFrame(1, 0, Config::FrameColor);
+
+			const Transformer2D transform{ Mat3x2::Translate(m_rect.pos) };
+			for (size_t i = 0; i < m_lines.size(); i++)
+			{
+				m_lines[i].draw(Config::LineThickness, m_colors[i]);
+			}
+		}
+	};
+
+	void GUIManager::stripChart(const StringView id, const Array<StripChannel*>& channels, size_t samples, SizeF size)
+	{
+		auto& window = getCurrentWindowImpl();
+
+		for (auto* channel : channels)
+		{
+			channel->update();
+		}
+
+		auto& control = window.nextStatefulControl<StripChart>(id.hash());
+
+		if (size.x <= 0.0)
+		{
+			size.x = window.availableWidth().value_or(0.0);
+		}
+
+		control.channels = &channels;
+		control.samples = samples;
+		control.size = size.asPoint();
+
+		window.updateControl(control);
+	}
+
+	// Heatmap
+
+	// 値を[min, max]で0〜255の番号にしてLUTの色に置き換える
+	static void ApplyColormap(const float* values, Color* out, size_t count, float min, float max, const std::array<Color, 256>& lut)
+	{
+		const float scale = max > min ? 255.0f / (max - min) : 0.0f;
+		size_t i = 0;
+
+#ifdef SASAGUI_USE_SSE2
+		const __m128 vMin = _mm_set1_ps(min);
+		const __m128 vScale = _mm_set1_ps(scale);
+		const __m128 vLower = _mm_setzero_ps();
+		const __m128 vUpper = _mm_set1_ps(255.0f);
+		alignas(16) int32 indices[4];
+
+		for (; i + 4 <= count; i += 4)
+		{
+			__m128 v = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(values + i), vMin), vScale);
+			// NaNはmaxの第2引数 (0) になる
+			v = _mm_min_ps(_mm_max_ps(v, vLower), vUpper);
+			_mm_store_si128(reinterpret_cast<__m128i*>(indices), _mm_cvttps_epi32(v));
+			out[i + 0] = lut[indices[0]];
+			out[i + 1] = lut[indices[1]];
+			out[i + 2] = lut[indices[2]];
+			out[i + 3] = lut[indices[3]];
+		}
+#endif
+
+		for (; i < count; i++)
+		{
+			const float v = (values[i] - min) * scale;
+			out[i] = lut[v > 0.0f ? static_cast<int32>(Min(v, 255.0f)) : 0];
+		}
+	}
+
+	// 色に変換した画像とテクスチャを保持する (描画はImageで行う)
+	class Heatmap : public IControl
+	{
+	public:
+
+		const DynamicTexture& texture() const { return m_texture; }
+
+		void updateTexture(std::span<const float> values, size_t columns, size_t rows, ColormapType colormap, float min, float max, Optional<std::pair<size_t, size_t>> dirtyRows)
+		{
+			if (m_colormap != colormap)
+			{
+				m_colormap = colormap;
+				for (size_t i = 0; i < m_lut.size(); i++)
+				{
+					m_lut[i] = Colormap01(i / 255.0, colormap);
+				}
+				m_valid = false;
+			}
+
+			if (m_min != min || m_max != max)
+			{
+				m_min = min;
+				m_max = max;
+				m_valid = false;
+			}
+
+			const Size size{ static_cast<int32>(columns), static_cast<int32>(rows) };
+			if (m_image.size() != size)
+			{
+				m_image = s3d::Image{ size };
+				m_valid = false;
+			}
+
+			rows = Min(rows, columns > 0 ? values.size() / columns : 0);
+
+			size_t begin = 0;
+			size_t end = rows;
+			if (m_valid && dirtyRows)
+			{
+				begin = Min(dirtyRows->first, rows);
+				end = Clamp(dirtyRows->second, begin, rows);
+			}
+
+			if (begin < end)
+			{
+				ApplyColormap(values.data() + begin * columns, m_image.data() + begin * columns, (end - begin) * columns, min, max, m_lut);
+			}
+
+			// 変わった行だけを送る
+			if (not m_valid || m_texture.size() != size)
+			{
+				m_texture = DynamicTexture{ m_image };
+			}
+			else if (begin < end)
+			{
+				m_texture.fillRegion(m_image, Rect{ 0, static_cast<int32>(begin), size.x, static_cast<int32>(end - begin) });
+			}
+			m_valid = true;
+		}
+
+	private:
+
+		s3d::Image m_image;
+
+		DynamicTexture m_texture;
+
+		std::array<Color, 256> m_lut;
+
+		Optional<ColormapType> m_colormap;
+
+		float m_min = 0.0f;
+
+		float m_max = 0.0f;
+
+		// falseのときは次の更新ですべての行を変換し直す
+		bool m_valid = false;
+
+		Size computeSize() const override
+		{
+			return { 0, 0 };
+		}
+
+		void update(Rect, Optional<Vec2>) override
+		{ }
+
+		void draw() const override
+		{ }
+	};
+
+	void GUIManager::heatmap(const StringView id, std::span<const float> values, size_t columns, size_t rows, SizeF size, ColormapType colormap, float min, float max, Optional<std::pair<size_t, size_t>> dirtyRows)
+	{
+		auto& window = getCurrentWindowImpl();
+
+		auto& heatmap = window.nextStatefulControl<Heatmap>(id.hash());
+
+		// 測定パスでは大きさしか使わないので、テクスチャの転送は本番の評価だけで行う
+		if (not window.isMeasuring())
+		{
+			heatmap.updateTexture(values, columns, rows, colormap, min, max, dirtyRows);
+		}
+
+		if (size.x <= 0.0)
+		{
+			size.x = window.availableWidth().value_or(0.0);
+		}
+
+		// 1枚のテクスチャとして、セルの境界がぼやけないように描く
+		auto& image = window.nextStatelessControl<Image>();
+		image.texture = heatmap.texture().resized(size);
+		image.diffuse = Palette::White;
+		image.sampler = SamplerState::ClampNearest;
+
+		window.updateControl(image);
+	}
+
+	// Histogram
+
+	// [0, count)を分割してfunc(begin, end, chunk)を並列に呼び、終わるまで待つ
+	template<class Func>
+	static size_t ForEachChunk(size_t count, size_t threshold, Func func)
+	{
+		const size_t chunks = count >= threshold ? Max<size_t>(Threading::GetConcurrency(), 1) : 1;
+		const size_t chunkSize = (count + chunks - 1) / Max<size_t>(chunks, 1);
+
+		// 先頭の範囲は呼び出したスレッドで処理する
+		Array<AsyncTask<void>> tasks;
+		for (size_t chunk = 1; chunk < chunks; chunk++)
+		{
+			const size_t begin = Min(count, chunk * chunkSize);
+			const size_t end = Min(count, begin + chunkSize);
+			tasks.push_back(Async([=]() { func(begin, end, chunk); }));
+		}
+		func(0, Min(count, chunkSize), 0);
+
+		for (auto& task : tasks)
+		{
+			task.wait();
+		}
+		return chunks;
+	}
+
+	// NaNは範囲に含めない (NaNしかないときは{ Inf, -Inf })
+	template<class T>
+	static std::pair<double, double> MinMaxValues(const T* first, const T* last)
+	{
+		if constexpr (std::is_floating_point_v<T>)
+		{
+			T lo = std::numeric_limits<T>::infinity();
+			T hi = -std::numeric_limits<T>::infinity();
+
+#ifdef SASAGUI_USE_SSE2
+			if constexpr (std::is_same_v<T, float>)
+			{
+				__m128 vLo = _mm_set1_ps(lo);
+				__m128 vHi = _mm_set1_ps(hi);
+				for (; last - first >= 4; first += 4)
+				{
+					// どちらかがNaNのときは2つ目を返すので、NaNは読み飛ばされる
+					const __m128 v = _mm_loadu_ps(first);
+					vLo = _mm_min_ps(v, vLo);
+					vHi = _mm_max_ps(v, vHi);
+				}
+
+				alignas(16) float los[4];
+				alignas(16) float his[4];
+				_mm_store_ps(los, vLo);
+				_mm_store_ps(his, vHi);
+				lo = std::min({ los[0], los[1], los[2], los[3] });
+				hi = std::max({ his[0], his[1], his[2], his[3] });
+			}
+#endif
+
+			for (; first != last; ++first)
+			{
+				if (not std::isnan(*first))
+				{
+					lo = Min(lo, *first);
+					hi = Max(hi, *first);
+				}
+			}
+			return { static_cast<double>(lo), static_cast<double>(hi) };
+		}
+		else
+		{
+			const auto [lo, hi] = std::minmax_element(first, last);
+			return { static_cast<double>(*lo), static_cast<double>(*hi) };
+		}
+	}
+
+	// 値を[min, max]でcounts.size()個の区間に振り分けて数える
+	template<class T>
+	static void CountBins(const T* values, size_t count, double min, double max, Array<uint32>& counts)
+	{
+		const size_t bins = counts.size();
+		const double scale = max > min ? bins / (max - min) : 0.0;
+		size_t i = 0;
+
+#ifdef SASAGUI_USE_SSE2
+		if constexpr (std::is_same_v<T, float>)
+		{
+			const __m128 vMin = _mm_set1_ps(static_cast<float>(min));
+			const __m128 vScale = _mm_set1_ps(static_cast<float>(scale));
+			const __m128 vLower = _mm_setzero_ps();
+			const __m128 vUpper = _mm_set1_ps(static_cast<float>(bins - 1));
+			alignas(16) int32 indices[4];
+
+			for (; i + 4 <= count; i += 4)
+			{
+				const __m128 x = _mm_loadu_ps(values + i);
+				__m128 v = _mm_mul_ps(_mm_sub_ps(x, vMin), vScale);
+				v = _mm_min_ps(_mm_max_ps(v, vLower), vUpper);
+				_mm_store_si128(reinterpret_cast<__m128i*>(indices), _mm_cvttps_epi32(v));
+
+				// NaNの要素は数えない
+				const int32 valid = _mm_movemask_ps(_mm_cmpord_ps(x, x));
+				if (valid == 0b1111)
+				{
+					counts[indices[0]]++;
+					counts[indices[1]]++;
+					counts[indices[2]]++;
+					counts[indices[3]]++;
+				}
+				else
+				{
+					for (int32 lane = 0; lane < 4; lane++)
+					{
+						if (valid & (1 << lane))
+						{
+							counts[indices[lane]]++;
+						}
+					}
+				}
+			}
+		}
+#endif
+
+		for (; i < count; i++)
+		{
+			if constexpr (std::is_floating_point_v<T>)
+			{
+				if (std::isnan(values[i]))
+				{
+					continue;
+				}
+			}
+
+			const double v = (static_cast<double>(values[i]) - min) * scale;
+			counts[v > 0.0 ? static_cast<size_t>(Min(v, bins - 1.0)) : 0]++;
+		}
+	}
+
+	struct HistogramCounts
+	{
+		Array<uint32> counts;
+
+		double min = 0.0;
+
+		double max = 0.0;
+	};
+
+	// 範囲ごとに最小値と最大値、度数を求めてからまとめる
+	template<class T>
+	static HistogramCounts CountHistogram(std::span<const T> samples, size_t bins)
+	{
+		using Config = Config::Histogram;
+
+		HistogramCounts result{ .counts = Array<uint32>(bins, 0) };
+		if (samples.empty() || bins == 0)
+		{
+			return result;
+		}
+
+		Array<std::pair<double, double>> ranges(Max<size_t>(Threading::GetConcurrency(), 1));
+		const size_t chunks = ForEachChunk(samples.size(), Config::ParallelThreshold, [&](size_t begin, size_t end, size_t chunk)
+		{
+			if (begin < end)
+			{
+				ranges[chunk] = MinMaxValues(samples.data() + begin, samples.data() + end);
+			}
+			else
+			{
+				ranges[chunk] = { Math::Inf, -Math::Inf };
+			}
+		});
+
+		double min = Math::Inf;
+		double max = -Math::Inf;
+		for (size_t i = 0; i < chunks; i++)
+		{
+			min = Min(min, ranges[i].first);
+			max = Max(max, ranges[i].second);
+		}
+
+		// NaNしかなかった
+		if (not (min <= max))
+		{
+			return result;
+		}
+		result.min = min;
+		result.max = max;
+
+		Array<Array<uint32>> counts(chunks, Array<uint32>(bins, 0));
+		ForEachChunk(samples.size(), Config::ParallelThreshold, [&](size_t begin, size_t end, size_t chunk)
+		{
+			CountBins(samples.data() + begin, end - begin, min, max, counts[chunk]);
+		});
+
+		for (const auto& chunkCounts : counts)
+		{
+			for (size_t i = 0; i < bins; i++)
+			{
+				result.counts[i] += chunkCounts[i];
+			}
+		}
+		return result;
+	}
+
+	class Histogram : public IControl
+	{
+	public:
+
+		using Config = Config::Histogram;
+
+		Size size{ 0, 0 };
+
+		bool logScale = false;
+
+		// サンプルが変わったときだけ数え直す
+		// 大きな配列は写してから別スレッドで数え、終わるまでは前の結果を表示する
+		template<class T>
+		void updateCounts(std::span<const T> samples, uint64 version, size_t bins)
+		{
+			if (m_task.isValid() && m_task.isReady())
+			{
+				setCounts(m_task.get());
+			}
+
+			const CacheKey key{ version, samples.data(), samples.size(), bins, typeid(T).hash_code() };
+			if (m_cacheKey == key)
+			{
+				return;
+			}
+
+			// 数えている間に変わったサンプルは、終わってから数え直す
+			if (m_task.isValid())
+			{
+				return;
+			}
+			m_cacheKey = key;
+
+			if (samples.size() < Config::ParallelThreshold)
+			{
+				setCounts(CountHistogram(samples, bins));
+				return;
+			}
+
+			m_task = Async([copied = Array<T>(samples.begin(), samples.end()), bins]()
+			{
+				return CountHistogram(std::span<const T>{ copied }, bins);
+			});
+		}
+
+	private:
+
+		struct CacheKey
+		{
+			uint64 version;
+
+			const void* data;
+
+			size_t size;
+
+			size_t bins;
+
+			size_t type;
+
+			bool operator==(const CacheKey&) const = default;
+		};
+
+		// 数えた (または数えている) サンプル
+		Optional<CacheKey> m_cacheKey;
+
+		AsyncTask<HistogramCounts> m_task;
+
+		Array<uint32> m_counts;
+
+		double m_min = 0.0;
+
+		double m_max = 0.0;
+
+		void setCounts(HistogramCounts counts)
+		{
+			m_counts = std::move(counts.counts);
+			m_min = counts.min;
+			m_max = counts.max;
+		}
+
+		Rect m_rect{ 0, 0, 0, 0 };
+
+		Size computeSize() const override
+		{
+			return size;
+		}
+
+		void update(Rect rect, Optional<Vec2>) override
+		{
+			m_rect = rect;
+		}
+
+		void draw() const override
+		{
+			m_rect
+				.draw(Config::BackgroundColor)
+				.drawFrame(1, 0, Config::FrameColor);
+
+			if (m_counts.empty())
+			{
+				return;
+			}
+
+			const RectF area = m_rect.stretched(-Config::Padding);
+			const auto scaled = [this](uint32 count) {
+				return logScale ? Math::Log10(1.0 + count) : static_cast<double>(count);
+			};
+
+			const double top = scaled(*std::max_element(m_counts.begin(), m_counts.end()));
+			if (top <= 0.0)
+			{
+				return;
+			}
+
+			const double barWidth = area.w / m_counts.size();
+			for (size_t i = 0; i < m_counts.size(); i++)
+			{
+				const double height = area.h * scaled(m_counts[i]) / top;
+				RectF{ area.x + barWidth * i, area.bottomY() - height, Max(barWidth - 1.0, 1.0), height }.draw(Config::BarColor);
+			}
+		}
+	};
+
+	template<class T>
+	static void HistogramImpl(WindowImpl& window, const StringView id, std::span<const T> samples, SizeF size, uint64 version, Optional<size_t> bins, bool logScale)
+	{
+		using Config = Config::Histogram;
+
+		auto& control = window.nextStatefulControl<Histogram>(id.hash());
+
+		if (size.x <= 0.0)
+		{
+			size.x = window.availableWidth().value_or(0.0);
+		}
+
+		// 指定がなければライスの規則 (2 * n^(1/3)) で決め、棒が細くなりすぎないようにする
+		const size_t maxBins = static_cast<size_t>(Max(1.0, (size.x - Config::Padding * 2) / Config::MinBarWidth));
+		const size_t binCount = bins
+			? Max<size_t>(*bins, 1)
+			: Clamp<size_t>(static_cast<size_t>(2.0 * Math::Pow(static_cast<double>(samples.size()), 1.0 / 3.0)), 1, maxBins);
+
+		control.updateCounts(samples, version, binCount);
+		control.size = size.asPoint();
+		control.logScale = logScale;
+
+		window.updateControl(control);
+	}
+
+	void GUIManager::histogram(const StringView id, std::span<const float> samples, SizeF size, uint64 version, Optional<size_t> bins, bool logScale)
+	{
+		HistogramImpl(getCurrentWindowImpl(), id, samples, size, version, bins, logScale);
+	}
+
+	void GUIManager::histogram(const StringView id, std::span<const double> samples, SizeF size, uint64 version, Optional<size_t> bins, bool logScale)
+	{
+		HistogramImpl(getCurrentWindowImpl(), id, samples, size, version, bins, logScale);
+	}
+
+	void GUIManager::histogram(const StringView id, std::span<const int32> samples, SizeF size, uint64 version, Optional<size_t> bins, bool logScale)
+	{
+		HistogramImpl(getCurrentWindowImpl(), id, samples, size, version, bins, logScale);
+	}
+
+	// Timeline
+
+	size_t TimelineData::addTrack(const StringView name)
+	{
+		m_tracks.push_back(Track{ .name = String{ name } });
+		return m_tracks.size() - 1;
+	}
+
+	void TimelineData::addSpan(size_t track, const TimelineSpan& span)
+	{
+		m_tracks[track].levels.front().spans.push_back(span);
+	}
+
+	// 隙間がgapより短いスパンを1つにまとめる (色は最も長いスパンのもの)
+	static Array<TimelineSpan> MergeSpans(const Array<TimelineSpan>& spans, double gap)
+	{
+		Array<TimelineSpan> merged;
+		double longest = 0.0;
+
+		for (const auto& span : spans)
+		{
+			if (merged && span.begin - merged.back().end < gap)
+			{
+				auto& current = merged.back();
+				current.end = Max(current.end, span.end);
+				if (span.end - span.begin > longest)
+				{
+					longest = span.end - span.begin;
+					current.color = span.color;
+				}
+				continue;
+			}
+			merged.push_back(span);
+			longest = span.end - span.begin;
+		}
+		return merged;
+	}
+
+	void TimelineData::build()
+	{
+		m_begin = Math::Inf;
+		m_end = -Math::Inf;
+		for (auto& track : m_tracks)
+		{
+			track.levels.resize(1);
+			for (const auto& span : track.levels.front().spans)
+			{
+				m_begin = Min(m_begin, span.begin);
+				m_end = Max(m_end, span.end);
+			}
+		}
+		if (m_begin > m_end)
+		{
+			m_begin = m_end = 0.0;
+		}
+
+		const double extent = Max(m_end - m_begin, 1e-9);
+
+		// 隙間の閾値を倍々にしながら、数が半分以下になった段だけを残す
+		std::for_each(std::execution::par, m_tracks.begin(), m_tracks.end(), [extent](Track& track)
+		{
+			auto& raw = track.levels.front().spans;
+			std::sort(raw.begin(), raw.end(), [](const TimelineSpan& a, const TimelineSpan& b) { return a.begin < b.begin; });
+
+			for (double gap = extent / (1 << 30); gap <= extent && track.levels.back().spans.size() > 1; gap *= 2)
+			{
+				Array<TimelineSpan> merged = MergeSpans(track.levels.back().spans, gap);
+				if (merged.size() * 2 <= track.levels.back().spans.size())
+				{
+					track.levels.push_back(Level{ gap, std::move(merged) });
+				}
+			}
+		});
+	}
+
+	Optional<size_t> TimelineData::findSpan(size_t track, double time, double tolerance) const
+	{
+		const auto& spans = this->spans(track);
+
+		// time + tolerance以前に始まる最後のスパン
+		auto itr = std::upper_bound(spans.begin(), spans.end(), time + tolerance,
+			[](double t, const TimelineSpan& span) { return t < span.begin; });
+		if (itr == spans.begin())
+		{
+			return none;
+		}
+		--itr;
+
+		if (itr->end < time - tolerance)
+		{
+			return none;
+		}
+		return static_cast<size_t>(itr - spans.begin());
+	}
+
+	void TimelineData::mergedSpans(size_t track, double begin, double end, double pixelTime, Array<TimelineSpan>& out) const
+	{
+		out.clear();
+
+		// 1ピクセルより細かくまとめた段のうち最も粗いものを使う
+		const auto& levels = m_tracks[track].levels;
+		size_t level = 0;
+		while (level + 1 < levels.size() && levels[level + 1].gap <= pixelTime)
+		{
+			level++;
+		}
+		const auto& spans = levels[level].spans;
+
+		auto itr = std::upper_bound(spans.begin(), spans.end(), begin,
+			[](double t, const TimelineSpan& span) { return t < span.begin; });
+		if (itr != spans.begin())
+		{
+			--itr;
+		}
+
+		// 表示する幅でもう一度まとめる
+		double longest = 0.0;
+		for (; itr != spans.end() && itr->begin < end; ++itr)
+		{
+			if (itr->end < begin)
+			{
+				continue;
+			}
+
+			if (out && itr->begin - out.back().end < pixelTime)
+			{
+				auto& current = out.back();
+				current.end = Max(current.end, itr->end);
+				if (itr->end - itr->begin > longest)
+				{
+					longest = itr->end - itr->begin;
+					current.color = itr->color;
+				}
+				continue;
+			}
+			out.push_back(*itr);
+			longest = itr->end - itr->begin;
+		}
+	}
+
+	class Timeline : public IControl
+	{
+	public:
+
+		using Config = Config::Timeline;
+
+		void init(const TimelineData& data, const Font& font)
+		{
+			m_data = &data;
+			m_trackHeight = font.height() + Config::TrackPadding * 2.0;
+
+			m_labels.resize(data.trackCount());
+			for (size_t i = 0; i < data.trackCount(); i++)
+			{
+				if (m_labels[i].text != data.trackName(i))
+				{
+					m_labels[i] = font(data.trackName(i));
+				}
+			}
+		}
+
+		double trackHeight() const { return m_trackHeight; }
+
+		Optional<std::pair<size_t, size_t>> hovered() const { return m_hovered; }
+
+		double viewBegin() const { return m_view ? m_view->first : m_data->beginTime(); }
+
+		double viewEnd() const
+		{
+			const double end = m_view ? m_view->second : m_data->endTime();
+			return Max(end, viewBegin() + Config::MinViewDuration);
+		}
+
+		// 時刻の軸のローカル座標での範囲
+		std::pair<double, double> timeAxis(const RectF& rect) const
+		{
+			return { rect.x + Config::LabelWidth, Max(rect.w - Config::LabelWidth, 1.0) };
+		}
+
+		// 表示されている範囲を受け取って入力を処理し、描画に使うスパンを写しておく (TimelineOverlayから呼ぶ)
+		void updateOverlay(Rect rect, double scrollY, Optional<Vec2> cursorPos, size_t firstTrack, size_t lastTrack)
+		{
+			updateInput(rect, scrollY, cursorPos);
+
+			// 描画のときにデータを参照しないように、入力を処理した後の表示範囲でまとめておく
+			const auto [axisX, axisWidth] = timeAxis(rect);
+			m_shownView = { viewBegin(), viewEnd() };
+			const double pixelTime = (m_shownView.second - m_shownView.first) / axisWidth;
+
+			m_firstTrack = firstTrack;
+			m_trackSpans.resize(lastTrack - firstTrack);
+			for (size_t track = firstTrack; track < lastTrack; track++)
+			{
+				m_data->mergedSpans(track, m_shownView.first, m_shownView.second, pixelTime, m_trackSpans[track - firstTrack]);
+			}
+
+			m_hoveredSpan = m_hovered
+				? Optional<TimelineSpan>{ m_data->spans(m_hovered->first)[m_hovered->second] }
+				: none;
+			m_data = nullptr;
+		}
+
+		void drawTrack(size_t track, const RectF& rect) const
+		{
+			rect.draw(track % 2 == 1 ? Config::AlternateColor : Config::BackgroundColor);
+
+			const auto [axisX, axisWidth] = timeAxis(rect);
+			const auto [begin, end] = m_shownView;
+			const double pixelTime = (end - begin) / axisWidth;
+
+			// 描く矩形はピクセル単位にまとめたものだけ
+			if (m_firstTrack <= track && track < m_firstTrack + m_trackSpans.size())
+			{
+				const double top = rect.y + Config::TrackPadding;
+				const double height = rect.h - Config::TrackPadding * 2;
+				for (const auto& span : m_trackSpans[track - m_firstTrack])
+				{
+					const double x0 = Max(axisX, axisX + (span.begin - begin) / pixelTime);
+					const double x1 = Min(axisX + axisWidth, axisX + (span.end - begin) / pixelTime);
+					RectF{ x0, top, Max(x1 - x0, Config::MinSpanWidth), height }.draw(span.color);
+				}
+			}
+
+			RectF{ rect.pos, Config::LabelWidth, rect.h }.draw(Config::LabelBackgroundColor);
+			m_labels[track].draw(RectF{ rect.pos, Config::LabelWidth, rect.h }.stretched(-Config::TrackPadding), Config::LabelColor);
+			Line{ rect.bl(), rect.br() }.draw(1, Config::BorderColor);
+		}
+
+		void drawOverlay() const
+		{
+			const auto [axisX, axisWidth] = timeAxis(m_overlayRect);
+			Line{ axisX, m_overlayRect.y, axisX, m_overlayRect.bottomY() }.draw(1, Config::BorderColor);
+
+			if (m_hoveredSpan)
+			{
+				const auto& span = *m_hoveredSpan;
+				const auto [begin, end] = m_shownView;
+				const double pixelTime = (end - begin) / axisWidth;
+				const double x0 = Max(axisX, axisX + (span.begin - begin) / pixelTime);
+				const double x1 = Min(axisX + axisWidth, axisX + (span.end - begin) / pixelTime);
+				RectF{ x0, m_hoveredTop + Config::TrackPadding, Max(x1 - x0, Config::MinSpanWidth), m_trackHeight - Config::TrackPadding * 2 }
+					.drawFrame(1, 0, Config::HoveredFrameColor);
+			}
+
+			if (m_selectionBegin)
+			{
+				RectF{
+					Min(*m_selectionBegin, m_selectionEnd),
+					static_cast<double>(m_overlayRect.y),
+					Abs(m_selectionEnd - *m_selectionBegin),
+					static_cast<double>(m_overlayRect.h)
+				}.draw(Config::SelectionColor);
+			}
+		}
+
+	private:
+
+		// init()からupdateOverlay()までの間だけ有効
+		const TimelineData* m_data = nullptr;
+
+		Array<DrawableText> m_labels;
+
+		double m_trackHeight = 0.0;
+
+		// 表示している時刻の範囲 (noneのときは全体)
+		Optional<std::pair<double, double>> m_view;
+
+		Optional<double> m_selectionBegin;
+
+		double m_selectionEnd = 0.0;
+
+		Optional<Vec2> m_panBegin;
+
+		Optional<std::pair<size_t, size_t>> m_hovered;
+
+		double m_hoveredTop = 0.0;
+
+		Rect m_overlayRect{ 0, 0, 0, 0 };
+
+		// 以下は描画に使うためにupdateOverlay()で写したもの
+		std::pair<double, double> m_shownView{ 0.0, 1.0 };
+
+		size_t m_firstTrack = 0;
+
+		// 表示されているトラックごとの、ピクセル単位にまとめたスパン
+		Array<Array<TimelineSpan>> m_trackSpans;
+
+		Optional<TimelineSpan> m_hoveredSpan;
+
+		void updateInput(Rect rect, double scrollY, Optional<Vec2> cursorPos)
+		{
+			m_overlayRect = rect;
+			m_hovered = none;
+
+			const auto [axisX, axisWidth] = timeAxis(rect);
+			const double begin = viewBegin();
+			const double pixelTime = (viewEnd() - begin) / axisWidth;
+			const auto timeAt = [&](double x) { return begin + (x - axisX) * pixelTime; };
+
+			if (m_selectionBegin)
+			{
+				if (cursorPos)
+				{
+					m_selectionEnd = Clamp(cursorPos->x, axisX, axisX + axisWidth);
+				}
+				if (not MouseL.pressed())
+				{
+					if (Abs(m_selectionEnd - *m_selectionBegin) >= Config::MinSelectionWidth)
+					{
+						m_view = std::make_pair(
+							timeAt(Min(*m_selectionBegin, m_selectionEnd)),
+							timeAt(Max(*m_selectionBegin, m_selectionEnd)));
+					}
+					m_selectionBegin = none;
+				}
+				return;
+			}
+
+			if (m_panBegin)
+			{
+				if (MouseR.pressed())
+				{
+					const double delta = Cursor::DeltaF().x * pixelTime;
+					m_view = std::make_pair(viewBegin() - delta, viewEnd() - delta);
+				}
+				else
+				{
+					if (cursorPos && cursorPos->distanceFrom(*m_panBegin) < Config::ClickThreshold)
+					{
+						m_view = none;
+					}
+					m_panBegin = none;
+				}
+				return;
+			}
+
+			if (not cursorPos || not rect.contains(*cursorPos) || cursorPos->x < axisX)
+			{
+				return;
+			}
+
+			if (MouseL.down())
+			{
+				m_selectionBegin = m_selectionEnd = cursorPos->x;
+				return;
+			}
+			if (MouseR.down())
+			{
+				m_panBegin = *cursorPos;
+				return;
+			}
+
+			const double y = cursorPos->y - rect.y + scrollY;
+			const size_t track = static_cast<size_t>(Max(0.0, y / m_trackHeight));
+			if (track < m_data->trackCount())
+			{
+				if (auto span = m_data->findSpan(track, timeAt(cursorPos->x), pixelTime * 0.5))
+				{
+					m_hovered = std::make_pair(track, *span);
+					m_hoveredTop = rect.y + track * m_trackHeight - scrollY;
+				}
+			}
+		}
+
+		// トラックはTimelineTrack、入力と重ねて描くものはTimelineOverlayとして配置する
+
+		Size computeSize() const override
+		{
+			return { 0, 0 };
+		}
+
+		void update(Rect, Optional<Vec2>) override
+		{ }
+
+		void draw() const override
+		{ }
+	};
+
+	class TimelineTrack : public IControl
+	{
+	public:
+
+		const Timeline* timeline = nullptr;
+
+		size_t track = 0;
+
+	private:
+
+		Rect m_rect{ 0, 0, 0, 0 };
+
+		Size computeSize() const override
+		{
+			return m_rect.size;
+		}
+
+		void update(Rect rect, Optional<Vec2>) override
+		{
+			m_rect = rect;
+		}
+
+		// 入力を処理した後の表示範囲で描くため、スパンはTimelineOverlayの更新でまとめたものを使う
+		void draw() const override
+		{
+			timeline->drawTrack(track, m_rect);
+		}
+	};
+
+	// トラックの上に重ねて描くため、タイムラインの最後に配置する
+	class TimelineOverlay : public IControl
+	{
+	public:
+
+		Timeline* timeline = nullptr;
+
+		double scrollY = 0.0;
+
+		size_t firstTrack = 0;
+
+		size_t lastTrack = 0;
+
+	private:
+
+		Size computeSize() const override
+		{
+			return { 0, 0 };
+		}
+
+		void update(Rect rect, Optional<Vec2> cursorPos) override
+		{
+			timeline->updateOverlay(rect, scrollY, cursorPos, firstTrack, lastTrack);
+		}
+
+		void draw() const override
+		{
+			timeline->drawOverlay();
+		}
+	};
+
+	Optional<std::pair<size_t, size_t>> GUIManager::timeline(const StringView id, const TimelineData& data, SizeF size)
+	{
+		auto& window = getCurrentWindowImpl();
+
+		auto& timeline = window.nextStatefulControl<Timeline>(id.hash());
+		timeline.init(data, window.window.font);
+
+		size_t bodyId = id.hash();
+		s3d::detail::HashCombine(bodyId, typeid(Timeline).hash_code());
+		window.beginChild(bodyId, size);
+
+		// 表示されているトラックだけを配置する (縦方向は子領域のスクロールバーで動かす)
+		const RectF viewport = window.childViewport();
+		const double trackHeight = timeline.trackHeight();
+		const size_t trackCount = data.trackCount();
+		const size_t firstTrack = Min(trackCount, static_cast<size_t>(Max(0.0, viewport.y / trackHeight)));
+		const size_t lastTrack = Min(trackCount, static_cast<size_t>(Max(0.0, Math::Ceil((viewport.y + viewport.h) / trackHeight))));
+
+		// 横方向はスクロールさせないので、endChild()で足される余白の分だけ狭くする
+		const double width = Max(0.0, viewport.w - window.window.padding);
+		const double contentHeight = trackHeight * trackCount;
+
+		for (size_t i = firstTrack; i < lastTrack; i++)
+		{
+			auto& track = window.nextStatelessControl<TimelineTrack>();
+			track.timeline = &timeline;
+			track.track = i;
+			window.updateControlAt(track, window.placeRect({ 0, trackHeight * i, width, trackHeight }));
+		}
+
+		window.placeRect({ 0, 0, width, contentHeight });
+
+		// トラックのある範囲を超えると内容が広がり続けるので、その中に収める
+		auto& overlay = window.nextStatelessControl<TimelineOverlay>();
+		overlay.timeline = &timeline;
+		overlay.scrollY = viewport.y;
+		overlay.firstTrack = firstTrack;
+		overlay.lastTrack = lastTrack;
+		window.updateControlAt(overlay, window.placeRect({ 0, viewport.y, width, Clamp(contentHeight - viewport.y, 0.0, viewport.h) }));
+
+		window.endChild();
+
+		return timeline.hovered();
+	}
+
+	// Tree
+
+	class Tree : public IControl
+	{
+	public:
+
+		using Config = Config::Tree;
+
+		// 表示する順に並べた、展開されているノードの子孫
+		struct Row
+		{
+			uint64 node;
+
+			uint32 depth;
+
+			bool expandable;
+		};
+
+		void init(const ITreeProvider& provider, uint64 version, const Font& font)
+		{
+			m_provider = &provider;
+			m_rowHeight = font.height() + Config::RowPadding * 2.0;
+
+			if (not m_initialized || m_version != version)
+			{
+				m_initialized = true;
+				m_version = version;
+				m_rows.clear();
+				insertChildren(0, none, 0);
+			}
+
+			// 前のフレームで押された開閉は、行を配置する前に反映する
+			applyToggle();
+		}
+
+		const Array<Row>& rows() const { return m_rows; }
+
+		double rowHeight() const { return m_rowHeight; }
+
+		bool isExpanded(uint64 node) const { return m_expanded.contains(node); }
+
+		Optional<uint64> selected() const { return m_selected; }
+
+		void select(uint64 node) { m_selected = node; }
+
+		// 行の並びを変えるので、次のフレームのinit()で反映する
+		void requestToggle(size_t row, uint64 node) { m_toggleRequest = std::make_pair(row, node); }
+
+	private:
+
+		// init()を呼んだフレームの間だけ有効
+		const ITreeProvider* m_provider = nullptr;
+
+		Array<Row> m_rows;
+
+		HashSet<uint64> m_expanded;
+
+		Optional<uint64> m_selected;
+
+		// 押された行とノード
+		Optional<std::pair<size_t, uint64>> m_toggleRequest;
+
+		uint64 m_version = 0;
+
+		bool m_initialized = false;
+
+		double m_rowHeight = 0.0;
+
+		void applyToggle()
+		{
+			if (not m_toggleRequest)
+			{
+				return;
+			}
+			auto [row, node] = *m_toggleRequest;
+			m_toggleRequest = none;
+
+			// 行が作り直されていたらノードを探す
+			if (row >= m_rows.size() || m_rows[row].node != node)
+			{
+				const auto it = std::find_if(m_rows.begin(), m_rows.end(), [&](const Row& r) { return r.node == node; });
+				if (it == m_rows.end())
+				{
+					return;
+				}
+				row = static_cast<size_t>(it - m_rows.begin());
+			}
+
+			const Row target = m_rows[row];
+			if (m_expanded.erase(target.node))
+			{
+				// 閉じるときは深い行が続く範囲を取り除く
+				size_t end = row + 1;
+				while (end < m_rows.size() && m_rows[end].depth > target.depth)
+				{
+					end++;
+				}
+				m_rows.erase(m_rows.begin() + row + 1, m_rows.begin() + end);
+			}
+			else
+			{
+				m_expanded.insert(target.node);
+				insertChildren(row + 1, target.node, target.depth + 1);
+			}
+		}
+
+		// 展開されている子孫も含めてposの位置に挿入し、挿入した行数を返す
+		size_t insertChildren(size_t pos, Optional<uint64> parent, uint32 depth)
+		{
+			Array<uint64> children;
+			m_provider->children(parent, children);
+
+			Array<Row> rows;
+			rows.reserve(children.size());
+			for (uint64 child : children)
+			{
+				rows.push_back(Row{ child, depth, m_provider->hasChildren(child) });
+			}
+			m_rows.insert(m_rows.begin() + pos, rows.begin(), rows.end());
+
+			size_t inserted = rows.size();
+			for (size_t i = 0; i < rows.size(); i++)
+			{
+				// 前に展開していたノードは続けて展開する
+				if (rows[i].expandable && m_expanded.contains(rows[i].node))
+				{
+					const size_t rowPos = pos + (inserted - rows.size()) + i;
+					inserted += insertChildren(rowPos + 1, rows[i].node, depth + 1);
+				}
+			}
+			return inserted;
+		}
+
+		// 行はTreeRowとして配置する
+
+		Size computeSize() const override
+		{
+			return { 0, 0 };
+		}
+
+		void update(Rect, Optional<Vec2>) override
+		{ }
+
+		void draw() const override
+		{ }
+	};
+
+	class TreeRow : public IControl
+	{
+	public:
+
+		using Config = Config::Tree;
+
+		Tree* tree = nullptr;
+
+		size_t row = 0;
+
+		// 配置したときの行 (描画の前に行の並びが変わっても使えるように写す)
+		Tree::Row target{};
+
+		DrawableText labelText;
+
+	private:
+
+		Rect m_rect{ 0, 0, 0, 0 };
+
+		bool m_mouseOver = false;
+
+		double arrowAreaWidth() const
+		{
+			return labelText.font.height();
+		}
+
+		double indent() const
+		{
+			return Config::RowPadding + target.depth * static_cast<double>(Config::Indent);
+		}
+
+		Size computeSize() const override
+		{
+			return m_rect.size;
+		}
+
+		void update(Rect rect, Optional<Vec2> cursorPos) override
+		{
+			m_rect = rect;
+			m_mouseOver = cursorPos && rect.contains(*cursorPos);
+
+			if (not m_mouseOver || not MouseL.down())
+			{
+				return;
+			}
+
+			// 矢印を押したら開閉し、それ以外は選択する
+			const double arrowLeft = rect.x + indent();
+			if (target.expandable && arrowLeft <= cursorPos->x && cursorPos->x < arrowLeft + arrowAreaWidth())
+			{
+				tree->requestToggle(row, target.node);
+			}
+			else
+			{
+				tree->select(target.node);
+			}
+		}
+
+		void draw() const override
+		{
+			if (tree->selected() == target.node)
+			{
+				m_rect.draw(Config::SelectedColor);
+			}
+			else if (m_mouseOver)
+			{
+				m_rect.draw(Config::HoveredColor);
+			}
+
+			const double arrowLeft = m_rect.x + indent();
+			if (target.expandable)
+			{
+				Triangle{
+					Vec2{ arrowLeft + arrowAreaWidth() * 0.5, m_rect.centerY() },
+					arrowAreaWidth() * Config::ArrowScale * 2,
+					tree->isExpanded(target.node) ? 180_deg : 90_deg
+				}.draw(Config::ArrowColor);
+			}
+
+			labelText
+				.draw(Arg::leftCenter = Vec2{ arrowLeft + arrowAreaWidth(), m_rect.centerY() }, Config::LabelColor);
+		}
+	};
+
+	Optional<uint64> GUIManager::tree(const StringView id, const ITreeProvider& provider, SizeF size, uint64 version)
+	{
+		auto& window = getCurrentWindowImpl();
+
+		auto& tree = window.nextStatefulControl<Tree>(id.hash());
+		tree.init(provider, version, window.window.font);
+
+		size_t bodyId = id.hash();
+		s3d::detail::HashCombine(bodyId, typeid(Tree).hash_code());
+		window.beginChild(bodyId, size);
+
+		// 表示されている行だけを配置する
+		const RectF viewport = window.childViewport();
+		const auto& rows = tree.rows();
+		const double rowHeight = tree.rowHeight();
+		const size_t firstRow = Min(rows.size(), static_cast<size_t>(Max(0.0, viewport.y / rowHeight)));
+		const size_t lastRow = Min(rows.size(), static_cast<size_t>(Max(0.0, Math::Ceil((viewport.y + viewport.h) / rowHeight))));
+
+		const double width = Max(0.0, viewport.w - window.window.padding);
+		double contentWidth = width;
+
+		for (size_t i = firstRow; i < lastRow; i++)
+		{
+			auto& row = window.nextStatelessControl<TreeRow>();
+			row.tree = &tree;
+			row.row = i;
+			row.target = rows[i];
+			row.labelText = window.window.font(provider.label(rows[i].node));
+
+			// 深い行が表示領域からはみ出すときは横にスクロールできるようにする
+			const double rowWidth = Config::Tree::RowPadding * 2.0
+				+ rows[i].depth * static_cast<double>(Config::Tree::Indent)
+				+ window.window.font.height()
+				+ row.labelText.region().w;
+			contentWidth = Max(contentWidth, rowWidth);
+
+			window.updateControlAt(row, window.placeRect({ 0, rowHeight * i, Max(width, rowWidth), rowHeight }));
+		}
+
+		window.placeRect({ 0, 0, contentWidth, rowHeight * rows.size() });
+
+		window.endChild();
+
+		return tree.selected();
+	}
+
+	// Dropdown
+
+	// textがqueryの文字を順に含むか (queryは小文字にしておく)
+	static bool FuzzyMatch(const StringView text, const StringView query)
+	{
+		if (query.isEmpty())
+		{
+			return true;
+		}
+
+		size_t matched = 0;
+		for (char32 ch : text)
+		{
+			if (ToLower(ch) == query[matched] && ++matched == query.size())
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
+	// 1つの検索語での絞り込み (別スレッドで少しずつ結果を増やす)
+	struct FuzzyFilterJob
+	{
+		String query;
+
+		std::mutex mutex;
+
+		// 一致した項目の番号 (mutexで保護)
+		Array<uint32> results;
+
+		// 終わった後の結果 (resultsから移して、長い検索語の絞り込みと共有する)
+		std::shared_ptr<const Array<uint32>> finished;
+
+		// 見つかった項目 (mutexをロックして呼ぶ)
+		const Array<uint32>& found() const { return finished ? *finished : results; }
+
+		std::atomic<bool> done = false;
+
+		std::atomic<bool> cancel = false;
+	};
+
+	class Dropdown : public IControl
+	{
+	public:
+
+		using Config = Config::Dropdown;
+
+		// AsyncTaskの破棄は完了を待つので、絞り込みを取り消してから破棄する
+		// (m_staleTasksのタスクは移したときに取り消している)
+		~Dropdown()
+		{
+			for (auto& [query, entry] : m_jobs)
+			{
+				entry.job->cancel = true;
+			}
+		}
+
+		DrawableText labelText;
+
+		double width = 0.0;
+
+		bool isOpen() const { return m_open; }
+
+		// このフレームで開いたときはtrue
+		bool opened() const { return m_toggled && m_open; }
+
+		void close() { m_open = false; }
+
+		Rect rect() const { return m_rect; }
+
+		void setItems(const std::shared_ptr<const Array<String>>& items)
+		{
+			if (m_items == items)
+			{
+				return;
+			}
+			m_items = items;
+
+			// 項目が変わったら途中の結果はすべて捨てる
+			for (auto& [query, entry] : m_jobs)
+			{
+				entry.job->cancel = true;
+				m_staleTasks.push_back(std::move(entry.task));
+			}
+			m_jobs.clear();
+			m_jobOrder.clear();
+			m_current = nullptr;
+		}
+
+		// 検索語が変わったら絞り込みを始める (フレームを止めない)
+		void setQuery(const StringView query)
+		{
+			m_staleTasks.remove_if([](const AsyncTask<void>& task) { return task.isReady(); });
+
+			const String key = String{ query }.lowercased();
+			if (key.isEmpty())
+			{
+				m_current = nullptr;
+				return;
+			}
+			if (m_current && m_current->query == key)
+			{
+				return;
+			}
+			if (auto itr = m_jobs.find(key); itr != m_jobs.end())
+			{
+				m_current = itr->second.job;
+				return;
+			}
+
+			// 終わっている最も長い接頭辞の結果だけを調べ直す
+			std::shared_ptr<const Array<uint32>> source;
+			for (size_t length = key.size() - 1; length > 0; length--)
+			{
+				auto itr = m_jobs.find(key.substr(0, length));
+				if (itr != m_jobs.end() && itr->second.job->done)
+				{
+					std::lock_guard lock{ itr->second.job->mutex };
+					if (itr->second.job->finished)
+					{
+						source = itr->second.job->finished;
+						break;
+					}
+				}
+			}
+
+			auto job = std::make_shared<FuzzyFilterJob>();
+			job->query = key;
+
+			auto task = Async([job, items = m_items, source]()
+			{
+				const size_t count = source ? source->size() : items->size();
+				Array<uint32> chunk;
+				for (size_t begin = 0; begin < count && not job->cancel; begin += Config::FilterChunkSize)
+				{
+					chunk.clear();
+					const size_t end = Min(count, begin + Config::FilterChunkSize);
+					for (size_t i = begin; i < end; i++)
+					{
+						const uint32 index = source ? (*source)[i] : static_cast<uint32>(i);
+						if (FuzzyMatch((*items)[index], job->query))
+						{
+							chunk.push_back(index);
+						}
+					}
+
+					std::lock_guard lock{ job->mutex };
+					job->results.insert(job->results.end(), chunk.begin(), chunk.end());
+				}
+
+				// 結果は1回だけ共有できる形にして、絞り込みを続けるときに写さないようにする
+				if (not job->cancel)
+				{
+					std::lock_guard lock{ job->mutex };
+					job->finished = std::make_shared<const Array<uint32>>(std::move(job->results));
+					job->results = {};
+				}
+				job->done = true;
+			});
+
+			// 古い検索語から捨てる
+			if (m_jobOrder.size() >= Config::FilterCacheSize)
+			{
+				auto& entry = m_jobs.at(m_jobOrder.front());
+				entry.job->cancel = true;
+				m_staleTasks.push_back(std::move(entry.task));
+				m_jobs.erase(m_jobOrder.front());
+				m_jobOrder.pop_front();
+			}
+			m_jobs.emplace(key, FilterEntry{ job, std::move(task) });
+			m_jobOrder.push_back(key);
+			m_current = job;
+		}
+
+		// これまでに見つかった項目の数
+		size_t resultCount()
+		{
+			if (not m_current)
+			{
+				return m_items->size();
+			}
+			std::lock_guard lock{ m_current->mutex };
+			return m_current->found().size();
+		}
+
+		// [first, last)番目に見つかった項目の番号をoutに書き込む
+		void results(size_t first, size_t last, Array<uint32>& out)
+		{
+			out.clear();
+			if (not m_current)
+			{
+				for (size_t i = first; i < last; i++)
+				{
+					out.push_back(static_cast<uint32>(i));
+				}
+				return;
+			}
+			std::lock_guard lock{ m_current->mutex };
+			const auto& found = m_current->found();
+			last = Min(last, found.size());
+			if (first < last)
+			{
+				out.assign(found.begin() + first, found.begin() + last);
+			}
+		}
+
+	private:
+
+		struct FilterEntry
+		{
+			std::shared_ptr<FuzzyFilterJob> job;
+
+			AsyncTask<void> task;
+		};
+
+		bool m_open = false;
+
+		bool m_toggled = false;
+
+		bool m_mouseOver = false;
+
+		Rect m_rect{ 0, 0, 0, 0 };
+
+		std::shared_ptr<const Array<String>> m_items;
+
+		HashTable<String, FilterEntry> m_jobs;
+
+		// 検索語を追加した順
+		std::deque<String> m_jobOrder;
+
+		std::shared_ptr<FuzzyFilterJob> m_current;
+
+		// 取り消したタスク (完了を待たずに、終わったものから捨てる)
+		Array<AsyncTask<void>> m_staleTasks;
+
+		int32 arrowAreaWidth() const
+		{
+			return labelText.font.height();
+		}
+
+		Size computeSize() const override
+		{
+			return {
+				static_cast<int32>(width),
+				labelText.font.height() + Config::Padding * 2
+			};
+		}
+
+		void update(Rect rect, Optional<Vec2> cursorPos) override
+		{
+			m_rect = rect;
+			m_mouseOver = cursorPos && rect.contains(*cursorPos);
+			m_toggled = m_mouseOver && MouseL.down();
+			m_open ^= m_toggled;
+
+			if (m_mouseOver)
+			{
+				Cursor::RequestStyle(CursorStyle::Hand);
+			}
+		}
+
+		void draw() const override
+		{
+			m_rect
+				.rounded(Config::Roundness)
+				.draw(m_mouseOver ? Config::HoveredBackgroundColor : Config::BackgroundColor);
+
+			const RectF labelRect{
+				m_rect.x + Config::Padding,
+				m_rect.y,
+				Max(0, m_rect.w - Config::Padding * 2 - arrowAreaWidth()),
+				m_rect.h
+			};
+			labelText.draw(labelRect.stretched(0, -Config::Padding), Config::LabelColor);
+
+			Triangle{
+				Vec2{ m_rect.rightX() - Config::Padding - arrowAreaWidth() * 0.5, m_rect.centerY() },
+				arrowAreaWidth() * Config::ArrowScale * 2,
+				m_open ? 0_deg : 180_deg
+			}.draw(Config::ArrowColor);
+		}
+	};
+
+	class DropdownItem : public IControl
+	{
+	public:
+
+		using Config = Config::Dropdown;
+
+		DrawableText labelText;
+
+		bool selected = false;
+
+		bool clicked() const { return m_clicked; }
+
+	private:
+
+		Rect m_rect{ 0, 0, 0, 0 };
+
+		bool m_mouseOver = false;
+
+		bool m_clicked = false;
+
+		Size computeSize() const override
+		{
+			return m_rect.size;
+		}
+
+		void update(Rect rect, Optional<Vec2> cursorPos) override
+		{
+			m_rect = rect;
+			m_mouseOver = cursorPos && rect.contains(*cursorPos);
+			m_clicked = m_mouseOver && MouseL.down();
+		}
+
+		void draw() const override
+		{
+			if (selected)
+			{
+				m_rect.draw(Config::SelectedItemColor);
+			}
+			else if (m_mouseOver)
+			{
+				m_rect.draw(Config::HoveredItemColor);
+			}
+
+			labelText
+				.draw(Arg::leftCenter = Vec2{ m_rect.x + Config::ItemPadding, m_rect.centerY() }, Config::LabelColor);
+		}
+	};
+
+	bool GUIManager::dropdown(const StringView id, const std::shared_ptr<const Array<String>>& items, Optional<size_t>& selected, double width)
+	{
+		using Config = Config::Dropdown;
+
+		auto& window = getCurrentWindowImpl();
+
+		auto& dropdown = window.nextStatefulControl<Dropdown>(id.hash());
+		dropdown.setItems(items);
+		dropdown.width = width;
+		dropdown.labelText = window.window.font(selected && *selected < items->size() ? StringView{ (*items)[*selected] } : StringView{});
+
+		// 一覧のウィンドウは測定パスでは作らない
+		if (not window.updateControl(dropdown) || not dropdown.isOpen())
+		{
+			return false;
+		}
+
+		const RectF headerRect{ window.toScreenPos(dropdown.rect().pos), dropdown.rect().size };
+		const bool opened = dropdown.opened();
+		bool changed = false;
+		RectF popupRect = headerRect;
+
+		size_t popupId = id.hash();
+		s3d::detail::HashCombine(popupId, reinterpret_cast<size_t>(&window));
+
+		// 一覧は手前に表示する別のウィンドウに描く
+		this->window(U"Dropdown#{:X}"_fmt(popupId),
+			WindowFlag::NoTitlebar | WindowFlag::NoResize | WindowFlag::NoMove | WindowFlag::AlwaysForeground | WindowFlag::AutoResize,
+			[&](GUIManager& gui)
+		{
+			gui.setWindowPos(headerRect.bl(), { 0, 0 });
+
+			auto& query = gui.simpleTextBox(U"Query", width);
+			if (opened)
+			{
+				query.active = true;
+			}
+			dropdown.setQuery(query.text);
+
+			auto& popup = gui.getCurrentWindowImpl();
+			size_t listId = popupId;
+			s3d::detail::HashCombine(listId, typeid(DropdownItem).hash_code());
+			popup.beginChild(listId, { width, Config::ListHeight });
+
+			// 表示されている行だけを配置する
+			const RectF viewport = popup.childViewport();
+			const double rowHeight = popup.window.font.height() + Config::ItemPadding * 2.0;
+			const size_t count = dropdown.resultCount();
+			const size_t firstRow = Min(count, static_cast<size_t>(Max(0.0, viewport.y / rowHeight)));
+			const size_t lastRow = Min(count, static_cast<size_t>(Max(0.0, Math::Ceil((viewport.y + viewport.h) / rowHeight))));
+
+			Array<uint32> rows;
+			dropdown.results(firstRow, lastRow, rows);
+
+			const double rowWidth = Max(0.0, viewport.w - popup.window.padding);
+			for (size_t i = 0; i < rows.size(); i++)
+			{
+				auto& item = popup.nextStatelessControl<DropdownItem>();
+				item.labelText = popup.window.font((*items)[rows[i]]);
+				item.selected = selected == rows[i];
+
+				if (popup.updateControlAt(item, popup.placeRect({ 0, rowHeight * (firstRow + i), rowWidth, rowHeight }))
+					&& item.clicked())
+				{
+					selected = rows[i];
+					changed = true;
+					dropdown.close();
+				}
+			}
+
+			popup.placeRect({ 0, 0, rowWidth, rowHeight * count });
+			popup.endChild();
+
+			popupRect = gui.getCurrentWindow().rect;
+		});
+
+		// 外側をクリックするかEscキーで閉じる
+		const Vec2 cursor = Cursor::PosF();
+		if ((MouseL.down() && not popupRect.contains(cursor) && not headerRect.contains(cursor))
+			|| KeyEscape.down())
+		{
+			dropdown.close();
+		}
+
+		return changed;
+	}
+
+	// TextEditor
+
+	TextDocument::TextDocument(const StringView text)
+	{
+		setText(text);
+	}
+
+	bool TextDocument::open(const FilePathView path)
+	{
+		m_memory = {};
+		m_file.close();
+		m_path.clear();
+		m_originalText.clear();
+
+		if (not m_file.open(path))
+		{
+			reset(0);
+			return false;
+		}
+
+		m_memory = m_file.mapAll();
+		if (not m_memory.data)
+		{
+			m_file.close();
+			reset(0);
+			return false;
+		}
+
+		m_path = FileSystem::FullPath(path);
+		reset(m_memory.size);
+		return true;
+	}
+
+	bool TextDocument::save(const FilePathView path)
+	{
+		// 断片はメモリマップした元のファイルを指しているので、書き終えるまで元のファイルには触らない
+		const FilePath target = FileSystem::FullPath(path);
+		const FilePath temporary = target + U".saving";
+		{
+			BinaryWriter writer{ temporary };
+			if (not writer)
+			{
+				return false;
+			}
+
+			if (m_hasBom)
+			{
+				writer.write("\xEF\xBB\xBF", 3);
+			}
+			for (const auto& piece : m_pieces)
+			{
+				writer.write(data(piece.source) + piece.offset, static_cast<int64>(piece.length));
+			}
+			writer.close();
+		}
+
+		const bool reopen = not m_path.isEmpty() && target == m_path;
+		if (reopen)
+		{
+			m_memory = {};
+			m_file.close();
+		}
+
+		// 置き換え先があると名前を変えられない環境があるので、先に消す
+		if (FileSystem::Exists(target) && not FileSystem::Remove(target))
+		{
+			FileSystem::Remove(temporary);
+			if (reopen)
+			{
+				open(target);
+			}
+			return false;
+		}
+
+		// 元のファイルはもう無いので、一時ファイルを残してそちらを開く
+		if (not FileSystem::Rename(temporary, target))
+		{
+			if (reopen)
+			{
+				open(temporary);
+			}
+			return false;
+		}
+
+		if (reopen)
+		{
+			return open(target);
+		}
+		return true;
+	}
+
+	void TextDocument::setText(const StringView text)
+	{
+		m_memory = {};
+		m_file.close();
+		m_path.clear();
+		m_originalText = Unicode::ToUTF8(text);
+
+		reset(m_originalText.size());
+	}
+
+	String TextDocument::text(uint64 begin, uint64 end) const
+	{
+		std::string bytes;
+		read(begin, end, bytes);
+		return Unicode::FromUTF8(bytes);
+	}
+
+	void TextDocument::read(uint64 begin, uint64 end, std::string& out) const
+	{
+		out.clear();
+		end = Min(end, size());
+		if (begin >= end)
+		{
+			return;
+		}
+
+		out.reserve(static_cast<size_t>(end - begin));
+		for (size_t i = pieceAt(begin); i < m_pieces.size() && pieceBegin(i) < end; i++)
+		{
+			const auto& piece = m_pieces[i];
+			const uint64 pieceFirst = pieceBegin(i);
+			const uint64 from = Max(begin, pieceFirst) - pieceFirst;
+			const uint64 to = Min(end, m_pieceEnds[i]) - pieceFirst;
+			out.append(data(piece.source) + piece.offset + from, static_cast<size_t>(to - from));
+		}
+	}
+
+	uint64 TextDocument::lineBegin(size_t line) const
+	{
+		if (line == 0)
+		{
+			return 0;
+		}
+		if (line >= lineCount())
+		{
+			return size();
+		}
+
+		// line番目の改行を含む断片を探し、その中の改行の位置は断片の元の文字列の索引から引く
+		const size_t index = std::lower_bound(m_pieceLineEnds.begin(), m_pieceLineEnds.end(), line) - m_pieceLineEnds.begin();
+		const auto& piece = m_pieces[index];
+		const uint64 skipped = index == 0 ? 0 : m_pieceLineEnds[index - 1];
+
+		const auto& breaks = lineBreaks(piece.source);
+		const size_t first = std::lower_bound(breaks.begin(), breaks.end(), piece.offset) - breaks.begin();
+		const uint64 lineBreak = breaks[first + static_cast<size_t>(line - skipped - 1)];
+
+		return pieceBegin(index) + (lineBreak - piece.offset) + 1;
+	}
+
+	uint64 TextDocument::lineEnd(size_t line) const
+	{
+		const uint64 begin = lineBegin(line);
+		uint64 end = line + 1 < lineCount() ? lineBegin(line + 1) - 1 : size();
+		if (end > begin && byteAt(end - 1) == '\r')
+		{
+			end--;
+		}
+		return end;
+	}
+
+	size_t TextDocument::lineAt(uint64 pos) const
+	{
+		const size_t index = pieceAt(pos);
+		if (index == m_pieces.size())
+		{
+			return lineCount() - 1;
+		}
+
+		const auto& piece = m_pieces[index];
+		const auto& breaks = lineBreaks(piece.source);
+		const uint64 end = piece.offset + (pos - pieceBegin(index));
+		const size_t count = std::lower_bound(breaks.begin(), breaks.end(), end) - std::lower_bound(breaks.begin(), breaks.end(), piece.offset);
+
+		return static_cast<size_t>((index == 0 ? 0 : m_pieceLineEnds[index - 1]) + count);
+	}
+
+	// UTF-8の2バイト目以降 (10xxxxxx) を飛ばす
+	uint64 TextDocument::nextCharPos(uint64 pos) const
+	{
+		const uint64 end = size();
+		if (pos >= end)
+		{
+			return end;
+		}
+
+		pos++;
+		while (pos < end && (static_cast<uint8>(byteAt(pos)) & 0xC0) == 0x80)
+		{
+			pos++;
+		}
+		return pos;
+	}
+
+	uint64 TextDocument::prevCharPos(uint64 pos) const
+	{
+		if (pos == 0)
+		{
+			return 0;
+		}
+
+		pos = Min(pos, size()) - 1;
+		while (pos > 0 && (static_cast<uint8>(byteAt(pos)) & 0xC0) == 0x80)
+		{
+			pos--;
+		}
+		return pos;
+	}
+
+	void TextDocument::insert(uint64 pos, const StringView text)
+	{
+		const std::string bytes = Unicode::ToUTF8(text);
+		if (bytes.empty())
+		{
+			return;
+		}
+		pos = Min(pos, size());
+
+		// 追加した文字列は末尾に足していくだけなので、断片が指す位置は変わらない
+		const uint64 offset = m_added.size();
+		m_added += bytes;
+		for (size_t i = 0; i < bytes.size(); i++)
+		{
+			if (bytes[i] == '\n')
+			{
+				m_addedBreaks.push_back(offset + i);
+			}
+		}
+
+		const bool typing = not text.includes(U'\n');
+		m_redo.clear();
+		m_version++;
+
+		// 直前に入力した断片の続きなら、新しい断片を作らずに伸ばす
+		if (typing && pos > 0 && not m_undo.isEmpty() && m_undo.back().typing)
+		{
+			auto& last = m_undo.back();
+			const size_t index = pieceAt(pos - 1);
+			auto& piece = m_pieces[index];
+			if (m_pieceEnds[index] == pos
+				&& piece.source == Source::Added
+				&& piece.offset + piece.length == offset
+				&& last.first <= index && index < last.first + last.inserted.size())
+			{
+				piece.length += bytes.size();
+				last.inserted[index - last.first] = piece;
+				last.insertedLength += bytes.size();
+				updateIndex(index);
+				return;
+			}
+		}
+
+		const Piece added = makePiece(Source::Added, offset, bytes.size());
+
+		Edit edit{ .pos = pos, .insertedLength = bytes.size(), .typing = typing };
+		const size_t index = pieceAt(pos);
+		edit.first = index;
+
+		if (index < m_pieces.size() && pieceBegin(index) < pos)
+		{
+			// 断片の途中に挿入するときは前後に分ける
+			const auto& piece = m_pieces[index];
+			const uint64 split = pos - pieceBegin(index);
+			edit.removed = { piece };
+			edit.inserted = {
+				makePiece(piece.source, piece.offset, split),
+				added,
+				makePiece(piece.source, piece.offset + split, piece.length - split)
+			};
+		}
+		else
+		{
+			edit.inserted = { added };
+		}
+
+		splice(edit.first, edit.removed.size(), edit.inserted);
+		m_undo.push_back(std::move(edit));
+	}
+
+	void TextDocument::erase(uint64 begin, uint64 end)
+	{
+		end = Min(end, size());
+		if (begin >= end)
+		{
+			return;
+		}
+
+		const size_t first = pieceAt(begin);
+		const size_t last = pieceAt(end - 1);
+
+		Edit edit{ .first = first, .pos = begin, .removedLength = end - begin };
+		edit.removed.assign(m_pieces.begin() + first, m_pieces.begin() + last + 1);
+
+		// 範囲の外に出る両端の部分だけを残す
+		const auto& front = m_pieces[first];
+		if (const uint64 length = begin - pieceBegin(first); length > 0)
+		{
+			edit.inserted.push_back(makePiece(front.source, front.offset, length));
+		}
+		const auto& back = m_pieces[last];
+		if (const uint64 length = m_pieceEnds[last] - end; length > 0)
+		{
+			edit.inserted.push_back(makePiece(back.source, back.offset + back.length - length, length));
+		}
+
+		splice(edit.first, edit.removed.size(), edit.inserted);
+		m_undo.push_back(std::move(edit));
+		m_redo.clear();
+		m_version++;
+	}
+
+	Optional<uint64> TextDocument::undo()
+	{
+		if (m_undo.isEmpty())
+		{
+			return none;
+		}
+
+		Edit edit = std::move(m_undo.back());
+		m_undo.pop_back();
+
+		splice(edit.first, edit.inserted.size(), edit.removed);
+		m_version++;
+
+		const uint64 pos = edit.pos + edit.removedLength;
+		edit.typing = false;
+		m_redo.push_back(std::move(edit));
+		return pos;
+	}
+
+	Optional<uint64> TextDocument::redo()
+	{
+		if (m_redo.isEmpty())
+		{
+			return none;
+		}
+
+		Edit edit = std::move(m_redo.back());
+		m_redo.pop_back();
+
+		splice(edit.first, edit.removed.size(), edit.inserted);
+		m_version++;
+
+		const uint64 pos = edit.pos + edit.insertedLength;
+		m_undo.push_back(std::move(edit));
+		return pos;
+	}
+
+	void TextDocument::breakUndoGroup()
+	{
+		if (not m_undo.isEmpty())
+		{
+			m_undo.back().typing = false;
+		}
+	}
+
+	const char* TextDocument::data(Source source) const
+	{
+		if (source == Source::Added)
+		{
+			return m_added.data();
+		}
+		return m_memory.data
+			? reinterpret_cast<const char*>(m_memory.data)
+			: m_originalText.data();
+	}
+
+	TextDocument::Piece TextDocument::makePiece(Source source, uint64 offset, uint64 length) const
+	{
+		const auto& breaks = lineBreaks(source);
+		const auto first = std::lower_bound(breaks.begin(), breaks.end(), offset);
+		const auto last = std::lower_bound(first, breaks.end(), offset + length);
+		return { source, offset, length, static_cast<uint64>(last - first) };
+	}
+
+	size_t TextDocument::pieceAt(uint64 pos) const
+	{
+		return std::upper_bound(m_pieceEnds.begin(), m_pieceEnds.end(), pos) - m_pieceEnds.begin();
+	}
+
+	char TextDocument::byteAt(uint64 pos) const
+	{
+		const size_t index = pieceAt(pos);
+		const auto& piece = m_pieces[index];
+		return data(piece.source)[piece.offset + (pos - pieceBegin(index))];
+	}
+
+	void TextDocument::reset(uint64 originalSize)
+	{
+		uint64 begin = 0;
+		const char* original = data(Source::Original);
+
+		// BOMは文書に含めない
+		m_hasBom = originalSize >= 3 && std::memcmp(original, "\xEF\xBB\xBF", 3) == 0;
+		if (m_hasBom)
+		{
+			begin = 3;
+		}
+
+		// 改行の位置の索引は開いたときに一度だけ作り、以降は追加した文字列の分だけ増やす
+		m_originalBreaks.clear();
+		const char* end = original + originalSize;
+		for (const char* p = original + begin; p < end; p++)
+		{
+			p = static_cast<const char*>(std::memchr(p, '\n', end - p));
+			if (not p)
+			{
+				break;
+			}
+			m_originalBreaks.push_back(p - original);
+		}
+
+		m_added.clear();
+		m_addedBreaks.clear();
+		m_undo.clear();
+		m_redo.clear();
+		m_version++;
+
+		m_pieces.clear();
+		if (originalSize > begin)
+		{
+			m_pieces.push_back(makePiece(Source::Original, begin, originalSize - begin));
+		}
+		updateIndex(0);
+	}
+
+	void TextDocument::splice(size_t first, size_t count, const Array<Piece>& pieces)
+	{
+		m_pieces.erase(m_pieces.begin() + first, m_pieces.begin() + first + count);
+		m_pieces.insert(m_pieces.begin() + first, pieces.begin(), pieces.end());
+		updateIndex(first);
+	}
+
+	// 組み替えた断片から後ろの累計だけを計算し直す
+	void TextDocument::updateIndex(size_t first)
+	{
+		m_pieceEnds.resize(m_pieces.size());
+		m_pieceLineEnds.resize(m_pieces.size());
+
+		for (size_t i = first; i < m_pieces.size(); i++)
+		{
+			m_pieceEnds[i] = (i == 0 ? 0 : m_pieceEnds[i - 1]) + m_pieces[i].length;
+			m_pieceLineEnds[i] = (i == 0 ? 0 : m_pieceLineEnds[i - 1]) + m_pieces[i].lineBreaks;
+		}
+	}
+
+	// UTF-8のバイト列に含まれる文字の数
+	static size_t CountUTF8Chars(const char* bytes, size_t length)
+	{
+		size_t count = 0;
+		for (size_t i = 0; i < length; i++)
+		{
+			count += (static_cast<uint8>(bytes[i]) & 0xC0) != 0x80;
+		}
+		return count;
+	}
+
+	// 1行分の整形結果 (表示されている行とキャレットのある行だけ作る)
+	struct TextLineLayout
+	{
+		uint64 begin = 0;
+
+		std::string bytes;
+
+		String text;
+
+		// 各文字の左端のx (末尾は行の幅)
+		Array<double> offsets{ 0.0 };
+
+		void build(const TextDocument& document, const Font& font, size_t line)
+		{
+			begin = document.lineBegin(line);
+			document.read(begin, document.lineEnd(line), bytes);
+			text = Unicode::FromUTF8(bytes);
+
+			offsets.clear();
+			offsets.push_back(0.0);
+			for (double advance : font.getXAdvances(text))
+			{
+				offsets.push_back(offsets.back() + advance);
+			}
+		}
+
+		uint64 end() const { return begin + bytes.size(); }
+
+		double width() const { return offsets.back(); }
+
+		double xAt(uint64 pos) const
+		{
+			const size_t index = CountUTF8Chars(bytes.data(), static_cast<size_t>(Clamp(pos, begin, end()) - begin));
+			return offsets[Min(index, offsets.size() - 1)];
+		}
+
+		// xに最も近い文字の境目の位置
+		uint64 posAt(double x) const
+		{
+			size_t index = 0;
+			while (index + 1 < offsets.size() && (offsets[index] + offsets[index + 1]) * 0.5 < x)
+			{
+				index++;
+			}
+
+			size_t byte = 0;
+			for (size_t chars = 0; byte < bytes.size(); byte++)
+			{
+				if ((static_cast<uint8>(bytes[byte]) & 0xC0) != 0x80)
+				{
+					if (chars == index)
+					{
+						break;
+					}
+					chars++;
+				}
+			}
+			return begin + byte;
+		}
+	};
+
+	class TextEditor : public IControl
+	{
+	public:
+
+		using Config = Config::TextEditor;
+
+		void init(TextDocument& document, const Font& font)
+		{
+			if (m_document != &document)
+			{
+				m_document = &document;
+				m_caret = 0;
+				m_anchor = 0;
+				m_preferredX = none;
+				m_contentWidth = 0.0;
+				m_layouts.clear();
+			}
+			if (m_font.id() != font.id())
+			{
+				m_layouts.clear();
+			}
+			m_font = font;
+
+			// 前のフレームで使わなかった行は捨てる
+			EraseUnused(m_layouts);
+
+			// 外から書き換えられても範囲に収める
+			m_caret = Min(m_caret, document.size());
+			m_anchor = Min(m_anchor, document.size());
+
+			m_changed = false;
+			m_caretMoved = false;
+		}
+
+		bool isActive() const { return m_active; }
+
+		uint64 caret() const { return m_caret; }
+
+		std::pair<uint64, uint64> selection() const { return std::minmax(m_anchor, m_caret); }
+
+		bool caretVisible() const
+		{
+			return m_active && Math::Fmod(m_blinkTime, Config::CaretBlinkInterval * 2) < Config::CaretBlinkInterval;
+		}
+
+		// このフレームで文書が編集されたか
+		bool changed() const { return m_changed; }
+
+		// このフレームでキャレットが動いたか
+		bool caretMoved() const { return m_caretMoved; }
+
+		// キャレットの周りの矩形 (コンテンツ座標)
+		const RectF& caretRect() const { return m_caretRect; }
+
+		// 行を全部整形しないので、表示したことのある行の最大幅を使う
+		double contentWidth() const { return m_contentWidth; }
+
+		void extendWidth(double width)
+		{
+			m_contentWidth = Max(m_contentWidth, width);
+		}
+
+		// 行の整形結果 (文書が変わるまで使い回す)
+		std::shared_ptr<const TextLineLayout> sharedLineLayout(size_t line)
+		{
+			if (m_layoutVersion != m_document->version())
+			{
+				m_layoutVersion = m_document->version();
+				m_layouts.clear();
+			}
+
+			auto& entry = m_layouts[line];
+			entry.used = true;
+			if (not entry.layout)
+			{
+				auto layout = std::make_shared<TextLineLayout>();
+				layout->build(*m_document, m_font, line);
+				entry.layout = std::move(layout);
+			}
+			return entry.layout;
+		}
+
+		const TextLineLayout& lineLayout(size_t line)
+		{
+			return *sharedLineLayout(line);
+		}
+
+		// rectは表示領域に配置した入力用の矩形、originはその左上のコンテンツ座標
+		void handleInput(Rect rect, Optional<Vec2> cursorPos, Vec2 origin)
+		{
+			auto& document = *m_document;
+			const uint64 prevCaret = m_caret;
+			const uint64 prevVersion = document.version();
+
+			const bool mouseOver = cursorPos && rect.contains(*cursorPos);
+			if (mouseOver)
+			{
+				Cursor::RequestStyle(CursorStyle::IBeam);
+			}
+
+			if (MouseL.down())
+			{
+				m_active = mouseOver;
+				m_dragging = mouseOver;
+				if (mouseOver)
+				{
+					moveCaret(posAt(*cursorPos - rect.pos + origin), KeyShift.pressed());
+				}
+			}
+			else if (m_dragging)
+			{
+				m_dragging = MouseL.pressed();
+				if (m_dragging && cursorPos)
+				{
+					moveCaret(posAt(*cursorPos - rect.pos + origin), true);
+				}
+			}
+
+			// 変換中の文字があるときはキー操作をIMEに任せる
+			if (m_active && TextInput::GetEditingText().isEmpty())
+			{
+				const size_t pageLines = Max<size_t>(1, static_cast<size_t>(rect.h / lineHeight()));
+				handleKeys(pageLines);
+			}
+
+			m_changed = document.version() != prevVersion;
+			m_caretMoved = m_changed || m_caret != prevCaret;
+			m_blinkTime = m_caretMoved ? 0.0 : m_blinkTime + Scene::DeltaTime();
+
+			if (m_caretMoved)
+			{
+				const size_t line = document.lineAt(m_caret);
+				const auto& layout = lineLayout(line);
+				extendWidth(layout.width() + Config::TextPadding * 2);
+				m_caretRect = {
+					layout.xAt(m_caret),
+					lineHeight() * line,
+					Config::TextPadding * 2,
+					lineHeight()
+				};
+			}
+		}
+
+	private:
+
+		TextDocument* m_document = nullptr;
+
+		Font m_font;
+
+		uint64 m_caret = 0;
+
+		// 選択範囲のキャレットと反対側の端
+		uint64 m_anchor = 0;
+
+		// 上下に移動するときに揃えるx
+		Optional<double> m_preferredX;
+
+		bool m_active = false;
+
+		bool m_dragging = false;
+
+		bool m_changed = false;
+
+		bool m_caretMoved = false;
+
+		double m_blinkTime = 0.0;
+
+		RectF m_caretRect{ 0, 0, 0, 0 };
+
+		double m_contentWidth = 0.0;
+
+		struct CachedLayout
+		{
+			std::shared_ptr<const TextLineLayout> layout;
+
+			bool used = true;
+		};
+
+		// 行ごとの整形結果 (m_layoutVersionの文書のもの)
+		HashTable<size_t, CachedLayout> m_layouts;
+
+		uint64 m_layoutVersion = 0;
+
+		Repeat m_leftRepeat{ Config::KeyRepeatInterval, Config::KeyRepeatDelay };
+
+		Repeat m_rightRepeat{ Config::KeyRepeatInterval, Config::KeyRepeatDelay };
+
+		Repeat m_upRepeat{ Config::KeyRepeatInterval, Config::KeyRepeatDelay };
+
+		Repeat m_downRepeat{ Config::KeyRepeatInterval, Config::KeyRepeatDelay };
+
+		Repeat m_pageUpRepeat{ Config::KeyRepeatInterval, Config::KeyRepeatDelay };
+
+		Repeat m_pageDownRepeat{ Config::KeyRepeatInterval, Config::KeyRepeatDelay };
+
+		Repeat m_deleteRepeat{ Config::KeyRepeatInterval, Config::KeyRepeatDelay };
+
+		double lineHeight() const
+		{
+			return m_font.height();
+		}
+
+		bool hasSelection() const
+		{
+			return m_caret != m_anchor;
+		}
+
+		// コンテンツ座標に最も近い文字の境目の位置
+		uint64 posAt(Vec2 pos)
+		{
+			const size_t line = static_cast<size_t>(Clamp(Math::Floor(pos.y / lineHeight()), 0.0, m_document->lineCount() - 1.0));
+			return lineLayout(line).posAt(pos.x - Config::TextPadding);
+		}
+
+		// 改行文字 (CRLFを含む) を1文字として前後に進む
+		uint64 prevPos(uint64 pos) const
+		{
+			const size_t line = m_document->lineAt(pos);
+			return line > 0 && pos == m_document->lineBegin(line)
+				? m_document->lineEnd(line - 1)
+				: m_document->prevCharPos(pos);
+		}
+
+		uint64 nextPos(uint64 pos) const
+		{
+			const size_t line = m_document->lineAt(pos);
+			return line + 1 < m_document->lineCount() && pos == m_document->lineEnd(line)
+				? m_document->lineBegin(line + 1)
+				: m_document->nextCharPos(pos);
+		}
+
+		void moveCaret(uint64 pos, bool select)
+		{
+			m_caret = pos;
+			if (not select)
+			{
+				m_anchor = pos;
+			}
+			m_preferredX = none;
+			m_document->breakUndoGroup();
+		}
+
+		void moveVertical(int64 lines, bool select)
+		{
+			const size_t line = m_document->lineAt(m_caret);
+			if (not m_preferredX)
+			{
+				m_preferredX = lineLayout(line).xAt(m_caret);
+			}
+			const double x = *m_preferredX;
+
+			const int64 target = static_cast<int64>(line) + lines;
+			uint64 pos;
+			if (target < 0)
+			{
+				pos = 0;
+			}
+			else if (target >= static_cast<int64>(m_document->lineCount()))
+			{
+				pos = m_document->size();
+			}
+			else
+			{
+				pos = lineLayout(static_cast<size_t>(target)).posAt(x);
+			}
+
+			moveCaret(pos, select);
+			m_preferredX = x;
+		}
+
+		void eraseSelection()
+		{
+			const auto [begin, end] = selection();
+			m_document->erase(begin, end);
+			m_caret = m_anchor = begin;
+		}
+
+		void replaceSelection(const StringView text)
+		{
+			if (hasSelection())
+			{
+				eraseSelection();
+			}
+
+			const uint64 size = m_document->size();
+			m_document->insert(m_caret, text);
+			m_caret += m_document->size() - size;
+			m_anchor = m_caret;
+			m_preferredX = none;
+		}
+
+		void handleKeys(size_t pageLines)
+		{
+			auto& document = *m_document;
+			const bool ctrl = KeyControl.pressed();
+			const bool shift = KeyShift.pressed();
+
+			// BackspaceとEnterは文字として届く (押し続けたときの繰り返しもOSに任せる)
+			String typed;
+			for (char32 ch : TextInput::GetRawInput())
+			{
+				if (ch == U'\b')
+				{
+					if (not typed.isEmpty())
+					{
+						replaceSelection(typed);
+						typed.clear();
+					}
+
+					if (not hasSelection())
+					{
+						m_anchor = prevPos(m_caret);
+					}
+					eraseSelection();
+					m_preferredX = none;
+				}
+				else if (ch == U'\r' || ch == U'\n')
+				{
+					typed.push_back(U'\n');
+				}
+				else if (ch == U'\t' || (U' ' <= ch && ch != 0x7F))
+				{
+					typed.push_back(ch);
+				}
+			}
+			if (not typed.isEmpty())
+			{
+				replaceSelection(typed);
+			}
+
+			if (m_deleteRepeat.update(KeyDelete.pressed()))
+			{
+				if (not hasSelection())
+				{
+					m_anchor = nextPos(m_caret);
+				}
+				eraseSelection();
+				m_preferredX = none;
+			}
+
+			// 選択したまま左右に動かすと、選択範囲の端に移る
+			if (m_leftRepeat.update(KeyLeft.pressed()))
+			{
+				moveCaret(hasSelection() && not shift ? selection().first : prevPos(m_caret), shift);
+			}
+			if (m_rightRepeat.update(KeyRight.pressed()))
+			{
+				moveCaret(hasSelection() && not shift ? selection().second : nextPos(m_caret), shift);
+			}
+			if (m_upRepeat.update(KeyUp.pressed()))
+			{
+				moveVertical(-1, shift);
+			}
+			if (m_downRepeat.update(KeyDown.pressed()))
+			{
+				moveVertical(1, shift);
+			}
+			if (m_pageUpRepeat.update(KeyPageUp.pressed()))
+			{
+				moveVertical(-static_cast<int64>(pageLines), shift);
+			}
+			if (m_pageDownRepeat.update(KeyPageDown.pressed()))
+			{
+				moveVertical(static_cast<int64>(pageLines), shift);
+			}
+			if (KeyHome.down())
+			{
+				moveCaret(ctrl ? 0 : document.lineBegin(document.lineAt(m_caret)), shift);
+			}
+			if (KeyEnd.down())
+			{
+				moveCaret(ctrl ? document.size() : document.lineEnd(document.lineAt(m_caret)), shift);
+			}
+
+			if (not ctrl)
+			{
+				return;
+			}
 
-		{
-			ScopedViewport2D sv{ m_layout->clientRect };
+			if (KeyA.down())
+			{
+				m_anchor = 0;
+				m_caret = document.size();
+				m_preferredX = none;
+			}
+			if ((KeyC.down() || KeyX.down()) && hasSelection())
 			{
-				Transformer2D t{ Mat3x2::Translate(m_contentLocalRect.pos), Transformer2D::Target::SetLocal };
-				for (auto& control : m_controls)
+				const auto [begin, end] = selection();
+				Clipboard::SetText(document.text(begin, end));
+				if (KeyX.down())
 				{
-					control->draw();
+					eraseSelection();
 				}
 			}
+			if (KeyV.down())
 			{
-				Transformer2D t{ Mat3x2::Identity(), Transformer2D::Target::SetLocal };
-				for (auto& scrollBar : m_scrollBars)
+				if (String text; Clipboard::GetText(text))
 				{
-					scrollBar.draw();
+					replaceSelection(text);
 				}
 			}
+
+			Optional<uint64> restored;
+			if (KeyZ.down())
+			{
+				restored = shift ? document.redo() : document.undo();
+			}
+			else if (KeyY.down())
+			{
+				restored = document.redo();
+			}
+			if (restored)
+			{
+				m_caret = m_anchor = *restored;
+				m_preferredX = none;
+			}
 		}
-	}
 
-	IControl& WindowImpl::nextControlImpl(const std::shared_ptr<IControl>& control)
+		// 入力はTextEditorInput、行はTextEditorLineとして配置する
+
+		Size computeSize() const override
+		{
+			return { 0, 0 };
+		}
+
+		void update(Rect, Optional<Vec2>) override
+		{ }
+
+		void draw() const override
+		{ }
+	};
+
+	// 行より先に配置して入力を処理し、表示領域の背景を描く
+	class TextEditorInput : public IControl
 	{
-		if (m_nextControlIdx < m_controls.size())
+	public:
+
+		using Config = Config::TextEditor;
+
+		TextEditor* editor = nullptr;
+
+		// 配置した矩形の左上のコンテンツ座標
+		Vec2 origin{ 0, 0 };
+
+	private:
+
+		Rect m_rect{ 0, 0, 0, 0 };
+
+		Size computeSize() const override
 		{
-			m_controls[m_nextControlIdx] = control;
+			return { 0, 0 };
 		}
-		else
+
+		void update(Rect rect, Optional<Vec2> cursorPos) override
 		{
-			m_controls.push_back(control);
+			m_rect = rect;
+			editor->handleInput(rect, cursorPos, origin);
 		}
-		m_nextControlIdx++;
 
-		return *control;
-	}
+		void draw() const override
+		{
+			m_rect.draw(Config::BackgroundColor);
+		}
+	};
 
-	IControl& WindowImpl::nextStatelessControlImpl(const std::type_info& type, ControlGenerator& generator)
+	class TextEditorLine : public IControl
 	{
-		if (m_nextControlIdx < m_controls.size() &&
-			typeid(*m_controls[m_nextControlIdx]) != type)
+	public:
+
+		using Config = Config::TextEditor;
+
+		const TextEditor* editor = nullptr;
+
+		std::shared_ptr<const TextLineLayout> layout;
+
+		DrawableText text;
+
+		bool lastLine = false;
+
+	private:
+
+		Rect m_rect{ 0, 0, 0, 0 };
+
+		Size computeSize() const override
 		{
-			m_controls.resize(m_nextControlIdx);
+			return m_rect.size;
 		}
 
-		if (m_nextControlIdx >= m_controls.size())
+		void update(Rect rect, Optional<Vec2>) override
 		{
-			m_controls.emplace_back(std::shared_ptr<IControl>(generator()));
-			// Console << U"[+Control] " << Unicode::FromUTF8(type.name());
+			m_rect = rect;
 		}
 
-		auto& control = m_controls[m_nextControlIdx];
+		void draw() const override
+		{
+			const double left = m_rect.x + Config::TextPadding;
+
+			const auto [selectionBegin, selectionEnd] = editor->selection();
+			if (selectionBegin < selectionEnd && selectionBegin <= layout->end() && layout->begin < selectionEnd)
+			{
+				// 改行まで選択されていれば改行の分も塗る
+				const double x0 = layout->xAt(selectionBegin);
+				const double x1 = selectionEnd > layout->end() && not lastLine
+					? layout->width() + m_rect.h * Config::NewlineWidthScale
+					: layout->xAt(selectionEnd);
+				RectF{ left + x0, m_rect.y, x1 - x0, m_rect.h }
+					.draw(editor->isActive() ? Config::SelectionColor : Config::InactiveSelectionColor);
+			}
 
-		m_nextControlIdx++;
+			text.draw(left, m_rect.y, Config::TextColor);
 
-		return *control;
+			const uint64 caret = editor->caret();
+			if (editor->caretVisible() && layout->begin <= caret && caret <= layout->end())
+			{
+				RectF{ left + layout->xAt(caret) - Config::CaretWidth * 0.5, m_rect.y, Config::CaretWidth, m_rect.h }
+					.draw(Config::CaretColor);
+			}
+		}
+	};
+
+	bool GUIManager::textEditor(const StringView id, TextDocument& document, SizeF size)
+	{
+		using Config = Config::TextEditor;
+
+		auto& window = getCurrentWindowImpl();
+
+		auto& editor = window.nextStatefulControl<TextEditor>(id.hash());
+		editor.init(document, window.window.font);
+
+		size_t bodyId = id.hash();
+		s3d::detail::HashCombine(bodyId, typeid(TextEditor).hash_code());
+		window.beginChild(bodyId, size);
+
+		const double lineHeight = window.window.font.height();
+		RectF viewport = window.childViewport();
+
+		// 内容が表示領域より小さくても全体で入力を受け付ける
+		const double viewWidth = Max(0.0, viewport.w - window.window.padding);
+		const double viewHeight = Max(0.0, viewport.h - window.window.padding);
+		const auto contentSize = [&]()
+		{
+			return SizeF{
+				Max(editor.contentWidth(), viewWidth),
+				Max(lineHeight * document.lineCount(), viewHeight)
+			};
+		};
+
+		// 入力は行より先に処理して、このフレームの表示に反映する
+		const SizeF inputArea = contentSize();
+		auto& input = window.nextStatelessControl<TextEditorInput>();
+		input.editor = &editor;
+		input.origin = viewport.pos;
+
+		// 内容を超えて配置すると広がり続けるので、その中に収める
+		window.updateControlAt(input, window.placeRect({
+			viewport.pos,
+			Clamp(inputArea.x - viewport.x, 0.0, viewport.w),
+			Clamp(inputArea.y - viewport.y, 0.0, viewport.h)
+		}));
+
+		// キャレットが動いたら見えるまでスクロールする
+		if (editor.caretMoved())
+		{
+			window.scrollChildToShow(editor.caretRect(), contentSize());
+			viewport = window.childViewport();
+		}
+
+		// 表示されている行だけを整形する
+		const size_t lineCount = document.lineCount();
+		const size_t firstLine = Min(lineCount, static_cast<size_t>(Max(0.0, viewport.y / lineHeight)));
+		const size_t lastLine = Min(lineCount, static_cast<size_t>(Max(0.0, Math::Ceil((viewport.y + viewport.h) / lineHeight))));
+
+		for (size_t i = firstLine; i < lastLine; i++)
+		{
+			auto& line = window.nextStatelessControl<TextEditorLine>();
+			line.editor = &editor;
+			line.layout = editor.sharedLineLayout(i);
+			line.text = window.window.font(line.layout->text);
+			line.lastLine = i + 1 == lineCount;
+
+			const double width = line.layout->width() + Config::TextPadding * 2;
+			editor.extendWidth(width);
+			window.updateControlAt(line, window.placeRect({ 0, lineHeight * i, Max(width, viewWidth), lineHeight }));
+		}
+
+		// 整形しなかった行の分も確保してスクロールバーを合わせる
+		window.placeRect({ { 0, 0 }, contentSize() });
+
+		window.endChild();
+
+		return editor.changed();
 	}
 
-	IControl& WindowImpl::nextStatefulControlImpl(size_t id, ControlGenerator& generator)
+	// TiledImage
+
+	// 2x2ピクセルの平均で半分の大きさにする (奇数の端は同じピクセルを使う)
+	static s3d::Image HalveImage(const s3d::Image& image)
 	{
-		s3d::detail::HashCombine(id, m_randomId);
+		const int32 width = image.width();
+		const int32 height = image.height();
+		s3d::Image result{ static_cast<size_t>((width + 1) / 2), static_cast<size_t>((height + 1) / 2) };
 
-		auto controlItr = m_savedControls.find(id);
-		if (controlItr == m_savedControls.end())
+		for (int32 y = 0; y < result.height(); y++)
 		{
-			auto [tmp, _] = m_savedControls.emplace(
-				id,
-				std::shared_ptr<IControl>(generator())
-			);
-			controlItr = tmp;
-			// Console << U"[+Control] " << id;
+			const Color* row0 = image[Min(y * 2, height - 1)];
+			const Color* row1 = image[Min(y * 2 + 1, height - 1)];
+			Color* dst = result[y];
+			for (int32 x = 0; x < result.width(); x++)
+			{
+				const int32 x0 = Min(x * 2, width - 1);
+				const int32 x1 = Min(x * 2 + 1, width - 1);
+				dst[x] = Color{
+					static_cast<uint8>((row0[x0].r + row0[x1].r + row1[x0].r + row1[x1].r + 2) / 4),
+					static_cast<uint8>((row0[x0].g + row0[x1].g + row1[x0].g + row1[x1].g + 2) / 4),
+					static_cast<uint8>((row0[x0].b + row0[x1].b + row1[x0].b + row1[x1].b + 2) / 4),
+					static_cast<uint8>((row0[x0].a + row0[x1].a + row1[x0].a + row1[x1].a + 2) / 4)
+				};
+			}
 		}
+		return result;
+	}
 
-		auto& control = controlItr->second;
+	ImagePyramidSource::ImagePyramidSource(s3d::Image image)
+	{
+		m_levels.push_back(std::move(image));
+		while (m_levels.back().width() > 1 || m_levels.back().height() > 1)
+		{
+			m_levels.push_back(HalveImage(m_levels.back()));
+		}
+	}
+
+	s3d::Image ImagePyramidSource::decode(int32 level, const Rect& region) const
+	{
+		return m_levels[Min<size_t>(level, m_levels.size() - 1)].clipped(region);
+	}
+
+	MappedRawImageSource::MappedRawImageSource(const FilePathView path, Size size, uint64 offset)
+	{
+		open(path, size, offset);
+	}
+
+	bool MappedRawImageSource::open(const FilePathView path, Size size, uint64 offset)
+	{
+		m_memory = {};
+		m_file.close();
+		m_size = { 0, 0 };
+		m_offset = 0;
 
-		if (m_nextControlIdx < m_controls.size())
+		if (size.x <= 0 || size.y <= 0 || not m_file.open(path))
 		{
-			m_controls[m_nextControlIdx] = control;
+			return false;
 		}
-		else
+
+		// 仮想メモリに割り当てるだけで、読まれたページだけが読み込まれる
+		m_memory = m_file.mapAll();
+		if (not m_memory.data || offset + uint64{ 4 } * size.x * size.y > m_memory.size)
 		{
-			m_controls.push_back(control);
+			m_memory = {};
+			m_file.close();
+			return false;
 		}
-		m_nextControlIdx++;
 
-		return *control;
+		m_size = size;
+		m_offset = offset;
+		return true;
 	}
 
-	void WindowImpl::updateWindowState()
+	const Byte* MappedRawImageSource::rowPtr(int32 y) const
 	{
-		m_isContentHovered = false;
+		return m_memory.data + m_offset + uint64{ 4 } * m_size.x * y;
+	}
 
-		Rect& windowRect = window.rect;
-		if (auto cursor = m_input->getCursorPos(*this))
+	s3d::Image MappedRawImageSource::decode(int32 level, const Rect& region) const
+	{
+		if (not isOpen())
+		{
+			return {};
+		}
+
+		level = Clamp(level, 0, 30);
+		const int32 scale = 1 << level;
+		const Size levelSize{ (m_size.x + scale - 1) >> level, (m_size.y + scale - 1) >> level };
+		const int32 left = Max(region.x, 0);
+		const int32 top = Max(region.y, 0);
+		const int32 right = Min(region.x + region.w, levelSize.x);
+		const int32 bottom = Min(region.y + region.h, levelSize.y);
+		if (right <= left || bottom <= top)
 		{
-			if (rect().contains(*cursor))
+			return {};
+		}
+
+		s3d::Image result{ static_cast<size_t>(right - left), static_cast<size_t>(bottom - top) };
+
+		if (level == 0)
+		{
+			for (int32 y = top; y < bottom; y++)
 			{
-				m_input->hover(*this);
-				window.requestMoveToFront |= MouseL.down();
+				std::memcpy(result[y - top], rowPtr(y) + uint64{ 4 } * left, size_t{ 4 } * (right - left));
 			}
+			return result;
+		}
 
-			switch (m_state)
-			{
-			case SasaGUI::WindowState::Default:
+		// 縮小段の1画素にあたる範囲の中央の2x2画素の平均にする (1段目は範囲全体の平均と同じ)
+		const auto center = [&](int32 pos, int32 limit) {
+			return Min((pos << level) + scale / 2 - 1, limit - 1);
+		};
 
-				m_resizeFlag = ResizeFlag::None;
-				for (int32 i = 0; i < static_cast<int32>(Side::Count); i++)
-				{
-					auto& grip = m_layout->resizeGripRect[i];
+		for (int32 y = top; y < bottom; y++)
+		{
+			const int32 y0 = center(y, m_size.y);
+			const Byte* row0 = rowPtr(y0);
+			const Byte* row1 = rowPtr(Min(y0 + 1, m_size.y - 1));
+			Color* dst = result[y - top];
 
-					if (grip.contains(*cursor))
-					{
-						m_resizeFlag |= static_cast<ResizeFlag>(1 << i);
-					}
-				}
-				if (m_resizeFlag != ResizeFlag::None)
+			for (int32 x = left; x < right; x++)
+			{
+				const int32 x0 = center(x, m_size.x);
+				const int32 x1 = Min(x0 + 1, m_size.x - 1);
+				const Byte* p[4] = { row0 + x0 * 4, row0 + x1 * 4, row1 + x0 * 4, row1 + x1 * 4 };
+
+				uint8 channels[4];
+				for (int32 c = 0; c < 4; c++)
 				{
-					if (window.isResizable() && MouseL.down())
-					{
-						m_state = WindowState::Resizing;
-						window.requestMoveToFront = true;
-						m_input->capture(*this, true);
-					}
-					m_input->hover(*this);
-					break;
+					const int32 sum = static_cast<int32>(p[0][c]) + static_cast<int32>(p[1][c]) + static_cast<int32>(p[2][c]) + static_cast<int32>(p[3][c]);
+					channels[c] = static_cast<uint8>((sum + 2) / 4);
 				}
+				dst[x - left] = Color{ channels[0], channels[1], channels[2], channels[3] };
+			}
+		}
+		return result;
+	}
 
-				if (m_layout->titlebarRect.contains(*cursor))
+	// 使った順に並べ、大きさの合計が予算を超えたら古いものから捨てるキャッシュ
+	template<class Value>
+	class LruCache
+	{
+	public:
+
+		// 見つかったら最も新しく使ったことにする
+		Value* find(uint64 key, uint64 frame)
+		{
+			auto itr = m_entries.find(key);
+			if (itr == m_entries.end())
+			{
+				return nullptr;
+			}
+
+			m_order.splice(m_order.begin(), m_order, itr->second.order);
+			itr->second.lastUsed = frame;
+			return &itr->second.value;
+		}
+
+		// 使ったことにせずに探す
+		const Value* peek(uint64 key) const
+		{
+			auto itr = m_entries.find(key);
+			return itr == m_entries.end() ? nullptr : &itr->second.value;
+		}
+
+		Value& insert(uint64 key, Value value, size_t bytes, uint64 frame)
+		{
+			erase(key);
+
+			m_order.push_front(key);
+			m_bytes += bytes;
+			return m_entries.emplace(key, Entry{ std::move(value), bytes, frame, m_order.begin() }).first->second.value;
+		}
+
+		void erase(uint64 key)
+		{
+			auto itr = m_entries.find(key);
+			if (itr == m_entries.end())
+			{
+				return;
+			}
+
+			m_bytes -= itr->second.bytes;
+			m_order.erase(itr->second.order);
+			m_entries.erase(itr);
+		}
+
+		// 予算を超えた分を古いものから捨てる (このフレームで使ったものは残す)
+		void trim(size_t budget, uint64 frame)
+		{
+			while (m_bytes > budget && not m_order.empty())
+			{
+				const uint64 key = m_order.back();
+				if (m_entries.at(key).lastUsed == frame)
 				{
-					if (window.isMovable() && MouseL.down())
-					{
-						m_state = WindowState::Moving;
-						m_input->capture(*this, true);
-					}
 					break;
 				}
+				erase(key);
+			}
+		}
+
+		// 最も古いものを取り出す (このフレームで使ったものしかなければnone)
+		Optional<Value> popLeastRecent(uint64 frame)
+		{
+			if (m_order.empty())
+			{
+				return none;
+			}
+
+			const uint64 key = m_order.back();
+			auto itr = m_entries.find(key);
+			if (itr->second.lastUsed == frame)
+			{
+				return none;
+			}
+
+			Value value = std::move(itr->second.value);
+			erase(key);
+			return value;
+		}
+
+		void clear()
+		{
+			m_entries.clear();
+			m_order.clear();
+			m_bytes = 0;
+		}
+
+	private:
+
+		struct Entry
+		{
+			Value value;
+
+			size_t bytes;
+
+			uint64 lastUsed;
+
+			std::list<uint64>::iterator order;
+		};
+
+		HashTable<uint64, Entry> m_entries;
+
+		// 先頭ほど最近使ったキー
+		std::list<uint64> m_order;
+
+		size_t m_bytes = 0;
+	};
+
+	class TiledImage : public IControl
+	{
+	public:
+
+		using Config = Config::TiledImage;
+
+		std::shared_ptr<const ITiledImageSource> source;
+
+		Size size{ 0, 0 };
+
+		Optional<Vec2> hoveredPos() const { return m_hovered; }
+
+	private:
+
+		// 画像座標とローカル座標の変換
+		struct ViewTransform
+		{
+			// 原寸の1ピクセルの表示上の大きさ
+			double scale;
+
+			// 表示領域の左上に来る画像座標
+			Vec2 origin;
+
+			Vec2 areaPos;
+
+			Vec2 toLocal(Vec2 pos) const { return areaPos + (pos - origin) * scale; }
+
+			Vec2 toImage(Vec2 local) const { return origin + (local - areaPos) / scale; }
+		};
+
+		struct DrawItem
+		{
+			Texture texture;
+
+			// テクスチャ内の範囲
+			RectF source;
+
+			// 表示する範囲 (ローカル座標)
+			RectF rect;
+		};
+
+		std::shared_ptr<const ITiledImageSource> m_source;
+
+		Size m_imageSize{ 0, 0 };
+
+		int32 m_levelCount = 1;
+
+		// 読み込み中のタイル
+		HashTable<uint64, AsyncTask<s3d::Image>> m_pending;
+
+		// 画像が変わって不要になったタスク (完了を待たずに、終わったものから捨てる)
+		Array<AsyncTask<s3d::Image>> m_staleTasks;
+
+		LruCache<s3d::Image> m_images;
+
+		LruCache<Texture> m_textures;
 
-				if (m_layout->contentRect.contains(*cursor))
-				{
-					m_scrollBars[0].scroll(Mouse::WheelH() * window.font.height() * Config::ScrollSpeed);
-					m_scrollBars[1].scroll(Mouse::Wheel() * window.font.height() * Config::ScrollSpeed);
-				}
+		uint64 m_frame = 0;
 
-				if (m_scrollBars[0].rect().contains(*cursor))
-				{
-					if (MouseL.down())
-					{
-						m_state = WindowState::Scrolling;
-						m_input->capture(*this, true);
-					}
-					break;
-				}
+		// 表示している画像座標の範囲 (noneのときは全体)
+		Optional<RectF> m_view;
 
-				if (m_scrollBars[0].rect().contains(*cursor))
-				{
-					if (MouseL.down())
-					{
-						m_state = WindowState::Scrolling;
-						m_input->capture(*this, true);
-					}
-					break;
-				}
+		Rect m_rect{ 0, 0, 0, 0 };
 
-				m_isContentHovered = m_layout->contentRect.contains(*cursor);
+		Optional<Vec2> m_hovered;
 
-				break;
-			case SasaGUI::WindowState::Moving:
-			case SasaGUI::WindowState::Resizing:
-			case SasaGUI::WindowState::Scrolling:
-				if (not MouseL.pressed())
-				{
-					m_state = WindowState::Default;
-					m_input->capture(*this, false);
-				}
-				break;
-			}
+		Optional<Vec2> m_selectionBegin;
+
+		Vec2 m_selectionEnd{ 0, 0 };
+
+		Optional<Vec2> m_panBegin;
+
+		Array<DrawItem> m_drawList;
+
+		static uint64 TileKey(int32 level, int32 x, int32 y)
+		{
+			return (static_cast<uint64>(level) << 56) | (static_cast<uint64>(y) << 28) | static_cast<uint64>(x);
 		}
-	}
 
-	void WindowImpl::handleMovingState()
-	{
-		if (m_state != WindowState::Moving)
+		static Vec2 ClampToArea(Vec2 pos, const RectF& area)
 		{
-			return;
+			return { Clamp(pos.x, area.x, area.rightX()), Clamp(pos.y, area.y, area.bottomY()) };
 		}
 
-		window.rect.pos += Cursor::Delta();
-	}
+		static RectF SelectionRect(Vec2 a, Vec2 b)
+		{
+			return { Min(a.x, b.x), Min(a.y, b.y), Abs(b.x - a.x), Abs(b.y - a.y) };
+		}
 
-	void WindowImpl::handleResizingState()
-	{
-		if (m_state != WindowState::Resizing)
+		RectF area() const
 		{
-			return;
+			return RectF{ m_rect.size }.stretched(-1);
 		}
 
-		auto delta = Cursor::Delta();
-		Size min = minSize();
+		RectF view() const
+		{
+			return m_view.value_or(RectF{ m_imageSize });
+		}
 
-		if (m_resizeFlag & ResizeFlag::Left)
+		// 表示範囲を縦横比を保ったまま表示領域に収める
+		ViewTransform transform(const RectF& area) const
 		{
-			delta.x = Min(delta.x, window.rect.w - min.x);
-			window.rect.x += delta.x;
-			window.rect.w -= delta.x;
+			const RectF view = this->view();
+			const double scale = Min(Min(area.w / view.w, area.h / view.h), Config::MaxScale);
+			return { scale, view.center() - area.size / (scale * 2), area.pos };
 		}
-		else if (m_resizeFlag & ResizeFlag::Right)
+
+		Size levelSize(int32 level) const
 		{
-			window.rect.w = Max(window.rect.w + delta.x, min.x);
+			return {
+				Max(1, (m_imageSize.x + (1 << level) - 1) >> level),
+				Max(1, (m_imageSize.y + (1 << level) - 1) >> level)
+			};
 		}
 
-		if (m_resizeFlag & ResizeFlag::Top)
+		Rect tileRect(int32 level, int32 x, int32 y) const
 		{
-			delta.y = Min(delta.y, window.rect.h - min.y);
-			window.rect.y += delta.y;
-			window.rect.h -= delta.y;
+			const Size size = levelSize(level);
+			const Point pos{ x * Config::TileSize, y * Config::TileSize };
+			return { pos, Min(Config::TileSize, size.x - pos.x), Min(Config::TileSize, size.y - pos.y) };
 		}
-		else if (m_resizeFlag & ResizeFlag::Bottom)
+
+		Size computeSize() const override
 		{
-			window.rect.h = Max(window.rect.h + delta.y, min.y);
+			return size;
 		}
-	}
 
-	void WindowImpl::updateLayout()
-	{
-		if (not window.hasTitlebar())
+		void update(Rect rect, Optional<Vec2> cursorPos) override
 		{
-			m_layout = WindowLayout{
-				.titlebarRect = { 0, 0, 0, 0 },
-				.clientRect = window.rect,
-				.contentRect = window.rect
-			};
+			m_rect = rect;
+			m_frame++;
 
-			// ResizeGrip
+			setSource(source);
+			collectTiles();
 
-			if (window.isResizable())
+			const Optional<Vec2> localCursor = cursorPos.map([&](Vec2 v) { return v - m_rect.pos; });
+			updateView(localCursor);
+
+			m_hovered = none;
+			const RectF area = this->area();
+			if (m_source && localCursor && area.contains(*localCursor) && area.w > 0 && area.h > 0)
 			{
-				// Top
-				m_layout->resizeGripRect[0] = {
-					window.rect.leftX() - Config::ResizeGripSize,
-					window.rect.topY() - Config::ResizeGripSize,
-					window.rect.w + Config::ResizeGripSize * 2,
-					Config::ResizeGripSize
-				};
-				// Right
-				m_layout->resizeGripRect[1] = {
-					window.rect.rightX(),
-					window.rect.topY() - Config::ResizeGripSize,
-					Config::ResizeGripSize,
-					window.rect.h + Config::ResizeGripSize * 2,
-				};
-				// Bottom
-				m_layout->resizeGripRect[2] = {
-					window.rect.leftX() - Config::ResizeGripSize,
-					window.rect.bottomY(),
-					window.rect.w + Config::ResizeGripSize * 2,
-					Config::ResizeGripSize
-				};
-				// Left
-				m_layout->resizeGripRect[3] = {
-					window.rect.leftX() - Config::ResizeGripSize,
-					window.rect.topY() - Config::ResizeGripSize,
-					Config::ResizeGripSize,
-					window.rect.h + Config::ResizeGripSize * 2,
-				};
+				const Vec2 pos = transform(area).toImage(*localCursor);
+				if (RectF{ m_imageSize }.contains(pos))
+				{
+					m_hovered = pos;
+				}
 			}
+
+			updateTiles();
 		}
-		else
-		{
-			Rect client{
-				window.rect.x,
-				window.rect.y + titlebarHeight(),
-				window.rect.w,
-				window.rect.h - titlebarHeight()
-			};
-			m_layout = WindowLayout{
-				.titlebarRect = {
-					window.rect.pos,
-					window.rect.w,
-					titlebarHeight()
-				},
-				.clientRect = client,
-				.contentRect = client
-			};
 
-			// ResizeGrip
+		void setSource(const std::shared_ptr<const ITiledImageSource>& newSource)
+		{
+			if (m_source == newSource)
+			{
+				return;
+			}
+			m_source = newSource;
 
-			if (window.isResizable())
+			for (auto& [key, task] : m_pending)
 			{
-				// Top
-				m_layout->resizeGripRect[0] = {
-					window.rect.leftX() - Config::ResizeGripSize,
-					window.rect.topY(),
-					window.rect.w + Config::ResizeGripSize * 2,
-					Config::ResizeGripSize
-				};
-				// Right
-				m_layout->resizeGripRect[1] = {
-					window.rect.rightX(),
-					window.rect.topY(),
-					Config::ResizeGripSize,
-					window.rect.h + Config::ResizeGripSize,
-				};
-				// Bottom
-				m_layout->resizeGripRect[2] = {
-					window.rect.leftX() - Config::ResizeGripSize,
-					window.rect.bottomY(),
-					window.rect.w + Config::ResizeGripSize * 2,
-					Config::ResizeGripSize
-				};
-				// Left
-				m_layout->resizeGripRect[3] = {
-					window.rect.leftX() - Config::ResizeGripSize,
-					window.rect.topY(),
-					Config::ResizeGripSize,
-					window.rect.h + Config::ResizeGripSize,
-				};
+				m_staleTasks.push_back(std::move(task));
+			}
+			m_pending.clear();
+			m_images.clear();
+			m_textures.clear();
+			m_view = none;
+
+			// 最も粗い段が1枚のタイルに収まるまで段を重ねる
+			m_imageSize = m_source ? m_source->size() : Size{ 0, 0 };
+			m_levelCount = 1;
+			while (levelSize(m_levelCount - 1).x > Config::TileSize || levelSize(m_levelCount - 1).y > Config::TileSize)
+			{
+				m_levelCount++;
 			}
 		}
 
-		//スクロールバー
+		// 読み終わったタイルを画像のキャッシュに移す
+		void collectTiles()
+		{
+			m_staleTasks.remove_if([](const AsyncTask<s3d::Image>& task) { return task.isReady(); });
 
-		bool hbar = false;
-		bool vbar = false;
+			Array<uint64> finished;
+			for (auto& [key, task] : m_pending)
+			{
+				if (task.isReady())
+				{
+					s3d::Image image = task.get();
+					const size_t bytes = static_cast<size_t>(image.width()) * image.height() * sizeof(Color);
+					m_images.insert(key, std::move(image), bytes, m_frame);
+					finished.push_back(key);
+				}
+			}
+			for (const auto key : finished)
+			{
+				m_pending.erase(key);
+			}
+		}
 
-		if (not (window.flags & WindowFlag::NoScrollbar))
+		// 左ドラッグで選択した範囲に拡大し、右ドラッグで移動、右クリックで全体に戻す
+		void updateView(Optional<Vec2> localCursor)
 		{
-			hbar = m_contentLocalRect.w > m_layout->contentRect.w;
-			vbar = m_contentLocalRect.h > m_layout->contentRect.h;
+			const RectF area = this->area();
+			if (not m_source || area.w <= 0 || area.h <= 0)
+			{
+				return;
+			}
 
-			// バーの表示によってコントロールが隠れるときはスクロールバーを表示
+			if (m_selectionBegin)
+			{
+				if (localCursor)
+				{
+					m_selectionEnd = ClampToArea(*localCursor, area);
+				}
 
-			if (hbar)
+				if (not MouseL.pressed())
+				{
+					const RectF selection = SelectionRect(*m_selectionBegin, m_selectionEnd);
+					if (selection.w >= Config::MinSelectionSize && selection.h >= Config::MinSelectionSize)
+					{
+						const ViewTransform current = transform(area);
+						m_view = SelectionRect(current.toImage(selection.pos), current.toImage(selection.br()));
+					}
+					m_selectionBegin = none;
+				}
+				return;
+			}
+
+			if (m_panBegin)
 			{
-				vbar |= m_contentLocalRect.h > m_layout->contentRect.h - ScrollBar::Thickness;
+				if (MouseR.pressed())
+				{
+					m_view = view().movedBy(-Cursor::DeltaF() / transform(area).scale);
+				}
+				else
+				{
+					if (localCursor && localCursor->distanceFrom(*m_panBegin) < Config::ClickThreshold)
+					{
+						m_view = none;
+					}
+					m_panBegin = none;
+				}
+				return;
 			}
-			if (vbar)
+
+			if (not localCursor || not RectF{ m_rect.size }.contains(*localCursor))
 			{
-				hbar |= m_contentLocalRect.w > m_layout->contentRect.w - ScrollBar::Thickness;
+				return;
 			}
-		}
 
-		// バーの大きさとコントロールが表示できる領域を決定
+			if (MouseL.down())
+			{
+				m_selectionBegin = m_selectionEnd = ClampToArea(*localCursor, area);
+			}
+			else if (MouseR.down())
+			{
+				m_panBegin = *localCursor;
+			}
+		}
 
-		if (hbar && vbar)
+		// 表示倍率に合った段の見えているタイルを集め、ないタイルは読み込みを始めて粗い段で代用する
+		void updateTiles()
 		{
-			m_scrollBars[0].updateLayout({
-				0,
-				m_layout->clientRect.h - ScrollBar::Thickness,
-				m_layout->clientRect.w - ScrollBar::Thickness,
-				ScrollBar::Thickness
-			});
-			m_scrollBars[1].updateLayout({
-				m_layout->clientRect.w - ScrollBar::Thickness,
-				0,
-				ScrollBar::Thickness,
-				m_layout->clientRect.h - ScrollBar::Thickness
+			m_drawList.clear();
+
+			const RectF area = this->area();
+			if (not m_source || area.w <= 0 || area.h <= 0)
+			{
+				return;
+			}
+
+			const ViewTransform transform = this->transform(area);
+
+			// 段の1ピクセルが表示上で1ピクセル以上になる最も粗い段を使う
+			const int32 level = Clamp(static_cast<int32>(Math::Floor(Math::Log2(1.0 / transform.scale))), 0, m_levelCount - 1);
+			const double levelScale = transform.scale * (1 << level);
+			const Size size = levelSize(level);
+			const Point tileCount{
+				(size.x + Config::TileSize - 1) / Config::TileSize,
+				(size.y + Config::TileSize - 1) / Config::TileSize
+			};
+
+			const Vec2 visibleBegin = transform.origin / (1 << level) / Config::TileSize;
+			const Vec2 visibleEnd = visibleBegin + area.size / levelScale / Config::TileSize;
+			const Point first{
+				Clamp(static_cast<int32>(Math::Floor(visibleBegin.x)), 0, tileCount.x),
+				Clamp(static_cast<int32>(Math::Floor(visibleBegin.y)), 0, tileCount.y)
+			};
+			const Point last{
+				Clamp(static_cast<int32>(Math::Ceil(visibleEnd.x)), 0, tileCount.x),
+				Clamp(static_cast<int32>(Math::Ceil(visibleEnd.y)), 0, tileCount.y)
+			};
+
+			// 中央に近いタイルから読み込む
+			Array<Point> tiles;
+			for (int32 y = first.y; y < last.y; y++)
+			{
+				for (int32 x = first.x; x < last.x; x++)
+				{
+					tiles.emplace_back(x, y);
+				}
+			}
+			const Vec2 center = (visibleBegin + visibleEnd) * 0.5;
+			std::sort(tiles.begin(), tiles.end(), [&](Point a, Point b)
+			{
+				return center.distanceFromSq(Vec2{ a } + Vec2{ 0.5, 0.5 }) < center.distanceFromSq(Vec2{ b } + Vec2{ 0.5, 0.5 });
 			});
-			m_layout->contentRect.h -= ScrollBar::Thickness;
-			m_layout->contentRect.w -= ScrollBar::Thickness;
+
+			// 最も粗い段は常に読み込んでおき、他のタイルが揃うまでの代わりにする
+			int32 uploads = 0;
+			acquire(m_levelCount - 1, 0, 0, uploads);
+
+			for (const auto& tile : tiles)
+			{
+				const Rect region = tileRect(level, tile.x, tile.y);
+				const RectF rect{
+					transform.toLocal(Vec2{ region.pos } * (1 << level)),
+					Vec2{ region.size } * levelScale
+				};
+
+				if (const Texture* texture = acquire(level, tile.x, tile.y, uploads))
+				{
+					addDrawItem(*texture, RectF{ region.size }, rect, area);
+					continue;
+				}
+
+				// 読み込まれている最も近い祖先のタイルの対応する部分を拡大する
+				for (int32 ancestor = level + 1; ancestor < m_levelCount; ancestor++)
+				{
+					const int32 shift = ancestor - level;
+					const Point ancestorTile{ tile.x >> shift, tile.y >> shift };
+					if (const Texture* texture = m_textures.find(TileKey(ancestor, ancestorTile.x, ancestorTile.y), m_frame))
+					{
+						const RectF source{
+							Vec2{ region.pos } / (1 << shift) - Vec2{ ancestorTile * Config::TileSize },
+							Vec2{ region.size } / (1 << shift)
+						};
+						addDrawItem(*texture, source, rect, area);
+						break;
+					}
+				}
+			}
+
+			m_textures.trim(Config::GpuBudget, m_frame);
+			m_images.trim(Config::CpuBudget, m_frame);
 		}
-		else
+
+		// テクスチャがあれば返し、なければ読み込み済みの画像から作るか読み込みを始める
+		const Texture* acquire(int32 level, int32 x, int32 y, int32& uploads)
 		{
-			if (hbar)
+			const uint64 key = TileKey(level, x, y);
+			if (const Texture* texture = m_textures.find(key, m_frame))
 			{
-				m_layout->contentRect.h -= ScrollBar::Thickness;
+				return texture;
 			}
 
-			if (vbar)
+			if (const s3d::Image* image = m_images.find(key, m_frame))
 			{
-				m_layout->contentRect.w -= ScrollBar::Thickness;
-			}
+				// テクスチャを作る数を抑えてフレームを止めない
+				if (uploads >= Config::UploadsPerFrame)
+				{
+					return nullptr;
+				}
+				uploads++;
 
-			m_scrollBars[0].updateLayout({
-				0,
-				m_layout->clientRect.h - ScrollBar::Thickness,
-				m_layout->clientRect.w - ScrollBar::Thickness,
-				ScrollBar::Thickness
-			});
+				const size_t bytes = static_cast<size_t>(image->width()) * image->height() * sizeof(Color);
+				return &m_textures.insert(key, Texture{ *image }, bytes, m_frame);
+			}
 
-			m_scrollBars[1].updateLayout({
-				m_layout->clientRect.w - ScrollBar::Thickness,
-				0,
-				ScrollBar::Thickness,
-				m_layout->clientRect.h - ScrollBar::Thickness
-			});
+			if (not m_pending.contains(key) && m_pending.size() < Threading::GetConcurrency())
+			{
+				m_pending.emplace(key, Async([source = m_source, level, region = tileRect(level, x, y)]()
+				{
+					return source->decode(level, region);
+				}));
+			}
+			return nullptr;
 		}
 
-		// スクロールバーの上限, 下限を更新
-
-		if (hbar)
+		// 表示領域からはみ出す部分はテクスチャの範囲ごと切り取る
+		void addDrawItem(const Texture& texture, const RectF& source, const RectF& rect, const RectF& area)
 		{
-			m_scrollBars[1].updateConstraints(0.0, m_contentLocalRect.h + ScrollBar::Thickness, m_layout->contentRect.h);
-		}
-		else
-		{
-			m_scrollBars[1].updateConstraints(0.0, m_contentLocalRect.h, m_layout->contentRect.h);
-		}
+			const double left = Max(rect.x, area.x);
+			const double top = Max(rect.y, area.y);
+			const double right = Min(rect.rightX(), area.rightX());
+			const double bottom = Min(rect.bottomY(), area.bottomY());
+			if (left >= right || top >= bottom)
+			{
+				return;
+			}
 
-		if (vbar)
-		{
-			m_scrollBars[0].updateConstraints(0.0, m_contentLocalRect.w + ScrollBar::Thickness, m_layout->contentRect.w);
+			const Vec2 ratio{ source.w / rect.w, source.h / rect.h };
+			m_drawList.push_back({
+				texture,
+				RectF{
+					source.x + (left - rect.x) * ratio.x,
+					source.y + (top - rect.y) * ratio.y,
+					(right - left) * ratio.x,
+					(bottom - top) * ratio.y
+				},
+				RectF{ left, top, right - left, bottom - top }
+			});
 		}
-		else
+
+		void draw() const override
 		{
-			m_scrollBars[0].updateConstraints(0.0, m_contentLocalRect.w, m_layout->contentRect.w);
+			m_rect
+				.draw(Config::BackgroundColor)
+				.drawFrame(1, 0, Config::FrameColor);
+
+			const Transformer2D transform{ Mat3x2::Translate(m_rect.pos) };
+
+			for (const auto& item : m_drawList)
+			{
+				item.texture(item.source)
+					.resized(item.rect.size)
+					.draw(item.rect.pos);
+			}
+
+			if (m_selectionBegin)
+			{
+				SelectionRect(*m_selectionBegin, m_selectionEnd).draw(Config::SelectionColor);
+			}
 		}
-	}
+	};
 
-	void WindowImpl::updateSize()
+	Optional<Vec2> GUIManager::tiledImage(const StringView id, const std::shared_ptr<const ITiledImageSource>& source, SizeF size)
 	{
-		Size& windowSize = window.rect.size;
+		auto& window = getCurrentWindowImpl();
+		auto& control = window.nextStatefulControl<TiledImage>(id.hash());
 
-		if (m_nextSize)
+		if (size.x <= 0.0)
 		{
-			Size min = minSize();
-			windowSize.x = Max(m_nextSize->size.x, min.x);
-			windowSize.y = Max(m_nextSize->size.y, min.y);
+			size.x = window.availableWidth().value_or(0.0);
 		}
-		else if (m_firstFrame || window.flags & WindowFlag::AutoResize)
-		{
-			windowSize = m_contentLocalRect.size;
-			windowSize.y += titlebarHeight();
 
-			Size min = minSize();
-			windowSize.x = Max(windowSize.x, min.x);
-			windowSize.y = Max(windowSize.y, min.y);
-		}
-	}
+		control.source = source;
+		control.size = size.asPoint();
 
-	void WindowImpl::updatePosition()
-	{
-		if (m_nextPos)
+		if (not window.updateControl(control))
 		{
-			window.rect.pos = (m_nextPos->pos - window.rect.size * m_nextPos->offset).asPoint();
+			return none;
 		}
-		m_nextPos = none;
+		return control.hoveredPos();
 	}
 
-	void WindowImpl::updateControl(IControl& control)
-	{
-		Rect localRect = pushRect(control.computeSize());
-		Optional<Vec2> localCursorPos = getLocalCursorPos();
-
-		control.update(localRect, localCursorPos);
-	}
+	// ThumbnailGrid
 
-	Rect WindowImpl::pushRect(Size size)
+	// ファイルの大きさと更新日時が同じ間は保存したサムネイルを使う
+	static FilePath ThumbnailCachePath(const FilePathView directory, const FilePath& path, int32 size)
 	{
-		Rect localRect{ 0, 0, size };
-
-		// コントロールの位置を計算
-		if (window.sameLine)
+		size_t hash = path.hash();
+		s3d::detail::HashCombine(hash, static_cast<size_t>(size));
+		s3d::detail::HashCombine(hash, static_cast<size_t>(FileSystem::FileSize(path)));
+		if (const auto time = FileSystem::WriteTime(path))
 		{
-			localRect.pos = window.lineRect.tr();
-			localRect.x += window.space;
+			for (const int32 field : { time->year, time->month, time->day, time->hour, time->minute, time->second, time->milliseconds })
+			{
+				s3d::detail::HashCombine(hash, static_cast<size_t>(field));
+			}
 		}
-		else
+		return FileSystem::PathAppend(directory, U"{:016X}.png"_fmt(hash));
+	}
+
+	// 画像を読み込み、1辺がsize以下になるよう縮小する (別スレッドで呼ぶ)
+	static s3d::Image LoadThumbnail(const FilePath& path, int32 size, const FilePath& directory, const std::atomic<bool>& cancel)
+	{
+		const FilePath cachePath = directory.isEmpty() ? FilePath{} : ThumbnailCachePath(directory, path, size);
+		if (not cachePath.isEmpty() && FileSystem::Exists(cachePath))
 		{
-			Point newLinePos = window.lineRect.bl();
-			if (window.lineRect.area() > 0.0)
+			s3d::Image cached{ cachePath };
+			if (cached && cached.width() <= size && cached.height() <= size)
 			{
-				newLinePos.y += window.space;
+				return cached;
 			}
+		}
 
-			localRect.pos = newLinePos;
-
-			window.lineRect = { newLinePos, 0, 0 };
+		if (cancel)
+		{
+			return {};
 		}
-		window.sameLine = false;
 
-		// m_contentLocalRectとwindow.lineRectの大きさを更新
-		Point br = localRect.br();
-		m_contentLocalRect.w = Max(m_contentLocalRect.w, br.x);
-		m_contentLocalRect.h = Max(m_contentLocalRect.h, br.y);
-		window.lineRect.w = Max(window.lineRect.w, br.x - window.lineRect.x);
-		window.lineRect.h = Max(window.lineRect.h, br.y - window.lineRect.y);
+		// 読み込みは途中で止められないので、縮小と保存だけを取り消す
+		const s3d::Image image{ path };
+		if (not image || cancel)
+		{
+			return {};
+		}
 
-		return localRect;
-	}
+		const double scale = Min(1.0, static_cast<double>(size) / Max(image.width(), image.height()));
+		s3d::Image thumbnail = image.scaled(
+			Size{
+				Max(1, static_cast<int32>(Math::Round(image.width() * scale))),
+				Max(1, static_cast<int32>(Math::Round(image.height() * scale)))
+			},
+			InterpolationAlgorithm::Area);
 
-	void WindowImpl::setPos(Vec2 pos, Vec2 offset)
-	{
-		m_nextPos = NextPosition{
-			pos, offset
-		};
+		if (not cachePath.isEmpty())
+		{
+			thumbnail.savePNG(cachePath);
+		}
+		return thumbnail;
 	}
 
-	void WindowImpl::setSize(Size size)
+	class ThumbnailGrid : public IControl
 	{
-		m_nextSize = NextSize{
-			size
-		};
-	}
-
-	// Layer
+	public:
 
-	void Layer::frameBegin(InputContext& input)
-	{
-		m_input = &input;
+		using Config = Config::ThumbnailGrid;
 
-		std::list<String> front;
-		for (auto itr = m_windowOrder.rbegin(); itr != m_windowOrder.rend();)
+		void init(int32 cellSize, const FilePathView cacheDirectory)
 		{
-			auto& impl = *m_container.at(*itr);
+			if (cacheDirectory != m_cacheDirectory)
+			{
+				m_cacheDirectory = cacheDirectory;
+				if (not m_cacheDirectory.isEmpty())
+				{
+					FileSystem::CreateDirectories(m_cacheDirectory);
+				}
+			}
 
-			impl.frameBegin(*m_input);
+			if (cellSize == m_cellSize)
+			{
+				return;
+			}
+			m_cellSize = cellSize;
 
-			if (impl.window.requestMoveToFront)
+			// 大きさが変わったら縮小し直す
+			for (auto& [key, job] : m_jobs)
 			{
-				front.emplace_back(std::move(*itr));
-				m_windowOrder.erase(--(itr.base()));
-				impl.window.requestMoveToFront = false;
+				*job.cancel = true;
+				m_staleTasks.push_back(std::move(job.task));
 			}
-			else
+			m_jobs.clear();
+			m_decoded.clear();
+			m_failed.clear();
+			m_slots.clear();
+			m_pages.clear();
+			m_staging = {};
+
+			const uint32 slotCount = static_cast<uint32>(slotsPerPage() * Config::PageCount);
+			m_freeSlots.clear();
+			for (uint32 i = slotCount; i > 0; i--)
 			{
-				itr++;
+				m_freeSlots.push_back(i - 1);
 			}
 		}
-		m_windowOrder.splice(m_windowOrder.end(), std::move(front));
-	}
 
-	void Layer::frameEnd()
-	{
-		deleteUnusedWindow();
-		for (auto& id : m_windowOrder)
-		{
-			auto& window = *m_container.at(id);
-			window.frameEnd();
-		}
-	}
+		Optional<size_t> selected() const { return m_selected; }
 
-	WindowImpl& Layer::defineWindow(const StringView id, const StringView name, const Font& font)
-	{
-		auto itr = m_container.find(id);
+		void select(size_t index) { m_selected = index; }
 
-		if (itr == m_container.end())
+		bool failed(const FilePath& path) const { return m_failed.contains(path.hash()); }
+
+		// テクスチャに書き込み済みならその範囲
+		Optional<TextureRegion> thumbnail(const FilePath& path) const
 		{
-			itr = createWindow(id, name, font);
+			const Slot* slot = m_slots.peek(path.hash());
+			if (not slot)
+			{
+				return none;
+			}
+			return m_pages[slot->index / slotsPerPage()](Rect{ slotPos(slot->index), slot->size });
 		}
 
-		auto& impl = *itr->second;
-		impl.window.defined = true;
-		return impl;
-	}
-
-	Layer::container_type::iterator Layer::createWindow(const StringView id, const StringView name, const Font& font)
-	{
-		auto [itr, _] = m_container.emplace(
-				id,
-				std::make_unique<WindowImpl>(*m_input, id, name, font)
-		);
-		m_windowOrder.emplace_back(String{ id });
-
-		// Console << U"[" << ToString(type) << U"][+] " << itr->first;
-
-		return itr;
-	}
+		// visibleの範囲から、その後ろ、その前のprefetchの範囲の順に読み込む
+		void load(const Array<FilePath>& paths, std::pair<size_t, size_t> visible, std::pair<size_t, size_t> prefetch)
+		{
+			m_frame++;
+			collect();
 
-	void Layer::deleteUnusedWindow()
-	{
-		m_windowOrder.remove_if([&, this](const String& id) {
-			auto itr = m_container.find(id);
+			Array<size_t> wanted;
+			for (size_t i = visible.first; i < visible.second; i++)
+			{
+				wanted.push_back(i);
+			}
+			for (size_t i = visible.second; i < prefetch.second; i++)
+			{
+				wanted.push_back(i);
+			}
+			for (size_t i = visible.first; i > prefetch.first; i--)
+			{
+				wanted.push_back(i - 1);
+			}
 
-			if (itr->second->window.defined)
+			HashSet<uint64> wantedKeys;
+			for (const size_t i : wanted)
 			{
-				return false;
+				wantedKeys.insert(paths[i].hash());
 			}
 
-			if (m_input->hoveredItemId() == itr->second->randomId())
+			// 範囲から外れたセルの読み込みは取り消す (終わるのは待たない)
+			Array<uint64> cancelled;
+			for (auto& [key, job] : m_jobs)
 			{
-				m_input->reset();
+				if (not wantedKeys.contains(key))
+				{
+					*job.cancel = true;
+					m_staleTasks.push_back(std::move(job.task));
+					cancelled.push_back(key);
+				}
+			}
+			for (const auto key : cancelled)
+			{
+				m_jobs.erase(key);
+			}
+			for (auto itr = m_decoded.begin(); itr != m_decoded.end();)
+			{
+				if (wantedKeys.contains(itr->first))
+				{
+					itr++;
+				}
+				else
+				{
+					itr = m_decoded.erase(itr);
+				}
 			}
 
-			m_container.erase(itr);
+			int32 uploads = 0;
+			for (const size_t i : wanted)
+			{
+				const uint64 key = paths[i].hash();
 
-			// Console << U"[" << ToString(type) << U"][-] " << id;
-			return true;
-		});
-	}
+				// 書き込み済みのものは使ったことにして置き換えられないようにする
+				if (m_slots.find(key, m_frame) || m_failed.contains(key))
+				{
+					continue;
+				}
 
-	// GUIImpl
+				if (auto itr = m_decoded.find(key); itr != m_decoded.end())
+				{
+					if (uploads < Config::UploadsPerFrame && upload(key, itr->second))
+					{
+						uploads++;
+						m_decoded.erase(itr);
+					}
+					continue;
+				}
 
-	void GUIImpl::frameBegin()
-	{
-		m_input.frameBegin();
-		for (auto layerItr = m_layers.rbegin(); layerItr != m_layers.rend(); layerItr++)
-		{
-			layerItr->frameBegin(m_input);
+				// 取り消したタスクが残っている間はその分も数えて、スレッドを増やしすぎない
+				if (not m_jobs.contains(key) && m_jobs.size() + m_staleTasks.size() < Threading::GetConcurrency())
+				{
+					auto cancel = std::make_shared<std::atomic<bool>>(false);
+					m_jobs.emplace(key, Job{
+						cancel,
+						Async([path = paths[i], size = m_cellSize, directory = m_cacheDirectory, cancel]()
+						{
+							return LoadThumbnail(path, size, directory, *cancel);
+						})
+					});
+				}
+			}
 		}
-	}
 
-	void GUIImpl::frameEnd()
-	{
-		for (auto& layer : m_layers)
+	private:
+
+		struct Job
 		{
-			layer.frameEnd();
-		}
-		// Print << m_input.m_hoveredItemId << (m_input.m_captured ? U"🔒" : U"");
-	}
+			std::shared_ptr<std::atomic<bool>> cancel;
 
-	Layer& GUIImpl::getLayer(WindowLayer layer)
-	{
-		return m_layers[static_cast<int32>(layer)];
-	}
+			AsyncTask<s3d::Image> task;
+		};
 
-	WindowImpl& GUIImpl::defineWindow(WindowLayer layer, const StringView id, const StringView name)
-	{
-		return getLayer(layer).defineWindow(id, name, font);
-	}
+		// テクスチャ内の升目
+		struct Slot
+		{
+			uint32 index;
 
-	// GUIManager
+			Size size;
+		};
 
-	GUIManager::GUIManager()
-		: m_impl(std::make_unique<GUIImpl>())
-	{
-		m_defaultWindow = &m_impl
-			->defineWindow(WindowLayer::Background, U"DefaultWindow", U"DefaultWindow");
-		m_defaultWindow->window.flags =
-			WindowFlag::NoTitlebar
-			| WindowFlag::NoResize
-			| WindowFlag::NoMove
-			| WindowFlag::NoBackground;
-	}
+		int32 m_cellSize = 0;
+
+		FilePath m_cacheDirectory;
+
+		Optional<size_t> m_selected;
+
+		uint64 m_frame = 0;
+
+		// キーはパスのハッシュ値
+		HashTable<uint64, Job> m_jobs;
+
+		// 取り消したタスク (完了を待たずに、終わったものから捨てる)
+		Array<AsyncTask<s3d::Image>> m_staleTasks;
+
+		// 読み込んだがまだテクスチャに書き込んでいない画像
+		HashTable<uint64, s3d::Image> m_decoded;
+
+		HashSet<uint64> m_failed;
+
+		// テクスチャに書き込んだサムネイルの升目 (表示した順)
+		LruCache<Slot> m_slots;
+
+		Array<uint32> m_freeSlots;
+
+		Array<DynamicTexture> m_pages;
+
+		// fillRegion()にはテクスチャと同じ大きさの画像が要るので、升目の位置に写してから転送する
+		s3d::Image m_staging;
 
-	const Font& GUIManager::getFont() const
-	{
-		return m_impl->font;
-	}
+		int32 slotsPerRow() const
+		{
+			return Config::PageSize / m_cellSize;
+		}
 
-	void GUIManager::setFont(const Font& newFont)
-	{
-		m_impl->font = newFont;
-	}
+		size_t slotsPerPage() const
+		{
+			return static_cast<size_t>(slotsPerRow()) * slotsPerRow();
+		}
 
-	void GUIManager::frameBegin()
-	{
-		m_stack.clear();
-		m_stack.push_back(m_defaultWindow);
+		Point slotPos(uint32 index) const
+		{
+			const int32 local = static_cast<int32>(index % slotsPerPage());
+			return Point{ local % slotsPerRow(), local / slotsPerRow() } * m_cellSize;
+		}
 
-		m_impl->frameBegin();
+		void collect()
+		{
+			m_staleTasks.remove_if([](const AsyncTask<s3d::Image>& task) { return task.isReady(); });
 
-		// DefaultWindowの定義(延命)
-		m_defaultWindow = &m_impl
-			->defineWindow(WindowLayer::Background, U"DefaultWindow", U"DefaultWindow");
-	}
+			Array<uint64> finished;
+			for (auto& [key, job] : m_jobs)
+			{
+				if (not job.task.isReady())
+				{
+					continue;
+				}
 
-	void GUIManager::frameEnd()
-	{
-		// DefaultWindowの位置&座標を更新
-		m_defaultWindow->setPos({ 0, 0 }, { 0, 0 });
-		m_defaultWindow->setSize(Scene::Size());
+				if (s3d::Image image = job.task.get())
+				{
+					m_decoded.emplace(key, std::move(image));
+				}
+				else
+				{
+					m_failed.insert(key);
+				}
+				finished.push_back(key);
+			}
+			for (const auto key : finished)
+			{
+				m_jobs.erase(key);
+			}
+		}
 
-		m_impl->frameEnd();
+		// 空いている升目か、このフレームで表示していない最も古い升目に書き込む
+		bool upload(uint64 key, const s3d::Image& image)
+		{
+			uint32 index;
+			if (not m_freeSlots.isEmpty())
+			{
+				index = m_freeSlots.back();
+				m_freeSlots.pop_back();
+			}
+			else if (auto oldest = m_slots.popLeastRecent(m_frame))
+			{
+				index = oldest->index;
+			}
+			else
+			{
+				return false;
+			}
 
-		//for (auto [idx, layer] : Indexed(m_impl->layers()))
-		//{
-		//	const HSV color{ ((double)idx / 4 * 360), 0.8, 1.0 };
-		//	for (auto& [id, impl] : layer.container())
-		//	{
-		//		auto& window = impl->window;
+			const size_t page = index / slotsPerPage();
+			while (m_pages.size() <= page)
+			{
+				m_pages.emplace_back(Size{ Config::PageSize, Config::PageSize }, Color{ 0, 0 });
+			}
+			if (m_staging.isEmpty())
+			{
+				m_staging = s3d::Image{ Size{ Config::PageSize, Config::PageSize }, Color{ 0, 0 } };
+			}
+			image.overwrite(m_staging, slotPos(index));
+			m_pages[page].fillRegion(m_staging, Rect{ slotPos(index), image.size() });
 
-		//		window.rect.drawFrame(1, 0, color);
-		//		Line{ window.rect.tl(), window.rect.br() }.draw(color);
-		//		Line{ window.rect.bl(), window.rect.tr() }.draw(color);
+			m_slots.insert(key, Slot{ index, image.size() }, 1, m_frame);
+			return true;
+		}
 
-		//		SimpleGUI::GetFont()(U"{}:{}"_fmt(id, window.displayName))
-		//			.draw(Arg::bottomLeft = window.rect.tl(), color);
-		//	}
-		//}
-	}
+		// セルはThumbnailCellとして配置する
 
-	void GUIManager::windowBegin(const StringView name, WindowFlag flags)
-	{
-		WindowLayer layer = flags & WindowFlag::AlwaysForeground
-			? WindowLayer::Foreground
-			: WindowLayer::Normal;
-		auto windowImpl = &m_impl
-			->defineWindow(layer, name, name);
-		windowImpl->window.flags = flags;
-		m_stack.push_back(windowImpl);
-	}
+		Size computeSize() const override
+		{
+			return { 0, 0 };
+		}
 
-	void GUIManager::windowEnd()
-	{
-		m_stack.pop_back();
-	}
+		void update(Rect, Optional<Vec2>) override
+		{ }
 
-	void GUIManager::setWindowSize(Size size)
-	{
-		getCurrentWindowImpl().setSize(size);
-	}
+		void draw() const override
+		{ }
+	};
 
-	void GUIManager::setWindowDisplayName(const StringView name)
+	// セルより先に配置して、見えている範囲の読み込みを進める
+	class ThumbnailLoader : public IControl
 	{
-		getCurrentWindowImpl().window.displayName = name;
-	}
+	public:
 
-	const Window& GUIManager::getDefaultWindow() const
-	{
-		return m_defaultWindow->window;
-	}
+		ThumbnailGrid* grid = nullptr;
 
-	const Window& GUIManager::getCurrentWindow() const
-	{
-		return m_stack.back()->window;
-	}
+		const Array<FilePath>* paths = nullptr;
 
-	void GUIManager::sameLine()
-	{
-		getCurrentWindowImpl().window.sameLine = true;
-	}
+		std::pair<size_t, size_t> visible{ 0, 0 };
 
-	void GUIManager::setWindowPos(Vec2 pos, Vec2 offset)
-	{
-		getCurrentWindowImpl().setPos(pos, offset);
-	}
+		std::pair<size_t, size_t> prefetch{ 0, 0 };
 
-	GUIManager::~GUIManager()
-	{ }
+	private:
 
-	// Dummy
+		Size computeSize() const override
+		{
+			return { 0, 0 };
+		}
 
-	void GUIManager::dummy(Size size)
-	{
-		getCurrentWindowImpl()
-			.pushRect(size);
-	}
+		void update(Rect, Optional<Vec2>) override
+		{
+			grid->load(*paths, visible, prefetch);
+		}
 
-	// Button
+		void draw() const override
+		{ }
+	};
 
-	class Button : public IControl
+	class ThumbnailCell : public IControl
 	{
 	public:
 
-		String label;
+		using Config = Config::ThumbnailGrid;
 
-		bool clicked() const
-		{
-			return m_clicked;
-		}
+		Optional<TextureRegion> thumbnail;
+
+		bool failed = false;
+
+		bool selected = false;
+
+		DrawableText label;
+
+		bool clicked() const { return m_clicked; }
 
 	private:
 
-		Rect m_rect;
+		Rect m_rect{ 0, 0, 0, 0 };
 
 		bool m_mouseOver = false;
 
@@ -1777,535 +11057,1057 @@ namespace SasaGUI
 
 		Size computeSize() const override
 		{
-			return SimpleGUI::ButtonRegion(label, { 0, 0 }).size.asPoint();
+			return m_rect.size;
 		}
 
 		void update(Rect rect, Optional<Vec2> cursorPos) override
 		{
 			m_rect = rect;
-
 			m_mouseOver = cursorPos && rect.contains(*cursorPos);
 			m_clicked = m_mouseOver && MouseL.down();
 		}
 
-		void draw() const
+		void draw() const override
 		{
-			Mat3x2 cursorMat = m_mouseOver
-				? Mat3x2::Translate(Cursor::PosF())
-				: Mat3x2::Translate(Cursor::PosF() + Vec2{ 1, 1 });
-			const Transformer2D _{ Mat3x2::Translate(m_rect.pos), cursorMat, Transformer2D::Target::PushLocal };
-			[[maybe_unused]]
-			bool unused = SimpleGUI::Button(label, { 0, 0 }, m_rect.w);
+			if (selected)
+			{
+				m_rect.draw(Config::SelectedColor);
+			}
+			else if (m_mouseOver)
+			{
+				m_rect.draw(Config::HoveredColor);
+			}
+
+			const int32 imageSize = m_rect.w - Config::Padding * 2;
+			const Rect imageRect{ m_rect.x + Config::Padding, m_rect.y + Config::Padding, imageSize, imageSize };
+			if (thumbnail)
+			{
+				thumbnail->drawAt(imageRect.center());
+			}
+			else
+			{
+				imageRect.draw(failed ? Config::FailedColor : Config::PlaceholderColor);
+			}
+
+			label.draw(
+				RectF{ imageRect.x, imageRect.bottomY() + Config::Padding, imageRect.w, label.font.height() },
+				Config::LabelColor);
 		}
 	};
 
-	bool GUIManager::button(StringView label)
+	Optional<size_t> GUIManager::thumbnailGrid(const StringView id, const Array<FilePath>& paths, int32 cellSize, SizeF size, const FilePathView cacheDirectory)
 	{
-		auto& window = getCurrentWindowImpl();
+		using Config = Config::ThumbnailGrid;
 
-		auto& button = window.nextStatelessControl<Button>();
-		button.label = label;
-
-		window.updateControl(button);
-		return button.clicked();
-	}
-
-	// SimpleTextBox
-
-	class SimpleTextBox : public IControl
-	{
-	public:
+		auto& window = getCurrentWindowImpl();
+		cellSize = Clamp(cellSize, 1, Config::PageSize);
 
-		double width = 200;
+		auto& grid = window.nextStatefulControl<ThumbnailGrid>(id.hash());
+		grid.init(cellSize, cacheDirectory);
 
-		Optional<size_t> maxChars = unspecified;
+		size_t bodyId = id.hash();
+		s3d::detail::HashCombine(bodyId, typeid(ThumbnailGrid).hash_code());
+		window.beginChild(bodyId, size);
 
-		TextEditState& state()
+		// 列の数は幅に収まるだけにして、縦にだけスクロールする
+		const RectF viewport = window.childViewport();
+		const double width = Max(0.0, viewport.w - window.window.padding);
+		const SizeF cell{
+			cellSize + Config::Padding * 2.0,
+			cellSize + Config::Padding * 3.0 + window.window.font.height()
+		};
+		const size_t columns = Max<size_t>(1, static_cast<size_t>(width / cell.x));
+		const size_t rowCount = (paths.size() + columns - 1) / columns;
+		const double contentHeight = cell.y * rowCount;
+
+		const size_t firstRow = Min(rowCount, static_cast<size_t>(Max(0.0, viewport.y / cell.y)));
+		const size_t lastRow = Min(rowCount, static_cast<size_t>(Max(0.0, Math::Ceil((viewport.y + viewport.h) / cell.y))));
+		const size_t prefetchFirstRow = firstRow - Min<size_t>(firstRow, Config::PrefetchRows);
+		const size_t prefetchLastRow = Min(rowCount, lastRow + Config::PrefetchRows);
+
+		// 読み込みは見えているセルを優先するため、セルより先に配置する
+		auto& loader = window.nextStatelessControl<ThumbnailLoader>();
+		loader.grid = &grid;
+		loader.paths = &paths;
+		loader.visible = { Min(paths.size(), firstRow * columns), Min(paths.size(), lastRow * columns) };
+		loader.prefetch = { Min(paths.size(), prefetchFirstRow * columns), Min(paths.size(), prefetchLastRow * columns) };
+		window.updateControlAt(loader, window.placeRect({ viewport.pos, width, Clamp(contentHeight - viewport.y, 0.0, viewport.h) }));
+
+		// 表示されているセルだけを配置する
+		for (size_t i = loader.visible.first; i < loader.visible.second; i++)
 		{
-			return m_state;
+			auto& item = window.nextStatelessControl<ThumbnailCell>();
+			item.thumbnail = grid.thumbnail(paths[i]);
+			item.failed = grid.failed(paths[i]);
+			item.selected = grid.selected() == i;
+			item.label = window.window.font(FileSystem::FileName(paths[i]));
+
+			const RectF rect{ cell.x * (i % columns), cell.y * (i / columns), cell };
+			if (window.updateControlAt(item, window.placeRect(rect)) && item.clicked())
+			{
+				grid.select(i);
+			}
 		}
 
-	private:
+		window.placeRect({ 0, 0, width, contentHeight });
 
-		mutable TextEditState m_state;
+		window.endChild();
 
-		Vec2 m_pos;
+		return grid.selected();
+	}
 
-		double m_renderWidth;
+	// NodeGraph
 
-		bool m_mouseOver = false;
+	NodeGraph::CellRange NodeGraph::CellsOf(const RectF& rect)
+	{
+		return {
+			Point{
+				static_cast<int32>(Math::Floor(rect.x / CellSize)),
+				static_cast<int32>(Math::Floor(rect.y / CellSize))
+			},
+			Point{
+				static_cast<int32>(Math::Floor(rect.rightX() / CellSize)),
+				static_cast<int32>(Math::Floor(rect.bottomY() / CellSize))
+			}
+		};
+	}
 
-		Size computeSize() const override
+	static uint64 CellKey(int32 x, int32 y)
+	{
+		return (static_cast<uint64>(static_cast<uint32>(x)) << 32) | static_cast<uint32>(y);
+	}
+
+	void NodeGraph::AddToCells(CellTable& table, uint64 id, const CellRange& range)
+	{
+		for (int32 y = range.min.y; y <= range.max.y; y++)
 		{
-			return SimpleGUI::TextBoxRegion(m_pos, width).size.asPoint();
+			for (int32 x = range.min.x; x <= range.max.x; x++)
+			{
+				table[CellKey(x, y)].push_back(id);
+			}
 		}
+	}
 
-		void update(Rect rect, Optional<Vec2> cursorPos) override
+	void NodeGraph::RemoveFromCells(CellTable& table, uint64 id, const CellRange& range)
+	{
+		for (int32 y = range.min.y; y <= range.max.y; y++)
 		{
-			m_pos = rect.pos;
-			m_renderWidth = rect.w;
-			m_mouseOver = cursorPos && rect.contains(*cursorPos);
+			for (int32 x = range.min.x; x <= range.max.x; x++)
+			{
+				auto itr = table.find(CellKey(x, y));
+				if (itr == table.end())
+				{
+					continue;
+				}
+
+				// マスの中は少ないので順番は気にせず詰める
+				auto& ids = itr->second;
+				if (auto found = std::find(ids.begin(), ids.end(), id); found != ids.end())
+				{
+					*found = ids.back();
+					ids.pop_back();
+				}
+				if (ids.isEmpty())
+				{
+					table.erase(itr);
+				}
+			}
 		}
+	}
 
-		void draw() const
+	void NodeGraph::QueryCells(const CellTable& table, const RectF& area, Array<uint64>& out)
+	{
+		out.clear();
+
+		const CellRange range = CellsOf(area);
+		for (int32 y = range.min.y; y <= range.max.y; y++)
 		{
-			Mat3x2 cursorMat = m_mouseOver
-				? Mat3x2::Translate(Cursor::PosF())
-				: Mat3x2::Translate(Cursor::PosF() + Vec2{ 1, 1 });
-			const Transformer2D _{ Mat3x2::Translate(m_pos), cursorMat, Transformer2D::Target::PushLocal };
-			SimpleGUI::TextBox(m_state, { 0, 0 }, m_renderWidth, maxChars);
+			for (int32 x = range.min.x; x <= range.max.x; x++)
+			{
+				if (auto itr = table.find(CellKey(x, y)); itr != table.end())
+				{
+					out.append(itr->second);
+				}
+			}
 		}
-	};
 
-	TextEditState& GUIManager::simpleTextBox(const StringView id, double width, const Optional<size_t>& maxChars)
+		// 複数のマスに掛かるものを1つにまとめ、IDの順 (追加した順) に並べる
+		std::sort(out.begin(), out.end());
+		out.erase(std::unique(out.begin(), out.end()), out.end());
+	}
+
+	double NodeGraph::baseHeight(const GraphNode& node) const
 	{
-		auto& window = getCurrentWindowImpl();
+		const size_t rows = Max(node.inputs.size(), node.outputs.size());
+		return m_rowHeight * (rows + 1);
+	}
 
-		auto& textBox = window.nextStatefulControl<SimpleTextBox>(id.hash());
-		textBox.width = width;
-		textBox.maxChars = maxChars;
+	void NodeGraph::updateNodeCells(uint64 id, NodeEntry& entry)
+	{
+		const CellRange range = CellsOf(nodeRect(id));
+		if (range.min == entry.cells.min && range.max == entry.cells.max)
+		{
+			return;
+		}
 
-		window.updateControl(textBox);
-		return textBox.state();
+		RemoveFromCells(m_nodeCells, id, entry.cells);
+		AddToCells(m_nodeCells, id, range);
+		entry.cells = range;
 	}
 
-	// Label
+	std::array<Vec2, 4> NodeGraph::linkControlPoints(const GraphLink& link) const
+	{
+		const Vec2 from = outputPos(link.fromNode, link.fromPort);
+		const Vec2 to = inputPos(link.toNode, link.toPort);
+		const double tangent = Max(Abs(to.x - from.x) * 0.5, Config::NodeGraph::MinTangent);
+		return { from, from.movedBy(tangent, 0), to.movedBy(-tangent, 0), to };
+	}
 
-	class Label : public IControl
+	void NodeGraph::updateLink(uint64 id, LinkEntry& entry)
 	{
-	public:
+		// 曲線は制御点の凸包に収まる
+		const auto points = linkControlPoints(entry.link);
+		Vec2 min = points[0];
+		Vec2 max = points[0];
+		for (const auto& point : points)
+		{
+			min = { Min(min.x, point.x), Min(min.y, point.y) };
+			max = { Max(max.x, point.x), Max(max.y, point.y) };
+		}
+		entry.bounds = { min, max - min };
+		entry.curve.clear();
 
-		DrawableText text;
+		const CellRange range = CellsOf(entry.bounds);
+		if (range.min == entry.cells.min && range.max == entry.cells.max)
+		{
+			return;
+		}
 
-		ColorF color;
+		RemoveFromCells(m_linkCells, id, entry.cells);
+		AddToCells(m_linkCells, id, range);
+		entry.cells = range;
+	}
 
-	private:
+	uint64 NodeGraph::addNode(const GraphNode& node)
+	{
+		const uint64 id = m_nextId++;
+		auto& entry = m_nodes.emplace(id, NodeEntry{ .node = node }).first->second;
+		entry.height = baseHeight(node);
+		updateNodeCells(id, entry);
+		m_version++;
+		return id;
+	}
 
-		Vec2 m_pos;
+	void NodeGraph::removeNode(uint64 id)
+	{
+		auto itr = m_nodes.find(id);
+		if (itr == m_nodes.end())
+		{
+			return;
+		}
 
-		Size computeSize() const override
+		// removeLink()がlinksを書き換えるので写してから消す
+		const Array<uint64> links = itr->second.links;
+		for (const auto link : links)
 		{
-			return text.region().size.asPoint();
+			removeLink(link);
 		}
 
-		void update(Rect rect, Optional<Vec2>) override
+		RemoveFromCells(m_nodeCells, id, itr->second.cells);
+		m_nodes.erase(itr);
+		m_version++;
+	}
+
+	void NodeGraph::moveNode(uint64 id, Vec2 pos)
+	{
+		auto& entry = m_nodes.at(id);
+		if (entry.node.pos == pos)
 		{
-			m_pos = rect.pos;
+			return;
 		}
 
-		void draw() const
+		entry.node.pos = pos;
+		updateNodeCells(id, entry);
+		for (const auto link : entry.links)
 		{
-			text.draw(m_pos, color);
+			updateLink(link, m_links.at(link));
 		}
-	};
+		m_version++;
+	}
 
-	void GUIManager::label(const StringView text, ColorF color)
+	void NodeGraph::resizeNode(uint64 id, double height)
 	{
-		auto& window = getCurrentWindowImpl();
-		auto& label = window.nextStatelessControl<Label>();
-
-		label.text = window.window.font(text);
-		label.color = color;
+		auto& entry = m_nodes.at(id);
+		height = Max(height, baseHeight(entry.node));
+		if (entry.height == height)
+		{
+			return;
+		}
 
-		window.updateControl(label);
+		// ポートの位置は高さによらないのでリンクはそのまま
+		entry.height = height;
+		updateNodeCells(id, entry);
 	}
 
-	// Image
+	RectF NodeGraph::nodeRect(uint64 id) const
+	{
+		const auto& entry = m_nodes.at(id);
+		return { entry.node.pos, entry.node.width, entry.height };
+	}
 
-	class Image : public IControl
+	Optional<uint64> NodeGraph::addLink(const GraphLink& link)
 	{
-	public:
+		auto from = m_nodes.find(link.fromNode);
+		auto to = m_nodes.find(link.toNode);
+		if (from == m_nodes.end() ||
+			to == m_nodes.end() ||
+			link.fromNode == link.toNode ||
+			link.fromPort >= from->second.node.outputs.size() ||
+			link.toPort >= to->second.node.inputs.size())
+		{
+			return none;
+		}
 
-		std::variant<Texture, TextureRegion> texture;
+		if (auto existing = linkTo(link.toNode, link.toPort))
+		{
+			removeLink(*existing);
+		}
 
-		ColorF diffuse;
+		const uint64 id = m_nextId++;
+		auto& entry = m_links.emplace(id, LinkEntry{ .link = link }).first->second;
+		updateLink(id, entry);
+		from->second.links.push_back(id);
+		to->second.links.push_back(id);
+		m_version++;
+		return id;
+	}
 
-	private:
+	void NodeGraph::removeLink(uint64 id)
+	{
+		auto itr = m_links.find(id);
+		if (itr == m_links.end())
+		{
+			return;
+		}
 
-		Vec2 m_pos;
+		const auto& link = itr->second.link;
+		m_nodes.at(link.fromNode).links.remove(id);
+		m_nodes.at(link.toNode).links.remove(id);
 
-		Size computeSize() const override
+		RemoveFromCells(m_linkCells, id, itr->second.cells);
+		m_links.erase(itr);
+		m_version++;
+	}
+
+	Optional<uint64> NodeGraph::linkTo(uint64 node, size_t port) const
+	{
+		for (const auto id : m_nodes.at(node).links)
 		{
-			return std::visit([](const auto& tex) {
-				return tex.region(0.0, 0.0).size.asPoint();
-			}, texture);
+			const auto& link = m_links.at(id).link;
+			if (link.toNode == node && link.toPort == port)
+			{
+				return id;
+			}
 		}
+		return none;
+	}
 
-		void update(Rect rect, Optional<Vec2>) override
+	void NodeGraph::setRowHeight(double rowHeight)
+	{
+		if (m_rowHeight == rowHeight)
 		{
-			m_pos = rect.pos;
+			return;
 		}
 
-		void draw() const
+		m_rowHeight = rowHeight;
+		for (auto& [id, entry] : m_nodes)
 		{
-			std::visit([this](const auto& tex) {
-				tex.draw(m_pos, diffuse);
-			}, texture);
+			entry.height = Max(entry.height, baseHeight(entry.node));
+			updateNodeCells(id, entry);
 		}
-	};
+		for (auto& [id, entry] : m_links)
+		{
+			updateLink(id, entry);
+		}
+	}
 
-	void GUIManager::image(Texture texture, ColorF diffuse)
+	Vec2 NodeGraph::inputPos(uint64 node, size_t port) const
 	{
-		auto& window = getCurrentWindowImpl();
-		auto& image = window.nextStatelessControl<Image>();
+		const auto& pos = m_nodes.at(node).node.pos;
+		return { pos.x, pos.y + m_rowHeight * (port + 1.5) };
+	}
 
-		image.texture = texture;
-		image.diffuse = diffuse;
+	Vec2 NodeGraph::outputPos(uint64 node, size_t port) const
+	{
+		const auto& entry = m_nodes.at(node);
+		return { entry.node.pos.x + entry.node.width, entry.node.pos.y + m_rowHeight * (port + 1.5) };
+	}
 
-		window.updateControl(image);
+	void NodeGraph::queryNodes(const RectF& area, Array<uint64>& out) const
+	{
+		QueryCells(m_nodeCells, area, out);
+		out.remove_if([&](uint64 id) { return not nodeRect(id).intersects(area); });
 	}
 
-	void GUIManager::image(TextureRegion texture, ColorF diffuse)
+	void NodeGraph::queryLinks(const RectF& area, Array<uint64>& out) const
 	{
-		auto& window = getCurrentWindowImpl();
-		auto& image = window.nextStatelessControl<Image>();
+		QueryCells(m_linkCells, area, out);
+		out.remove_if([&](uint64 id) { return not m_links.at(id).bounds.intersects(area); });
+	}
 
-		image.texture = texture;
-		image.diffuse = diffuse;
+	Optional<uint64> NodeGraph::nodeAt(Vec2 pos) const
+	{
+		Array<uint64> candidates;
+		queryNodes(RectF{ pos, 0, 0 }, candidates);
 
-		window.updateControl(image);
+		for (auto itr = candidates.rbegin(); itr != candidates.rend(); itr++)
+		{
+			if (nodeRect(*itr).contains(pos))
+			{
+				return *itr;
+			}
+		}
+		return none;
 	}
 
-	// CheckBox
+	Optional<uint64> NodeGraph::linkAt(Vec2 pos, double tolerance) const
+	{
+		Array<uint64> candidates;
+		queryLinks(RectF{ Arg::center = pos, tolerance * 2 }, candidates);
 
-	class CheckBox : public IControl
+		for (auto itr = candidates.rbegin(); itr != candidates.rend(); itr++)
+		{
+			const LineString& curve = linkCurve(*itr);
+			for (size_t i = 0; i + 1 < curve.size(); i++)
+			{
+				if (Line{ curve[i], curve[i + 1] }.closest(pos).distanceFrom(pos) <= tolerance)
+				{
+					return *itr;
+				}
+			}
+		}
+		return none;
+	}
+
+	const LineString& NodeGraph::linkCurve(uint64 id) const
 	{
-	public:
+		const auto& entry = m_links.at(id);
+		if (entry.curve.isEmpty())
+		{
+			const auto points = linkControlPoints(entry.link);
+			entry.curve = Bezier3{ points[0], points[1], points[2], points[3] }.getLineString(Config::NodeGraph::LinkSegments);
+		}
+		return entry.curve;
+	}
 
-		using Config = Config::CheckBox;
+	// 入力の処理と背景・リンクの描画はNodeGraphBackground、ノードはGraphNodeFrameとして配置する
+	class NodeGraphCanvas : public IControl
+	{
+	public:
 
-		bool* ref;
+		using Config = Config::NodeGraph;
 
-		DrawableText labelText;
+		// beginNodeGraph()からendNodeGraph()の間だけ有効
+		NodeGraph* graph = nullptr;
 
-		bool valueChanged() const { return m_valueChanged; }
+		// 評価中のノード
+		Optional<uint64> currentNode;
 
-	private:
+		// 子領域のコンテンツ座標の原点 (コンテンツ領域でのローカル座標)
+		Point origin{ 0, 0 };
 
-		bool m_value = false;
+		// 子領域のコンテンツ座標からグラフの座標へのずれ
+		const Vec2& pan() const { return m_pan; }
 
-		bool m_valueChanged = false;
+		Optional<uint64> selectedNode() const { return m_selectedNode; }
 
-		RectF m_checkRect;
+		// ポートの上にカーソルがあるか (ドラッグ中はつなげる先のポート)
+		bool isHoveredPort(uint64 node, size_t port, bool output) const
+		{
+			return m_hoveredPort
+				&& m_hoveredPort->node == node
+				&& m_hoveredPort->port == port
+				&& m_hoveredPort->output == output;
+		}
 
-		Vec2 m_labelLeftCenter;
+		// 表示範囲 (子領域のコンテンツ座標) にあるノードとリンクを求める
+		void beginNodes(const SizeF& viewportSize)
+		{
+			graph->queryNodes(RectF{ m_pan, viewportSize }, m_visibleNodes);
+			graph->queryLinks(RectF{ m_pan, viewportSize }, m_visibleLinks);
+			m_nextNode = 0;
+			currentNode = none;
+		}
 
-		Size computeSize() const override
+		Optional<uint64> nextNode()
 		{
-			Size labelSize = labelText.region().size.asPoint();
-			return { labelSize.x + checkboxSize(), labelSize.y };
+			if (m_nextNode >= m_visibleNodes.size())
+			{
+				return none;
+			}
+			return m_visibleNodes[m_nextNode++];
 		}
 
-		void update(Rect rect, Optional<Vec2> cursorPos) override
+		void updateInput(Rect rect, Optional<Vec2> cursorPos)
 		{
-			m_checkRect = RectF{ Arg::leftCenter = rect.leftCenter(), static_cast<RectF::size_type::value_type>(checkboxSize()) };
-			m_labelLeftCenter = m_checkRect.rightCenter();
+			m_rect = rect;
 
-			if (cursorPos &&
-				rect.contains(*cursorPos))
+			const Optional<Vec2> pos = cursorPos.map([&](Vec2 v) { return toGraphPos(v); });
+			m_hoveredPort = none;
+
+			// 選択していたものが外で削除されていることがある
+			if (m_selectedNode && not graph->containsNode(*m_selectedNode))
 			{
-				Cursor::RequestStyle(CursorStyle::Hand);
-				m_valueChanged = MouseL.down();
-				*ref ^= m_valueChanged;
+				m_selectedNode = none;
+			}
+			if (m_selectedLink && not graph->containsLink(*m_selectedLink))
+			{
+				m_selectedLink = none;
 			}
 
-			m_value = *ref;
-			ref = nullptr;
+			switch (m_drag)
+			{
+			case DragMode::Pan:
+				if (MouseR.pressed())
+				{
+					m_pan -= Cursor::DeltaF();
+					return;
+				}
+				break;
+			case DragMode::Node:
+				if (MouseL.pressed() && graph->containsNode(m_dragNode))
+				{
+					if (pos)
+					{
+						graph->moveNode(m_dragNode, *pos - m_dragOffset);
+					}
+					return;
+				}
+				break;
+			case DragMode::Link:
+				if (pos)
+				{
+					m_dragPos = *pos;
+					m_hoveredPort = findPort(*pos);
+				}
+				if (MouseL.pressed() && graph->containsNode(m_dragStart.node))
+				{
+					return;
+				}
+				if (MouseL.up() && m_hoveredPort && graph->containsNode(m_dragStart.node))
+				{
+					connect(m_dragStart, *m_hoveredPort);
+				}
+				break;
+			default:
+				break;
+			}
+			m_drag = DragMode::None;
+
+			if (not pos || not rect.contains(*cursorPos))
+			{
+				return;
+			}
+
+			m_hoveredPort = findPort(*pos);
+
+			if (MouseR.down())
+			{
+				m_drag = DragMode::Pan;
+				return;
+			}
+
+			if (MouseL.down())
+			{
+				if (m_hoveredPort)
+				{
+					startLink(*m_hoveredPort);
+					return;
+				}
+
+				if (auto node = graph->nodeAt(*pos))
+				{
+					m_selectedNode = node;
+					m_selectedLink = none;
+
+					// 中身のコントロールの上ではドラッグしない
+					if (pos->y < graph->nodeRect(*node).y + graph->rowHeight())
+					{
+						m_drag = DragMode::Node;
+						m_dragNode = *node;
+						m_dragOffset = *pos - graph->node(*node).pos;
+					}
+					return;
+				}
+
+				m_selectedNode = none;
+				m_selectedLink = graph->linkAt(*pos, Config::LinkHitTolerance);
+			}
+
+			if (m_selectedLink && KeyDelete.down())
+			{
+				graph->removeLink(*m_selectedLink);
+				m_selectedLink = none;
+			}
 		}
 
-		void draw() const override
+		void drawBackground() const
 		{
-			m_checkRect.drawFrame(1, Palette::Black);
-			if (m_value)
+			m_rect.draw(Config::BackgroundColor);
+
+			// 格子はグラフの座標に合わせて動かす
+			const Vec2 offset{
+				-Math::Fmod(Math::Fmod(m_pan.x, Config::GridSize) + Config::GridSize, Config::GridSize),
+				-Math::Fmod(Math::Fmod(m_pan.y, Config::GridSize) + Config::GridSize, Config::GridSize)
+			};
+			for (double x = m_rect.x + offset.x; x < m_rect.rightX(); x += Config::GridSize)
 			{
-				Vec2 center = m_checkRect.center();
-				int32 size = checkboxSize();
-				drawCheckLine(m_checkRect.center(), checkboxSize() * Config::CheckLineScale);
+				Line{ x, m_rect.y, x, m_rect.bottomY() }.draw(1, Config::GridColor);
+			}
+			for (double y = m_rect.y + offset.y; y < m_rect.bottomY(); y += Config::GridSize)
+			{
+				Line{ m_rect.x, y, m_rect.rightX(), y }.draw(1, Config::GridColor);
+			}
+
+			// 表示範囲に掛かるリンクだけを描く
+			const Transformer2D _{ Mat3x2::Translate(toLocalPos({ 0, 0 })) };
+			for (size_t i = 0; i < m_shownLinkCount; i++)
+			{
+				m_linkCurves[i].draw(
+					Config::LinkThickness,
+					m_selectedLinkIndex == i ? Config::SelectedLinkColor : Config::LinkColor);
 			}
-			labelText
-				.draw(Arg::leftCenter = m_labelLeftCenter, Palette::Black);
 		}
 
-		int32 checkboxSize() const
+		// ドラッグ中のリンクはノードの上に描く
+		void drawOverlay() const
 		{
-			return static_cast<int32>(labelText.font.height() * Config::BoxScale);
+			if (not m_dragLink)
+			{
+				return;
+			}
+
+			const auto [from, to] = *m_dragLink;
+			const double tangent = Max(Abs(to.x - from.x) * 0.5, Config::MinTangent);
+			Bezier3{ from, from.movedBy(tangent, 0), to.movedBy(-tangent, 0), to }
+				.draw(Config::LinkThickness, Config::SelectedLinkColor);
 		}
 
-		void drawCheckLine(Vec2 center, double scale) const
+		// 描画のときにグラフを参照しないように、ノードを動かし終えた後のリンクの形を写しておく (endNodeGraph()から呼ぶ)
+		void endNodes()
 		{
-			LineString line(Arg::reserve = Config::CheckLine.size());
-			for (Vec2 p : Config::CheckLine)
+			m_shownLinkCount = 0;
+			m_selectedLinkIndex = none;
+			for (const auto id : m_visibleLinks)
 			{
-				line.push_back(center + p * scale);
+				if (not graph->containsLink(id))
+				{
+					continue;
+				}
+
+				// 使い回して確保を減らす
+				if (m_shownLinkCount == m_linkCurves.size())
+				{
+					m_linkCurves.emplace_back();
+				}
+				m_linkCurves[m_shownLinkCount] = graph->linkCurve(id);
+				if (m_selectedLink == id)
+				{
+					m_selectedLinkIndex = m_shownLinkCount;
+				}
+				m_shownLinkCount++;
 			}
-			line.draw(LineStyle::Uncapped, Config::CheckLineTickness * scale, Palette::Black);
+
+			m_dragLink = none;
+			if (m_drag == DragMode::Link && graph->containsNode(m_dragStart.node))
+			{
+				const Vec2 start = portPos(m_dragStart);
+				m_dragLink = std::make_pair(
+					toLocalPos(m_dragStart.output ? start : m_dragPos),
+					toLocalPos(m_dragStart.output ? m_dragPos : start));
+			}
+
+			graph = nullptr;
 		}
-	};
 
-	bool GUIManager::checkbox(bool& checked, const StringView label)
-	{
-		auto& window = getCurrentWindowImpl();
-		auto& checkbox = window.nextStatelessControl<CheckBox>();
+	private:
 
-		checkbox.ref = &checked;
-		checkbox.labelText = window.window.font(label);
+		enum class DragMode
+		{
+			None,
+			Pan,
+			Node,
+			Link,
+		};
 
-		window.updateControl(checkbox);
-		return checkbox.valueChanged();
-	}
+		struct Port
+		{
+			uint64 node;
 
-	// RadioButton
+			size_t port;
 
-	class RadioButton : public IControl
-	{
-	public:
+			bool output;
+		};
 
-		using Config = Config::RadioButton;
+		Vec2 m_pan{ 0, 0 };
 
-		bool selected;
+		Rect m_rect{ 0, 0, 0, 0 };
+
+		Array<uint64> m_visibleNodes;
+
+		size_t m_nextNode = 0;
+
+		Array<uint64> m_visibleLinks;
+
+		// 以下は描画に使うためにendNodes()で写したもの
+		Array<LineString> m_linkCurves;
+
+		size_t m_shownLinkCount = 0;
+
+		Optional<size_t> m_selectedLinkIndex;
+
+		// ドラッグ中のリンクの両端 (ローカル座標)
+		Optional<std::pair<Vec2, Vec2>> m_dragLink;
+
+		DragMode m_drag = DragMode::None;
+
+		uint64 m_dragNode = 0;
 
-		DrawableText labelText;
+		Vec2 m_dragOffset{ 0, 0 };
 
-		bool clicked() const { return m_clicked; }
+		Port m_dragStart{ 0, 0, false };
 
-	private:
+		Vec2 m_dragPos{ 0, 0 };
 
-		bool m_hovered;
+		Optional<Port> m_hoveredPort;
 
-		bool m_clicked = false;
+		Optional<uint64> m_selectedNode;
 
-		Circle m_circle;
+		Optional<uint64> m_selectedLink;
 
-		Vec2 m_labelLeftCenter;
+		Vec2 toGraphPos(Vec2 localPos) const
+		{
+			return localPos - m_rect.pos + m_pan;
+		}
 
-		Size computeSize() const override
+		Vec2 toLocalPos(Vec2 graphPos) const
 		{
-			Size labelSize = labelText.region().size.asPoint();
-			return { labelSize.x + circleSize() + Config::CircleMargin, labelSize.y };
+			return graphPos - m_pan + m_rect.pos;
 		}
 
-		void update(Rect rect, Optional<Vec2> cursorPos) override
+		Vec2 portPos(const Port& port) const
 		{
-			m_circle = { Arg::leftCenter = rect.leftCenter(), static_cast<RectF::size_type::value_type>(circleSize()) / 2 };
-			m_labelLeftCenter = m_circle.right() + Vec2{ Config::CircleMargin, 0 };
+			return port.output
+				? graph->outputPos(port.node, port.port)
+				: graph->inputPos(port.node, port.port);
+		}
 
-			m_hovered = cursorPos && rect.contains(*cursorPos);
-			m_clicked = m_hovered && MouseL.down();
-			selected |= m_clicked;
+		// ポートはノードの外にはみ出すので、周りのノードも調べる
+		Optional<Port> findPort(Vec2 pos) const
+		{
+			Array<uint64> nodes;
+			graph->queryNodes(RectF{ Arg::center = pos, Config::PortRadius * 4 }, nodes);
 
-			if (m_hovered)
+			for (auto itr = nodes.rbegin(); itr != nodes.rend(); itr++)
 			{
-				Cursor::RequestStyle(CursorStyle::Hand);
+				const auto& node = graph->node(*itr);
+				for (size_t i = 0; i < node.inputs.size(); i++)
+				{
+					if (graph->inputPos(*itr, i).distanceFrom(pos) <= Config::PortRadius * 2)
+					{
+						return Port{ *itr, i, false };
+					}
+				}
+				for (size_t i = 0; i < node.outputs.size(); i++)
+				{
+					if (graph->outputPos(*itr, i).distanceFrom(pos) <= Config::PortRadius * 2)
+					{
+						return Port{ *itr, i, true };
+					}
+				}
 			}
+			return none;
 		}
 
-		void draw() const override
+		void startLink(const Port& port)
 		{
-			ColorF color, frameColor;
-			if (selected)
-			{
-				color = Config::CheckedCircleColor;
-				frameColor = Config::CheckedFrameColor;
-			}
-			else if (m_hovered)
-			{
-				color = Config::HoveredCircleColor;
-				frameColor = Config::HoveredFrameColor;
-			}
-			else
+			m_drag = DragMode::Link;
+			m_dragStart = port;
+			m_dragPos = portPos(port);
+
+			// つながっている入力からドラッグしたときはリンクを外して付け替える
+			if (not port.output)
 			{
-				color = Config::CircleColor;
-				frameColor = Config::FrameColor;
+				if (auto existing = graph->linkTo(port.node, port.port))
+				{
+					const GraphLink link = graph->link(*existing);
+					graph->removeLink(*existing);
+					m_dragStart = Port{ link.fromNode, link.fromPort, true };
+				}
 			}
+		}
 
-			m_circle
-				.draw(color)
-				.drawFrame(Config::CircleFrameThickness, frameColor);
-			if (selected)
+		void connect(const Port& a, const Port& b)
+		{
+			if (a.output == b.output)
 			{
-				Circle{ m_circle.center, m_circle.r * Config::InnerCircleScale }
-				.draw(frameColor);
+				return;
 			}
-			labelText
-				.draw(Arg::leftCenter = m_labelLeftCenter, Config::LabelColor);
+
+			const Port& from = a.output ? a : b;
+			const Port& to = a.output ? b : a;
+			graph->addLink(GraphLink{ from.node, from.port, to.node, to.port });
 		}
 
-		int32 circleSize() const
+		Size computeSize() const override
 		{
-			return static_cast<int32>(labelText.font.height() * Config::CircleScale);
+			return { 0, 0 };
 		}
+
+		void update(Rect, Optional<Vec2>) override
+		{ }
+
+		void draw() const override
+		{ }
 	};
 
-	bool GUIManager::radiobutton(bool selected, const StringView label)
+	// ノードより先に配置して、入力を処理してから表示するノードを決める
+	class NodeGraphBackground : public IControl
 	{
-		auto& window = getCurrentWindowImpl();
-		auto& radioButton = window.nextStatelessControl<RadioButton>();
+	public:
 
-		radioButton.selected = selected;
-		radioButton.labelText = window.window.font(label);
+		NodeGraphCanvas* canvas = nullptr;
 
-		window.updateControl(radioButton);
-		return radioButton.clicked();
-	}
+	private:
 
-	// Tab
+		Size computeSize() const override
+		{
+			return { 0, 0 };
+		}
 
-	class Tab : public IControl
+		void update(Rect rect, Optional<Vec2> cursorPos) override
+		{
+			canvas->updateInput(rect, cursorPos);
+		}
+
+		void draw() const override
+		{
+			canvas->drawBackground();
+		}
+	};
+
+	// ドラッグ中のリンクをノードの上に重ねて描くため、最後に配置する
+	class NodeGraphOverlay : public IControl
 	{
 	public:
 
-		using Config = Config::Tab;
+		NodeGraphCanvas* canvas = nullptr;
 
-		size_t selectedIdx = 0;
+	private:
 
-		void init(const Array<String>& tabNames)
+		Size computeSize() const override
 		{
-			assert(tabNames);
+			return { 0, 0 };
+		}
 
-			m_tabs.clear();
-			m_tabs.reserve(tabNames.size());
+		void update(Rect, Optional<Vec2>) override
+		{ }
 
-			int32 tabHeight = 0;
-			Point tabPos = { Config::FrameThickness, Config::FrameThickness };
-			auto& font = SimpleGUI::GetFont();
-			for (auto& name : tabNames)
-			{
-				auto& tab = m_tabs.emplace_back(TabItem{
-					.label = font(name)
-				});
+		void draw() const override
+		{
+			canvas->drawOverlay();
+		}
+	};
 
-				Size labelSize = tab.label.region().size.asPoint();
-				tab.localRect.pos = tabPos;
-				tab.localRect.w = Max(labelSize.x + Config::TabR * 2, Config::TabMinWidth);
+	// ノードの枠とタイトル、ポート (中身のコントロールより先に配置する)
+	class GraphNodeFrame : public IControl
+	{
+	public:
 
-				tabPos.x += tab.localRect.w
-					+ Config::FrameThickness
-					+ Config::TabSpace
-					+ Config::FrameThickness;
+		using Config = Config::NodeGraph;
 
-				tabHeight = Max(tabHeight, labelSize.y);
-			}
-			for (auto& tab : m_tabs)
-			{
-				tab.localRect.h = tabHeight;
-			}
-		}
+		const NodeGraphCanvas* canvas = nullptr;
 
-	private:
+		uint64 node = 0;
 
-		struct TabItem
-		{
-			Rect localRect;
+		double rowHeight = 0.0;
 
-			DrawableText label;
+		bool selected = false;
 
-			Rect globalRect;
+		DrawableText title;
 
-			bool mouseOver = false;
-		};
+		Array<DrawableText> inputs;
 
-		Array<TabItem> m_tabs;
+		Array<DrawableText> outputs;
+
+	private:
+
+		Rect m_rect{ 0, 0, 0, 0 };
 
 		Size computeSize() const override
 		{
-			return m_tabs.back().localRect.br() + Size{ Config::FrameThickness, Config::FrameThickness };
+			return m_rect.size;
 		}
 
-		void update(Rect rect, Optional<Vec2> cursorPos) override
+		void update(Rect rect, Optional<Vec2>) override
 		{
-			for (auto [idx, tab] : IndexedRef(m_tabs))
-			{
-				tab.globalRect = tab.localRect.movedBy(rect.pos);
-				tab.mouseOver = cursorPos && tab.globalRect.contains(*cursorPos);
-
-				if (tab.mouseOver && MouseL.down())
-				{
-					selectedIdx = idx;
-				}
-			}
+			m_rect = rect;
 		}
 
 		void draw() const override
 		{
-			for (auto [idx, tab] : IndexedRef(m_tabs))
+			const RoundRect frame{ m_rect, Config::Roundness };
+			frame.draw(Config::NodeColor);
+			RectF{ m_rect.pos, m_rect.w, rowHeight }.draw(Config::TitleColor);
+			frame.drawFrame(selected ? 2 : 1, selected ? Config::SelectedBorderColor : Config::BorderColor);
+
+			title.draw(Arg::leftCenter = Vec2{ m_rect.x + Config::Padding, m_rect.y + rowHeight * 0.5 }, Config::LabelColor);
+
+			for (size_t i = 0; i < inputs.size(); i++)
 			{
-				bool selected = idx == selectedIdx;
+				const Vec2 pos{ m_rect.x, m_rect.y + rowHeight * (i + 1.5) };
+				Circle{ pos, Config::PortRadius }.draw(canvas->isHoveredPort(node, i, false) ? Config::HoveredPortColor : Config::PortColor);
+				inputs[i].draw(Arg::leftCenter = pos.movedBy(Config::PortRadius + Config::Padding, 0), Config::LabelColor);
+			}
 
-				// タブ内部
+			for (size_t i = 0; i < outputs.size(); i++)
+			{
+				const Vec2 pos{ m_rect.rightX(), m_rect.y + rowHeight * (i + 1.5) };
+				Circle{ pos, Config::PortRadius }.draw(canvas->isHoveredPort(node, i, true) ? Config::HoveredPortColor : Config::PortColor);
+				outputs[i].draw(Arg::rightCenter = pos.movedBy(-(Config::PortRadius + Config::Padding), 0), Config::LabelColor);
+			}
+		}
+	};
 
-				if (selected)
-				{
-					tab.globalRect
-						.stretched(0, 0, Config::FrameThickness, 0)
-						.rounded(Config::TabR, Config::TabR, 0, 0)
-						.draw(Config::SelectedTabColor);
-				}
-				else
-				{
-					tab.globalRect
-						.rounded(Config::TabR, Config::TabR, 0, 0)
-						.draw(tab.mouseOver ? Config::HoveredTabColor : Config::TabColor);
-				}
+	void GUIManager::beginNodeGraph(const StringView id, NodeGraph& graph, SizeF size)
+	{
+		using Config = Config::NodeGraph;
 
-				// タブ枠線
+		auto& window = getCurrentWindowImpl();
+		assert(window.activeNodeGraph() == nullptr);
 
-				LineString frame;
-				{
-					Polygon p = tab.globalRect
-						.stretched(Config::FrameThickness * 0.5, Config::FrameThickness * 0.5, 0, Config::FrameThickness * 0.5)
-						.rounded(Config::TabR + Config::FrameThickness * 0.5, Config::TabR + Config::FrameThickness * 0.5, 0, 0);
-					auto& outer = p.outer();
-					frame.reserve(outer.size());
-					frame.push_back(outer.back());
-					frame.insert(frame.cend(), outer.begin(), outer.end() - 1);
-				}
-				frame.draw(LineStyle::Uncapped, Config::FrameThickness, Config::FrameColor);
+		auto& canvas = window.nextStatefulControl<NodeGraphCanvas>(id.hash());
+		canvas.graph = &graph;
+		graph.setRowHeight(window.window.font.height());
 
-				// タブ文字列
+		size_t bodyId = id.hash();
+		s3d::detail::HashCombine(bodyId, typeid(NodeGraphCanvas).hash_code());
+		window.beginChild(bodyId, size);
 
-				tab.label.drawAt(tab.globalRect.center(), Config::LabelColor);
-			}
+		// スクロールはさせず、endChild()で足される余白を除いた大きさだけ確保する
+		const RectF viewport = window.childViewport();
+		const Rect localRect = window.placeRect({ 0, 0, Max(0.0, viewport.w - window.window.padding), Max(0.0, viewport.h - window.window.padding) });
 
-			// タブ下部下線
+		canvas.origin = localRect.pos;
 
-			if (selectedIdx < m_tabs.size())
-			{
-				// 選択されているタブの下は空ける
+		auto& background = window.nextStatelessControl<NodeGraphBackground>();
+		background.canvas = &canvas;
+		window.updateControlAt(background, localRect.stretched(0, window.window.padding, window.window.padding, 0));
 
-				auto& firstTab = m_tabs.front();
-				auto& selectedTab = m_tabs[selectedIdx];
-				auto& lastTab = m_tabs.back();
-				Rect{ firstTab.globalRect.leftX() - Config::FrameThickness, firstTab.globalRect.bottomY(), selectedTab.localRect.leftX(), Config::FrameThickness }
-				.draw(Config::FrameColor);
-				Rect{ selectedTab.globalRect.br(), lastTab.localRect.rightX() - selectedTab.localRect.rightX() + Config::FrameThickness, Config::FrameThickness }
-				.draw(Config::FrameColor);
-			}
-			else
-			{
-				// 範囲外のときは空けない
+		canvas.beginNodes(viewport.size);
+		window.setActiveNodeGraph(&canvas);
+	}
 
-				auto& firstTab = m_tabs.front();
-				auto& lastTab = m_tabs.back();
-				Rect{
-					firstTab.globalRect.leftX() - Config::FrameThickness,
-					firstTab.globalRect.bottomY(),
-					lastTab.localRect.rightX() + Config::FrameThickness,
-					Config::FrameThickness
-				}.draw(Config::FrameColor);
-			}
+	// 評価中のノードの中身の大きさをグラフに反映する
+	static void EndGraphNode(detail::WindowImpl& window, NodeGraphCanvas& canvas)
+	{
+		const RectF bounds = window.endFloating();
+		const uint64 id = *canvas.currentNode;
+		canvas.currentNode = none;
+
+		// 中身の評価中に削除されていることがある
+		if (not canvas.graph->containsNode(id))
+		{
+			return;
 		}
-	};
 
-	size_t& GUIManager::tab(const StringView id, Array<String> tabNames)
+		const Vec2 pos = canvas.graph->node(id).pos - canvas.pan();
+		canvas.graph->resizeNode(id, bounds.bottomY() + Config::NodeGraph::Padding - pos.y);
+	}
+
+	Optional<uint64> GUIManager::nodeGraphNode()
 	{
-		assert(tabNames);
+		using Config = Config::NodeGraph;
+
 		auto& window = getCurrentWindowImpl();
-		auto& tab = window.nextStatefulControl<Tab>(id.hash());
+		auto& canvas = *window.activeNodeGraph();
+		auto& graph = *canvas.graph;
 
-		tab.init(tabNames);
+		if (canvas.currentNode)
+		{
+			EndGraphNode(window, canvas);
+		}
 
-		window.updateControl(tab);
-		return tab.selectedIdx;
+		// 呼び出し側が削除したノードは飛ばす
+		Optional<uint64> id;
+		do
+		{
+			id = canvas.nextNode();
+		} while (id && not graph.containsNode(*id));
+
+		if (not id)
+		{
+			return none;
+		}
+
+		const auto& node = graph.node(*id);
+		const RectF rect = graph.nodeRect(*id).movedBy(-canvas.pan());
+		const double rowHeight = graph.rowHeight();
+		const auto& font = window.window.font;
+
+		auto& frame = window.nextStatelessControl<GraphNodeFrame>();
+		frame.canvas = &canvas;
+		frame.node = *id;
+		frame.rowHeight = rowHeight;
+		frame.selected = canvas.selectedNode() == *id;
+		frame.title = font(node.title);
+		frame.inputs.resize(node.inputs.size());
+		for (size_t i = 0; i < node.inputs.size(); i++)
+		{
+			frame.inputs[i] = font(node.inputs[i]);
+		}
+		frame.outputs.resize(node.outputs.size());
+		for (size_t i = 0; i < node.outputs.size(); i++)
+		{
+			frame.outputs[i] = font(node.outputs[i]);
+		}
+
+		// 枠は内容の大きさに含めない (ノードは子領域の外にもはみ出す)
+		window.updateControlAt(frame, Rect{ canvas.origin + rect.pos.asPoint(), rect.size.asPoint() });
+
+		// 中身はポートの行の下から配置する
+		const size_t rows = Max(node.inputs.size(), node.outputs.size());
+		size_t scopeId = *id;
+		s3d::detail::HashCombine(scopeId, typeid(GraphNodeFrame).hash_code());
+		window.beginFloating(scopeId, RectF{
+			rect.x + Config::Padding,
+			rect.y + rowHeight * (rows + 1) + Config::Padding,
+			Max(0.0, rect.w - Config::Padding * 2.0),
+			0
+		});
+
+		canvas.currentNode = id;
+		return id;
+	}
+
+	void GUIManager::endNodeGraph()
+	{
+		auto& window = getCurrentWindowImpl();
+		auto& canvas = *window.activeNodeGraph();
+
+		if (canvas.currentNode)
+		{
+			EndGraphNode(window, canvas);
+		}
+
+		const RectF viewport = window.childViewport();
+		auto& overlay = window.nextStatelessControl<NodeGraphOverlay>();
+		overlay.canvas = &canvas;
+		window.updateControlAt(overlay, window.placeRect({ 0, 0, Max(0.0, viewport.w - window.window.padding), Max(0.0, viewport.h - window.window.padding) }));
+
+		canvas.endNodes();
+		window.setActiveNodeGraph(nullptr);
+		window.endChild();
 	}
 
 	// SimpleColorPicker
@@ -2356,8 +12158,8 @@ namespace SasaGUI
 
 		picker.ref = &value;
 
-		window.updateControl(picker);
-		return picker.valueChanged();
+		return window.updateControl(picker)
+			&& picker.valueChanged();
 	}
 
 	// SimpleSlider
@@ -2412,8 +12214,8 @@ namespace SasaGUI
 		slider.ref = &value;
 		slider.width = width;
 
-		window.updateControl(slider);
-		return slider.valueChanged();
+		return window.updateControl(slider)
+			&& slider.valueChanged();
 	}
 
 	// ProgressBar
@@ -2579,11 +12381,11 @@ namespace SasaGUI
 
 		sw.value = value;
 
-		window.updateControl(sw);
+		bool updated = window.updateControl(sw);
 
 		value = sw.value;
 
-		return sw.valueChanged();
+		return updated && sw.valueChanged();
 	}
 
 	// Custom
@@ -1,4 +1,5 @@
 ﻿#include <Siv3D.hpp> // OpenSiv3D v0.6.7
+#include <span>
 
 namespace SasaGUI
 {
@@ -57,69 +58,1110 @@ namespace SasaGUI
 		/// 無効
 		/// </summary>
 		Disable = 1 << 9,
+		/// <summary>
+		/// タイトルバーに折りたたみボタンを表示する
+		/// </summary>
+		Collapsible = 1 << 10,
+		/// <summary>
+		/// 中身が増減しても表示中の先頭のコントロールが動かないようにスクロールする
+		/// </summary>
+		ScrollAnchor = 1 << 11,
+		/// <summary>
+		/// 自動リサイズ・初回フレームなどで大きさが決まっていないとき、window()のfuncを2回呼んで大きさを測定してから配置する
+		/// funcの副作用も2回起こるので、何度呼んでも同じ結果になるfuncにだけ指定してください (windowBegin()では測定しません)
+		/// </summary>
+		MeasurePass = 1 << 12,
+
+		Debug = 1 << 31
+	};
+	DEFINE_BITMASK_OPERATORS(WindowFlag);
+
+	enum class Alignment : int32
+	{
+		/// <summary>
+		/// 左 (上) 寄せ
+		/// </summary>
+		Start,
+		/// <summary>
+		/// 中央寄せ
+		/// </summary>
+		Center,
+		/// <summary>
+		/// 右 (下) 寄せ
+		/// </summary>
+		End,
+		/// <summary>
+		/// 領域いっぱいに広げる
+		/// </summary>
+		Stretch
+	};
+
+	/// <summary>
+	/// レイアウトコンテナ内の1要素 (グリッドでは1列) の設定
+	/// </summary>
+	struct LayoutTrack
+	{
+		/// <summary>
+		/// 余った幅を分配する比率 (0のときは自然な大きさのまま)
+		/// </summary>
+		double weight = 0.0;
+
+		int32 minSize = 0;
+
+		int32 maxSize = std::numeric_limits<int32>::max();
+
+		/// <summary>
+		/// 主軸方向の配置
+		/// </summary>
+		Alignment align = Alignment::Start;
+	};
+
+	/// <summary>
+	/// 表の1列の設定
+	/// </summary>
+	struct TableColumn
+	{
+		String label;
+
+		/// <summary>
+		/// 最初の幅
+		/// </summary>
+		double width = 100.0;
+
+		/// <summary>
+		/// 境界のドラッグで幅を変えられるか
+		/// </summary>
+		bool resizable = true;
+
+		/// <summary>
+		/// データ上の行番号どうしを比べる関数 (空のときは並べ替えない)
+		/// 並べ替えは別スレッドで行うので、完了するまでデータを変更しないでください
+		/// </summary>
+		std::function<bool(size_t, size_t)> less;
+	};
+
+	struct Window
+	{
+		String displayName;
+
+		Rect rect;
+
+		WindowFlag flags;
+
+		Font font;
+
+		Size maxSize{ std::numeric_limits<Size::value_type>::max(), std::numeric_limits<Size::value_type>::max() };
+
+		int32 space = 5;
+
+		int32 padding = 10;
+
+		bool defined = false;
+
+		/// <summary>
+		/// 評価中の行の矩形 (コンテンツ座標)
+		/// 内部では倍精度で保持しており、int32に収まらない位置は丸めた値になります
+		/// </summary>
+		Rect lineRect{ padding, padding, 0, 0 };
+
+		bool requestMoveToFront = false;
+
+		bool sameLine = false;
+
+		bool hasTitlebar() const
+		{
+			return
+				not (flags & WindowFlag::NoBackground) &&
+				not (flags & WindowFlag::NoTitlebar);
+		}
+
+		bool isResizable() const
+		{
+			return
+				not (flags & WindowFlag::NoResize) &&
+				not (flags & WindowFlag::AutoResize);
+		}
+
+		bool isMovable() const
+		{
+			return
+				hasTitlebar() &&
+				not (flags & WindowFlag::NoMove) &&
+				not (flags & WindowFlag::AutoResize);
+		}
+
+		bool isCollapsible() const
+		{
+			return
+				hasTitlebar() &&
+				flags & WindowFlag::Collapsible;
+		}
+	};
+
+	class IControl
+	{
+	public:
+
+		virtual Size computeSize() const = 0;
+
+		virtual void update(Rect rect, Optional<Vec2> cursorPos) = 0;
+
+		virtual void draw() const = 0;
+
+		virtual ~IControl() { };
+	};
+
+	/// <summary>
+	/// 表に行を渡すデータソース
+	/// セルは表示される行だけ文字列にされます
+	/// </summary>
+	class ITableSource
+	{
+	public:
+
+		virtual size_t rowCount() const = 0;
+
+		virtual size_t columnCount() const = 0;
+
+		virtual String columnName(size_t column) const = 0;
+
+		/// <summary>
+		/// セルの文字列をoutに書き込みます
+		/// </summary>
+		virtual void formatCell(size_t row, size_t column, String& out) const = 0;
+
+		/// <summary>
+		/// 列を並べ替えられるか
+		/// </summary>
+		virtual bool sortable(size_t) const { return false; }
+
+		/// <summary>
+		/// 並べ替えに使う比較 (別スレッドから呼ばれます)
+		/// </summary>
+		virtual bool less(size_t, size_t a, size_t b) const { return a < b; }
+
+		virtual ~ITableSource() { };
+	};
+
+	enum class ColumnType : uint8
+	{
+		Int8, Int16, Int32, Int64,
+		UInt8, UInt16, UInt32, UInt64,
+		Float, Double
+	};
+
+	/// <summary>
+	/// 固定長のバイナリファイル内の1列の配置
+	/// </summary>
+	struct BinaryColumn
+	{
+		String name;
+
+		ColumnType type = ColumnType::Int32;
+
+		/// <summary>
+		/// 先頭の行の値のファイル先頭からの位置 (バイト)
+		/// </summary>
+		uint64 offset = 0;
+
+		/// <summary>
+		/// 行ごとの間隔 (バイト, 0のときは型の大きさ = 列ごとにまとめて並んだ形式)
+		/// </summary>
+		uint64 stride = 0;
+	};
+
+	/// <summary>
+	/// 固定長のバイナリファイルをメモリマップして読むデータソース
+	/// ファイルを読み込まずに開き、表示する行の値だけを読みます
+	/// </summary>
+	class MappedBinarySource : public ITableSource
+	{
+	public:
+
+		MappedBinarySource() = default;
+
+		/// <param name="rowCount">行数 (0のときはファイルの大きさから求めます)</param>
+		MappedBinarySource(const FilePathView path, const Array<BinaryColumn>& columns, size_t rowCount = 0);
+
+		bool open(const FilePathView path, const Array<BinaryColumn>& columns, size_t rowCount = 0);
+
+		bool isOpen() const { return m_memory.data != nullptr; }
+
+		size_t rowCount() const override { return m_rowCount; }
+
+		size_t columnCount() const override { return m_columns.size(); }
+
+		String columnName(size_t column) const override { return m_columns[column].name; }
+
+		void formatCell(size_t row, size_t column, String& out) const override;
+
+		bool sortable(size_t) const override { return true; }
+
+		bool less(size_t column, size_t a, size_t b) const override;
+
+	private:
+
+		MemoryMappedFileView m_file;
+
+		MemoryMappedFileView::MappedMemory m_memory;
+
+		Array<BinaryColumn> m_columns;
+
+		size_t m_rowCount = 0;
+
+		const Byte* valuePtr(size_t row, size_t column) const;
+	};
+
+	/// <summary>
+	/// CSVファイルをメモリマップして読むデータソース
+	/// 別スレッドで行の位置の索引を作りながら、索引ができた行から表示します
+	/// </summary>
+	class MappedCsvSource : public ITableSource
+	{
+	public:
+
+		/// <summary>
+		/// 何行ごとに行頭の位置を記録するか
+		/// </summary>
+		constexpr static size_t IndexInterval = 64;
+
+		MappedCsvSource() = default;
+
+		MappedCsvSource(const FilePathView path, char delimiter = ',', bool hasHeader = true);
+
+		bool open(const FilePathView path, char delimiter = ',', bool hasHeader = true);
+
+		void close();
+
+		bool isOpen() const { return m_memory.data != nullptr; }
+
+		/// <summary>
+		/// 索引を作っている途中か
+		/// </summary>
+		bool isIndexing() const { return m_indexer.isValid() && not m_indexer.isReady(); }
+
+		size_t rowCount() const override { return m_rowCount.load(std::memory_order_acquire); }
+
+		size_t columnCount() const override { return m_columnNames.size(); }
+
+		String columnName(size_t column) const override { return m_columnNames[column]; }
+
+		void formatCell(size_t row, size_t column, String& out) const override;
+
+		~MappedCsvSource();
+
+	private:
+
+		MemoryMappedFileView m_file;
+
+		MemoryMappedFileView::MappedMemory m_memory;
+
+		char m_delimiter = ',';
+
+		Array<String> m_columnNames;
+
+		// IndexInterval行ごとの行頭の位置
+		Array<uint64> m_checkpoints;
+
+		mutable std::mutex m_checkpointMutex;
+
+		std::atomic<size_t> m_rowCount = 0;
+
+		std::atomic<bool> m_abort = false;
+
+		AsyncTask<void> m_indexer;
+
+		const char* rowBegin(size_t row) const;
+	};
+
+	/// <summary>
+	/// ログの行を保持する固定長のリングバッファ
+	/// push()はどのスレッドからでもロックせずに呼べ、GUIスレッドがフレームごとにまとめて取り込みます
+	/// 追加された行は最初に確保した受け渡し用の枠に入れるので、行ごとの確保は起こりません
+	/// </summary>
+	class LogSink
+	{
+	public:
+
+		struct Line
+		{
+			String text;
+
+			ColorF color;
+		};
+
+		/// <param name="capacity">保持する行数 (超えると古い行から捨てます)</param>
+		/// <param name="queueCapacity">取り込むまでに溜めておける行数 (超えた行は捨てます)</param>
+		explicit LogSink(size_t capacity = 100000, size_t queueCapacity = 16384);
+
+		LogSink(const LogSink&) = delete;
+
+		LogSink& operator=(const LogSink&) = delete;
+
+		/// <summary>
+		/// 行を追加します (どのスレッドからでもロックせずに呼べます)
+		/// 取り込まれていない行がqueueCapacity行あるときは、追加せずに捨てた行として数えます
+		/// </summary>
+		/// <returns>追加できたか</returns>
+		bool push(String text, ColorF color = Palette::Black);
+
+		/// <summary>
+		/// 追加された行をリングバッファに取り込みます (GUIスレッドから呼びます)
+		/// logView()が毎フレーム呼ぶので、通常は呼ぶ必要はありません
+		/// </summary>
+		void drain();
+
+		/// <summary>
+		/// 取り込んだ行を消します (GUIスレッドから呼びます)
+		/// </summary>
+		void clear() { m_begin = m_end; }
+
+		size_t capacity() const { return m_capacity; }
+
+		/// <summary>
+		/// 受け渡し用の枠が埋まっていたために捨てた行の数
+		/// </summary>
+		uint64 droppedCount() const { return m_dropped.load(std::memory_order_relaxed); }
+
+		size_t size() const { return static_cast<size_t>(m_end - m_begin); }
+
+		/// <summary>
+		/// 保持している最も古い行の通し番号
+		/// </summary>
+		uint64 beginIndex() const { return m_begin; }
+
+		/// <summary>
+		/// 最も新しい行の次の通し番号
+		/// </summary>
+		uint64 endIndex() const { return m_end; }
+
+		/// <summary>
+		/// 通し番号の行 (beginIndex() &lt;= index &lt; endIndex())
+		/// </summary>
+		const Line& operator[](uint64 index) const { return m_lines[index % m_capacity]; }
+
+	private:
+
+		// 受け渡し用の枠 (sequenceが書き込める位置なら空き、その次の値なら書き込み済み)
+		struct Slot
+		{
+			std::atomic<uint64> sequence;
+
+			Line line;
+		};
+
+		std::unique_ptr<Slot[]> m_slots;
+
+		size_t m_queueCapacity;
+
+		// 次に書き込む位置 (生産者が奪い合う)
+		std::atomic<uint64> m_enqueuePos = 0;
+
+		// 次に取り出す位置 (GUIスレッドだけが触る)
+		uint64 m_dequeuePos = 0;
+
+		std::atomic<uint64> m_dropped = 0;
+
+		size_t m_capacity;
+
+		Array<Line> m_lines;
+
+		uint64 m_begin = 0;
+
+		uint64 m_end = 0;
+	};
+
+	/// <summary>
+	/// ストリップチャートの1系列分のサンプルを保持するリングバッファ
+	/// 1つのスレッドからロックせずにpush()でき、GUIスレッドが届いた分だけを取り込みます
+	/// </summary>
+	class StripChannel
+	{
+	public:
+
+		/// <summary>
+		/// 取り込み済みのサンプルの最小値と最大値
+		/// </summary>
+		struct MinMax
+		{
+			float min = std::numeric_limits<float>::infinity();
+
+			float max = -std::numeric_limits<float>::infinity();
+
+			bool isEmpty() const { return min > max; }
+		};
+
+		/// <param name="capacity">保持するサンプル数 (2の累乗に切り上げます)</param>
+		explicit StripChannel(size_t capacity = (1 << 20), ColorF color = Color{ 3, 121, 255 });
+
+		StripChannel(const StripChannel&) = delete;
+
+		StripChannel& operator=(const StripChannel&) = delete;
+
+		/// <summary>
+		/// サンプルを追加します (同時に呼べるのは1つのスレッドだけです)
+		/// </summary>
+		void push(float value);
+
+		void push(std::span<const float> values);
+
+		/// <summary>
+		/// 届いたサンプルを取り込みます (GUIスレッドから呼びます)
+		/// stripChart()が毎フレーム呼ぶので、通常は呼ぶ必要はありません
+		/// </summary>
+		void update();
+
+		size_t capacity() const { return m_samples.size(); }
+
+		ColorF color() const { return m_color; }
+
+		void setColor(ColorF color) { m_color = color; }
+
+		/// <summary>
+		/// 取り込んだサンプルの総数 (最後のサンプルの次の通し番号)
+		/// </summary>
+		uint64 endIndex() const { return m_end; }
+
+		/// <summary>
+		/// 保持している最も古いサンプルの通し番号 (取り込み中に上書きされたサンプルは含みません)
+		/// </summary>
+		uint64 beginIndex() const { return m_begin; }
+
+		/// <summary>
+		/// 通し番号のサンプル (beginIndex() &lt;= index &lt; endIndex())
+		/// 取り込んだ後に生産者が一周すると、新しいサンプルを返すことがあります
+		/// </summary>
+		float operator[](uint64 index) const { return loadSample(index); }
+
+		/// <summary>
+		/// 範囲のサンプルの最小値と最大値 (範囲の長さによらずほぼ一定の時間で求めます)
+		/// 読んでいる間に生産者が一周して上書きしたときは空を返します
+		/// </summary>
+		MinMax minMax(uint64 begin, uint64 end) const;
+
+	private:
+
+		// 最も細かい段のブロックの大きさ (2の累乗)
+		constexpr static int32 BaseShift = 4;
+
+		Array<float> m_samples;
+
+		uint64 m_mask;
+
+		ColorF m_color;
+
+		// 書き込んだサンプルの総数 (生産者が書き換える)
+		std::atomic<uint64> m_written = 0;
+
+		// 書き込みを始めたサンプルの総数 (サンプルを書く前に生産者が進める)
+		std::atomic<uint64> m_claimed = 0;
+
+		// 取り込んだサンプルの範囲 (GUIスレッドだけが触る)
+		uint64 m_begin = 0;
+
+		uint64 m_end = 0;
+
+		// 段ごとの2^(BaseShift + 段)個ずつのブロックの最小値と最大値 (m_begin以降のサンプルだけから作る)
+		Array<Array<MinMax>> m_levels;
+
+		float loadSample(uint64 index) const;
+
+		void storeSample(uint64 index, float value);
+
+		// これより前のサンプルは、読んでいる間に上書きされたかもしれない
+		uint64 overwrittenEnd() const;
+
+		void rebuildBlocks(uint64 begin, uint64 end);
+	};
+
+	/// <summary>
+	/// タイムラインの1区間
+	/// </summary>
+	struct TimelineSpan
+	{
+		double begin = 0.0;
+
+		double end = 0.0;
+
+		Color color{ 3, 121, 255 };
+	};
+
+	/// <summary>
+	/// タイムラインに表示するトラックとスパン
+	/// build()で開始時刻の順に並べ、縮小表示のために近いスパンをまとめた段を作ります
+	/// </summary>
+	class TimelineData
+	{
+	public:
+
+		size_t addTrack(const StringView name);
+
+		/// <summary>
+		/// スパンを追加します (同じトラックのスパンは重ならないようにしてください)
+		/// </summary>
+		void addSpan(size_t track, const TimelineSpan& span);
+
+		/// <summary>
+		/// スパンを並べ替え、まとめた段を作ります
+		/// 別スレッドから呼んでも構いませんが、その間は表示しないでください
+		/// </summary>
+		void build();
+
+		size_t trackCount() const { return m_tracks.size(); }
+
+		const String& trackName(size_t track) const { return m_tracks[track].name; }
+
+		/// <summary>
+		/// 開始時刻の順に並んだスパン (build()の後)
+		/// </summary>
+		const Array<TimelineSpan>& spans(size_t track) const { return m_tracks[track].levels.front().spans; }
+
+		double beginTime() const { return m_begin; }
+
+		double endTime() const { return m_end; }
+
+		/// <summary>
+		/// 時刻から前後tolerance以内にあるスパンの、spans()での番号を二分探索で求めます
+		/// </summary>
+		Optional<size_t> findSpan(size_t track, double time, double tolerance = 0.0) const;
+
+		/// <summary>
+		/// [begin, end)を1ピクセルあたりpixelTimeで表示するときに、1ピクセルより近いスパンをまとめてoutに書き込みます
+		/// </summary>
+		void mergedSpans(size_t track, double begin, double end, double pixelTime, Array<TimelineSpan>& out) const;
+
+	private:
+
+		// gapより短い隙間をまとめたスパン (先頭はまとめていないスパン)
+		struct Level
+		{
+			double gap;
+
+			Array<TimelineSpan> spans;
+		};
+
+		struct Track
+		{
+			String name;
+
+			Array<Level> levels{ Level{ 0.0, {} } };
+		};
+
+		Array<Track> m_tracks;
+
+		double m_begin = 0.0;
+
+		double m_end = 0.0;
+	};
+
+	/// <summary>
+	/// ツリーにノードを渡すデータソース
+	/// 子ノードは展開されたときだけ列挙されます
+	/// </summary>
+	class ITreeProvider
+	{
+	public:
+
+		/// <summary>
+		/// 子ノードのIDをoutに追加します (parentがnoneのときは最上位のノード)
+		/// </summary>
+		virtual void children(Optional<uint64> parent, Array<uint64>& out) const = 0;
+
+		/// <summary>
+		/// 子ノードを持つか (展開する矢印を表示するかに使われます)
+		/// </summary>
+		virtual bool hasChildren(uint64 node) const = 0;
+
+		/// <summary>
+		/// 表示される行だけ呼ばれます
+		/// </summary>
+		virtual String label(uint64 node) const = 0;
+
+		virtual ~ITreeProvider() { };
+	};
+
+	/// <summary>
+	/// タイルに分けて表示する画像のデータソース
+	/// 縮小段levelの画像は原寸の1/2^level (端数は切り上げ) の大きさです
+	/// </summary>
+	class ITiledImageSource
+	{
+	public:
+
+		/// <summary>
+		/// 原寸の大きさ
+		/// </summary>
+		virtual Size size() const = 0;
+
+		/// <summary>
+		/// 縮小段levelの画像のregionの範囲を返します (複数のスレッドから同時に呼ばれます)
+		/// </summary>
+		virtual Image decode(int32 level, const Rect& region) const = 0;
+
+		virtual ~ITiledImageSource() { };
+	};
+
+	/// <summary>
+	/// 読み込んだ画像から縮小段をすべて作っておくデータソース
+	/// 大きさはImageの上限 (16384 x 16384) までで、縮小段を含めてすべてメモリに置きます
+	/// それより大きな画像はMappedRawImageSourceを使ってください
+	/// </summary>
+	class ImagePyramidSource : public ITiledImageSource
+	{
+	public:
+
+		/// <summary>
+		/// 縮小段を1辺が1ピクセルになるまで作ります (大きな画像では時間がかかるので、別スレッドで作っても構いません)
+		/// </summary>
+		explicit ImagePyramidSource(Image image);
+
+		Size size() const override { return m_levels.front().size(); }
+
+		Image decode(int32 level, const Rect& region) const override;
+
+	private:
+
+		Array<Image> m_levels;
+	};
+
+	/// <summary>
+	/// RGBA各8ビットの画素を行の順に並べただけのファイルをメモリマップして読むデータソース
+	/// 表示する範囲の画素だけを読むので、Imageに収まらない大きさの画像も表示できます
+	/// 縮小段は読むたびに画素を間引いて作るため、大きく縮小すると細かい模様がちらつくことがあります
+	/// </summary>
+	class MappedRawImageSource : public ITiledImageSource
+	{
+	public:
+
+		MappedRawImageSource() = default;
+
+		/// <param name="offset">先頭の画素までのバイト数 (ヘッダーを読み飛ばします)</param>
+		MappedRawImageSource(const FilePathView path, Size size, uint64 offset = 0);
+
+		bool open(const FilePathView path, Size size, uint64 offset = 0);
+
+		bool isOpen() const { return m_memory.data != nullptr; }
+
+		Size size() const override { return m_size; }
+
+		Image decode(int32 level, const Rect& region) const override;
+
+	private:
+
+		MemoryMappedFileView m_file;
+
+		MemoryMappedFileView::MappedMemory m_memory;
+
+		Size m_size{ 0, 0 };
+
+		uint64 m_offset = 0;
+
+		const Byte* rowPtr(int32 y) const;
+	};
+
+	/// <summary>
+	/// 複数行のテキストをピーステーブルで保持する文書
+	/// 元のテキストと追加した文字列は書き換えず、編集は断片の並びを組み替えるだけで行います
+	/// 位置はすべてUTF-8のバイト単位です
+	/// </summary>
+	class TextDocument
+	{
+	public:
+
+		TextDocument() = default;
+
+		explicit TextDocument(const StringView text);
+
+		TextDocument(const TextDocument&) = delete;
+
+		TextDocument& operator=(const TextDocument&) = delete;
+
+		/// <summary>
+		/// UTF-8のファイルを読み込まずにメモリマップして開きます (編集の履歴は消えます)
+		/// </summary>
+		bool open(const FilePathView path);
+
+		/// <summary>
+		/// UTF-8で保存します (開いたときにBOMがあればBOMも書きます)
+		/// 同じフォルダーの一時ファイルに書いてから置き換えます
+		/// 開いているファイルに保存したときは開き直すので、編集の履歴は消えます
+		/// </summary>
+		bool save(const FilePathView path);
+
+		/// <summary>
+		/// 文字列で置き換えます (編集の履歴は消えます)
+		/// </summary>
+		void setText(const StringView text);
+
+		String text() const { return text(0, size()); }
+
+		/// <summary>
+		/// [begin, end)の文字列
+		/// </summary>
+		String text(uint64 begin, uint64 end) const;
+
+		/// <summary>
+		/// [begin, end)のバイト列をoutに書き込みます
+		/// </summary>
+		void read(uint64 begin, uint64 end, std::string& out) const;
+
+		uint64 size() const { return m_pieceEnds.isEmpty() ? 0 : m_pieceEnds.back(); }
+
+		size_t lineCount() const { return static_cast<size_t>(m_pieceLineEnds.isEmpty() ? 0 : m_pieceLineEnds.back()) + 1; }
+
+		/// <summary>
+		/// 行頭の位置
+		/// </summary>
+		uint64 lineBegin(size_t line) const;
+
+		/// <summary>
+		/// 行末の位置 (改行文字の手前)
+		/// </summary>
+		uint64 lineEnd(size_t line) const;
+
+		/// <summary>
+		/// 位置を含む行
+		/// </summary>
+		size_t lineAt(uint64 pos) const;
+
+		/// <summary>
+		/// 改行文字を除いた1行分の文字列
+		/// </summary>
+		String line(size_t line) const { return text(lineBegin(line), lineEnd(line)); }
+
+		/// <summary>
+		/// 次の文字の先頭の位置
+		/// </summary>
+		uint64 nextCharPos(uint64 pos) const;
+
+		/// <summary>
+		/// 前の文字の先頭の位置
+		/// </summary>
+		uint64 prevCharPos(uint64 pos) const;
+
+		void insert(uint64 pos, const StringView text);
+
+		void erase(uint64 begin, uint64 end);
+
+		bool canUndo() const { return not m_undo.isEmpty(); }
+
+		bool canRedo() const { return not m_redo.isEmpty(); }
+
+		/// <summary>
+		/// 直前の編集を取り消します
+		/// </summary>
+		/// <returns>取り消した編集の後ろの位置 (取り消せないときはnone)</returns>
+		Optional<uint64> undo();
+
+		/// <returns>やり直した編集の後ろの位置 (やり直せないときはnone)</returns>
+		Optional<uint64> redo();
+
+		/// <summary>
+		/// 続けて入力した文字は1回で取り消されるので、その区切りを入れます
+		/// </summary>
+		void breakUndoGroup();
+
+		/// <summary>
+		/// 内容が変わるたびに増える値
+		/// </summary>
+		uint64 version() const { return m_version; }
+
+	private:
+
+		enum class Source : uint8
+		{
+			Original,
+			Added
+		};
+
+		struct Piece
+		{
+			Source source = Source::Original;
+
+			uint64 offset = 0;
+
+			uint64 length = 0;
+
+			// 断片に含まれる改行の数
+			uint64 lineBreaks = 0;
+		};
+
+		// 断片の並びの1回の組み替え (m_pieces[first]からのremovedをinsertedに置き換えた)
+		struct Edit
+		{
+			size_t first = 0;
+
+			Array<Piece> removed;
+
+			Array<Piece> inserted;
+
+			uint64 pos = 0;
+
+			uint64 removedLength = 0;
 
-		Debug = 1 << 31
+			uint64 insertedLength = 0;
+
+			// 続けて入力した文字をまとめられるか
+			bool typing = false;
+		};
+
+		MemoryMappedFileView m_file;
+
+		MemoryMappedFileView::MappedMemory m_memory;
+
+		// メモリマップしているファイル (開いていないときは空)
+		FilePath m_path;
+
+		// 元のテキストの先頭にBOMがあったか (保存するときに書き戻す)
+		bool m_hasBom = false;
+
+		// ファイルを開いていないときの元のテキスト
+		std::string m_originalText;
+
+		std::string m_added;
+
+		// 元のテキストと追加した文字列の改行の位置
+		Array<uint64> m_originalBreaks;
+
+		Array<uint64> m_addedBreaks;
+
+		Array<Piece> m_pieces;
+
+		// 各断片の末尾までのバイト数と改行の数
+		Array<uint64> m_pieceEnds;
+
+		Array<uint64> m_pieceLineEnds;
+
+		Array<Edit> m_undo;
+
+		Array<Edit> m_redo;
+
+		uint64 m_version = 0;
+
+		const char* data(Source source) const;
+
+		const Array<uint64>& lineBreaks(Source source) const { return source == Source::Original ? m_originalBreaks : m_addedBreaks; }
+
+		Piece makePiece(Source source, uint64 offset, uint64 length) const;
+
+		// 位置を含む断片 (末尾の位置では断片の数)
+		size_t pieceAt(uint64 pos) const;
+
+		uint64 pieceBegin(size_t index) const { return index == 0 ? 0 : m_pieceEnds[index - 1]; }
+
+		char byteAt(uint64 pos) const;
+
+		void reset(uint64 originalSize);
+
+		// m_pieces[first]からcount個をpiecesに置き換える
+		void splice(size_t first, size_t count, const Array<Piece>& pieces);
+
+		void updateIndex(size_t first);
 	};
-	DEFINE_BITMASK_OPERATORS(WindowFlag);
 
-	struct Window
+	/// <summary>
+	/// ノードグラフのノード
+	/// </summary>
+	struct GraphNode
 	{
-		String displayName;
+		/// <summary>
+		/// 左上の座標
+		/// </summary>
+		Vec2 pos{ 0, 0 };
 
-		Rect rect;
+		String title;
 
-		WindowFlag flags;
+		/// <summary>
+		/// 左端に並べる入力ポートの名前
+		/// </summary>
+		Array<String> inputs;
 
-		Font font;
+		/// <summary>
+		/// 右端に並べる出力ポートの名前
+		/// </summary>
+		Array<String> outputs;
 
-		Size maxSize{ std::numeric_limits<Size::value_type>::max(), std::numeric_limits<Size::value_type>::max() };
+		double width = 160.0;
+	};
 
-		int32 space = 5;
+	/// <summary>
+	/// 出力ポートから入力ポートへのリンク
+	/// </summary>
+	struct GraphLink
+	{
+		uint64 fromNode = 0;
 
-		int32 padding = 10;
+		size_t fromPort = 0;
 
-		bool defined = false;
+		uint64 toNode = 0;
 
-		Rect lineRect{ padding, padding, 0, 0 };
+		size_t toPort = 0;
+	};
 
-		bool requestMoveToFront = false;
+	/// <summary>
+	/// ノードとリンクを、表示範囲の検索と当たり判定のための格子状の空間索引とともに保持します
+	/// リンクの曲線は端のノードが動くまで保持します
+	/// </summary>
+	class NodeGraph
+	{
+	public:
 
-		bool sameLine = false;
+		uint64 addNode(const GraphNode& node);
 
-		bool hasTitlebar() const
+		/// <summary>
+		/// ノードとつながっているリンクを削除します
+		/// </summary>
+		void removeNode(uint64 id);
+
+		void moveNode(uint64 id, Vec2 pos);
+
+		/// <summary>
+		/// 中身を含めたノードの高さを設定します (nodeGraphNode()が表示した大きさで更新します)
+		/// </summary>
+		void resizeNode(uint64 id, double height);
+
+		bool containsNode(uint64 id) const { return m_nodes.contains(id); }
+
+		const GraphNode& node(uint64 id) const { return m_nodes.at(id).node; }
+
+		RectF nodeRect(uint64 id) const;
+
+		size_t nodeCount() const { return m_nodes.size(); }
+
+		/// <summary>
+		/// リンクを追加します
+		/// 入力ポートには1本しかつながらないので、既にあるリンクは置き換えます
+		/// </summary>
+		/// <returns>追加したリンクのID (ポートが存在しないか、同じノードをつなぐときはnone)</returns>
+		Optional<uint64> addLink(const GraphLink& link);
+
+		void removeLink(uint64 id);
+
+		bool containsLink(uint64 id) const { return m_links.contains(id); }
+
+		const GraphLink& link(uint64 id) const { return m_links.at(id).link; }
+
+		/// <summary>
+		/// 入力ポートにつながっているリンク
+		/// </summary>
+		Optional<uint64> linkTo(uint64 node, size_t port) const;
+
+		size_t linkCount() const { return m_links.size(); }
+
+		/// <summary>
+		/// タイトルとポートの行の高さを設定します (変わるとすべての位置を計算し直します)
+		/// </summary>
+		void setRowHeight(double rowHeight);
+
+		double rowHeight() const { return m_rowHeight; }
+
+		Vec2 inputPos(uint64 node, size_t port) const;
+
+		Vec2 outputPos(uint64 node, size_t port) const;
+
+		/// <summary>
+		/// 矩形と交わるノードのIDを、追加した順にoutに書き込みます
+		/// </summary>
+		void queryNodes(const RectF& area, Array<uint64>& out) const;
+
+		/// <summary>
+		/// 矩形と交わるリンクのIDを、追加した順にoutに書き込みます
+		/// </summary>
+		void queryLinks(const RectF& area, Array<uint64>& out) const;
+
+		/// <summary>
+		/// 座標を含むノードのうち、最後に追加したもの
+		/// </summary>
+		Optional<uint64> nodeAt(Vec2 pos) const;
+
+		/// <summary>
+		/// 曲線から距離tolerance以内にあるリンクのうち、最後に追加したもの
+		/// </summary>
+		Optional<uint64> linkAt(Vec2 pos, double tolerance) const;
+
+		/// <summary>
+		/// リンクの曲線 (端のノードが動くまで保持します)
+		/// </summary>
+		const LineString& linkCurve(uint64 id) const;
+
+		/// <summary>
+		/// 内容が変わるたびに増える値
+		/// </summary>
+		uint64 version() const { return m_version; }
+
+	private:
+
+		// 空間索引の格子の1辺
+		constexpr static double CellSize = 256.0;
+
+		// 矩形が掛かる格子の範囲 (両端を含む)
+		struct CellRange
 		{
-			return
-				not (flags & WindowFlag::NoBackground) &&
-				not (flags & WindowFlag::NoTitlebar);
-		}
+			Point min{ 0, 0 };
 
-		bool isResizable() const
+			Point max{ -1, -1 };
+		};
+
+		// 格子のマスごとのIDの一覧
+		using CellTable = HashTable<uint64, Array<uint64>>;
+
+		struct NodeEntry
 		{
-			return
-				not (flags & WindowFlag::NoResize) &&
-				not (flags & WindowFlag::AutoResize);
-		}
+			GraphNode node;
 
-		bool isMovable() const
+			double height = 0.0;
+
+			// つながっているリンク
+			Array<uint64> links;
+
+			CellRange cells;
+		};
+
+		struct LinkEntry
 		{
-			return
-				hasTitlebar() &&
-				not (flags & WindowFlag::NoMove) &&
-				not (flags & WindowFlag::AutoResize);
-		}
-	};
+			GraphLink link;
 
-	class IControl
-	{
-	public:
+			// 曲線の制御点の外接矩形
+			RectF bounds{ 0, 0, 0, 0 };
 
-		virtual Size computeSize() const = 0;
+			CellRange cells;
 
-		virtual void update(Rect rect, Optional<Vec2> cursorPos) = 0;
+			// 空のときは次に使うときに計算する
+			mutable LineString curve;
+		};
 
-		virtual void draw() const = 0;
+		HashTable<uint64, NodeEntry> m_nodes;
 
-		virtual ~IControl() { };
+		HashTable<uint64, LinkEntry> m_links;
+
+		CellTable m_nodeCells;
+
+		CellTable m_linkCells;
+
+		double m_rowHeight = 20.0;
+
+		uint64 m_nextId = 1;
+
+		uint64 m_version = 0;
+
+		static CellRange CellsOf(const RectF& rect);
+
+		static void AddToCells(CellTable& table, uint64 id, const CellRange& range);
+
+		static void RemoveFromCells(CellTable& table, uint64 id, const CellRange& range);
+
+		static void QueryCells(const CellTable& table, const RectF& area, Array<uint64>& out);
+
+		// 中身がないときの高さ
+		double baseHeight(const GraphNode& node) const;
+
+		void updateNodeCells(uint64 id, NodeEntry& entry);
+
+		// 端のノードが動いたら外接矩形を計算し直して曲線を捨てる
+		void updateLink(uint64 id, LinkEntry& entry);
+
+		// 曲線の制御点
+		std::array<Vec2, 4> linkControlPoints(const GraphLink& link) const;
 	};
 
 	class GUIManager
@@ -142,23 +1184,64 @@ namespace SasaGUI
 
 		// Window
 
+		/// <summary>
+		/// ウィンドウを定義します
+		/// WindowFlag::MeasurePassを指定した自動リサイズ・初回フレームのウィンドウでは、大きさを確定させる測定パスのためにfuncが2回呼ばれます
+		/// 非表示・折りたたみ・画面外のウィンドウではfuncは呼ばれません
+		/// </summary>
 		template<class FuncType>
 		inline void window(const StringView name, FuncType&& func)
 		{
-			windowBegin(name);
-			func(*this);
-			windowEnd();
+			window(name, WindowFlag::None, std::forward<FuncType>(func));
 		}
 
+		/// <summary>
+		/// ウィンドウを定義します
+		/// WindowFlag::MeasurePassを指定した自動リサイズ・初回フレームのウィンドウでは、大きさを確定させる測定パスのためにfuncが2回呼ばれます
+		/// 非表示・折りたたみ・画面外のウィンドウではfuncは呼ばれません
+		/// </summary>
 		template<class FuncType>
 		inline void window(const StringView name, WindowFlag flags, FuncType&& func)
 		{
-			windowBegin(name, flags);
-			func(*this);
+			if (windowBegin(name, flags))
+			{
+				if (beginMeasure())
+				{
+					func(*this);
+					endMeasure();
+				}
+				func(*this);
+			}
+			windowEnd();
+		}
+
+		/// <summary>
+		/// テンプレートを指定してウィンドウを定義します
+		/// 同じテンプレートIDのウィンドウは、レイアウトコンテナの解決結果とcaption()の整形結果を共有します (ウィンドウの大きさはそれぞれで測定します)
+		/// </summary>
+		/// <param name="templateId">中身の構造が同じウィンドウで共通のID</param>
+		template<class FuncType>
+		inline void window(const StringView name, const StringView templateId, WindowFlag flags, FuncType&& func)
+		{
+			if (windowBegin(name, templateId, flags))
+			{
+				if (beginMeasure())
+				{
+					func(*this);
+					endMeasure();
+				}
+				func(*this);
+			}
 			windowEnd();
 		}
 
-		void windowBegin(const StringView name, WindowFlag flags = WindowFlag::None);
+		/// <summary>
+		/// ウィンドウを開始します
+		/// falseのときは中身を評価する必要はありません (windowEnd()は常に呼んでください)
+		/// </summary>
+		bool windowBegin(const StringView name, WindowFlag flags = WindowFlag::None);
+
+		bool windowBegin(const StringView name, const StringView templateId, WindowFlag flags = WindowFlag::None);
 
 		void windowEnd();
 
@@ -190,11 +1273,68 @@ namespace SasaGUI
 
 		const Window& getCurrentWindow() const;
 
+		/// <summary>
+		/// 現在のウィンドウで表示されているコンテンツ領域をコンテンツ座標で返します
+		/// </summary>
+		RectF getContentViewport() const;
+
+		/// <summary>
+		/// IDを付けたコントロールが見えるまで現在のウィンドウをスクロールします
+		/// </summary>
+		void scrollTo(const StringView id);
+
 		// Controls
 
 		void sameLine();
 
-		void dummy(Size size);
+		/// <summary>
+		/// 次のコントロールにIDを付けます
+		/// IDの付いたコントロールはscrollTo()とScrollAnchorの基準に使われます (IDを引数に取るコントロールには自動で付きます)
+		/// </summary>
+		void setNextItemId(const StringView id);
+
+		/// <summary>
+		/// 何も描かずに領域を確保します
+		/// </summary>
+		void dummy(SizeF size);
+
+		// Layout
+
+		/// <summary>
+		/// 子コントロールを横に並べるコンテナを開始します
+		/// </summary>
+		/// <param name="tracks">i番目の子コントロールの設定</param>
+		/// <param name="crossAlign">縦方向の配置</param>
+		void beginRow(const StringView id, const Array<LayoutTrack>& tracks = {}, Alignment crossAlign = Alignment::Start);
+
+		void endRow();
+
+		/// <summary>
+		/// 子コントロールを縦に並べるコンテナを開始します
+		/// </summary>
+		/// <param name="tracks">i番目の子コントロールの設定</param>
+		/// <param name="crossAlign">横方向の配置</param>
+		void beginColumn(const StringView id, const Array<LayoutTrack>& tracks = {}, Alignment crossAlign = Alignment::Start);
+
+		void endColumn();
+
+		/// <summary>
+		/// 子コントロールを左上から行優先で格子状に並べるコンテナを開始します
+		/// </summary>
+		/// <param name="columns">各列の設定 (要素数が列数)</param>
+		/// <param name="crossAlign">セル内の縦方向の配置</param>
+		void beginGrid(const StringView id, const Array<LayoutTrack>& columns, Alignment crossAlign = Alignment::Start);
+
+		void endGrid();
+
+		/// <summary>
+		/// 独立してスクロールする子領域を開始します
+		/// 領域の外に出たコントロールは更新も描画もされません
+		/// </summary>
+		/// <param name="size">表示領域の大きさ (幅が0以下のときは使える幅いっぱい)</param>
+		void beginChild(const StringView id, SizeF size);
+
+		void endChild();
 
 		bool button(const StringView label);
 
@@ -202,10 +1342,44 @@ namespace SasaGUI
 
 		void label(const StringView text, ColorF color = Palette::Black);
 
+		/// <summary>
+		/// 変化しない文字列を表示するラベル
+		/// 整形結果をキャッシュし、テンプレートのウィンドウ同士で共有します
+		/// </summary>
+		void caption(const StringView text, ColorF color = Palette::Black);
+
+		/// <summary>
+		/// 使える幅で折り返して表示するラベル (日本語の禁則処理に対応)
+		/// 改行位置は文字列か幅が変わったときだけ計算し直します
+		/// </summary>
+		void wrappedLabel(const StringView text, ColorF color = Palette::Black);
+
 		void image(Texture texture, ColorF diffuse = Palette::White);
 
 		void image(TextureRegion texture, ColorF diffuse = Palette::White);
 
+		/// <summary>
+		/// テクスチャに収まらない大きな画像をタイルに分けて表示します
+		/// 表示倍率に合った縮小段の見えているタイルだけを別スレッドで読み込み、読み込むまでは粗い段のタイルを拡大して表示します
+		/// 左ドラッグで選択した範囲を拡大、右ドラッグで移動し、右クリックで全体に戻します
+		/// </summary>
+		/// <param name="source">画像 (読み込むスレッドと共有します)</param>
+		/// <param name="size">大きさ (幅が0以下のときは使える幅いっぱい)</param>
+		/// <returns>カーソルの下にある点の原寸での座標</returns>
+		Optional<Vec2> tiledImage(const StringView id, const std::shared_ptr<const ITiledImageSource>& source, SizeF size);
+
+		/// <summary>
+		/// 画像ファイルのサムネイルを格子状に並べて表示します
+		/// 表示されているセルとその前後の行だけを別スレッドで読み込み、スクロールして外れたセルの読み込みは取り消します
+		/// 縮小した画像は数枚のテクスチャに詰めて、表示していないものから置き換えます
+		/// </summary>
+		/// <param name="paths">画像ファイルのパス</param>
+		/// <param name="cellSize">サムネイルの1辺の大きさ</param>
+		/// <param name="size">大きさ</param>
+		/// <param name="cacheDirectory">縮小した画像を保存するフォルダ (空のときは保存しません)</param>
+		/// <returns>選択されている画像の番号</returns>
+		Optional<size_t> thumbnailGrid(const StringView id, const Array<FilePath>& paths, int32 cellSize, SizeF size, const FilePathView cacheDirectory = U"");
+
 		bool checkbox(bool& checked, const StringView label = U"");
 
 		bool radiobutton(bool selected, const StringView label = U"");
@@ -223,7 +1397,160 @@ namespace SasaGUI
 
 		size_t& tab(const StringView id, Array<String> tabNames);
 
-		// void dropdown();
+		/// <summary>
+		/// 表を開始します
+		/// ヘッダーは常に上端に表示され、見出しのクリックで並べ替えます (完了するまでは前の順番で表示します)
+		/// </summary>
+		/// <param name="rowCount">データの行数</param>
+		/// <param name="size">ヘッダーを含む表示領域の大きさ (幅が0以下のときは使える幅いっぱい)</param>
+		void beginTable(const StringView id, const Array<TableColumn>& columns, size_t rowCount, SizeF size);
+
+		/// <summary>
+		/// 次に表示する行に進みます
+		/// 表示されている行だけを並べ替えた順に返します
+		/// </summary>
+		/// <returns>データ上の行番号 (表示する行がなくなったらnone)</returns>
+		Optional<size_t> tableRow();
+
+		void tableCell(const StringView text, ColorF color = Palette::Black);
+
+		void endTable();
+
+		/// <summary>
+		/// データソースの表示されている行だけを文字列にして表を表示します
+		/// 列はsourceか列の数が変わったときだけ作り直します
+		/// 並べ替え中はsourceを破棄しないでください
+		/// </summary>
+		void table(const StringView id, const ITableSource& source, SizeF size);
+
+		/// <summary>
+		/// ノードグラフのキャンバスを開始します
+		/// 右ドラッグで移動し、ノードはタイトルをドラッグして動かします
+		/// 出力ポートから入力ポートへドラッグしてリンクを追加し、クリックで選択したリンクはDeleteキーで削除します
+		/// </summary>
+		/// <param name="graph">表示するグラフ (endNodeGraph()までは破棄しないでください)</param>
+		/// <param name="size">表示領域の大きさ (幅が0以下のときは使える幅いっぱい)</param>
+		void beginNodeGraph(const StringView id, NodeGraph& graph, SizeF size);
+
+		/// <summary>
+		/// 次に表示するノードに進みます
+		/// 次に呼ぶまでに配置したコントロールがノードの中身になります
+		/// 表示されているノードだけを返すので、表示範囲の外のノードのコントロールは更新も描画もされません
+		/// </summary>
+		/// <returns>ノードのID (表示するノードがなくなったらnone)</returns>
+		Optional<uint64> nodeGraphNode();
+
+		void endNodeGraph();
+
+		/// <summary>
+		/// ログを表示します
+		/// 表示されている行だけを整形し、末尾を表示している間は追加された行を追いかけます
+		/// </summary>
+		/// <param name="filter">空でなければ、この文字列を含む行だけを表示します</param>
+		void logView(const StringView id, LogSink& sink, SizeF size, const StringView filter = U"");
+
+		/// <summary>
+		/// 折れ線グラフを表示します
+		/// 点がピクセルより多いときは1列ごとの最小値と最大値に間引いて描きます
+		/// 左ドラッグで選択した範囲を拡大し、右クリックで全体に戻します
+		/// </summary>
+		/// <param name="size">大きさ (幅が0以下のときは使える幅いっぱい)</param>
+		/// <param name="version">データを書き換えたときに変える値 (変わらない間は間引いた結果を使い回します)</param>
+		void plot(const StringView id, std::span<const float> ys, SizeF size, uint64 version = 0);
+
+		/// <param name="xs">各点のx (昇順)</param>
+		void plot(const StringView id, std::span<const float> xs, std::span<const float> ys, SizeF size, uint64 version = 0);
+
+		/// <summary>
+		/// 散布図を表示します
+		/// 点は別スレッドで格子に振り分けられ、カーソルに最も近い点を探すのに使われます
+		/// 左ドラッグで選択した範囲を拡大、右ドラッグで移動し、右クリックで全体に戻します
+		/// </summary>
+		/// <param name="size">大きさ (幅が0以下のときは使える幅いっぱい)</param>
+		/// <param name="version">データを書き換えたときに変える値 (変わったときだけ点を複製して索引を作り直します)</param>
+		/// <returns>カーソルの近くにある点の番号</returns>
+		Optional<size_t> scatter(const StringView id, std::span<const Float2> points, SizeF size, uint64 version = 0);
+
+		/// <summary>
+		/// 各系列の最新のサンプルを右端に揃えて流れるように表示します
+		/// 描く手間は幅だけで決まり、サンプルの頻度や保持している数にはよりません
+		/// </summary>
+		/// <param name="samples">幅いっぱいに表示するサンプル数</param>
+		/// <param name="size">大きさ (幅が0以下のときは使える幅いっぱい)</param>
+		void stripChart(const StringView id, const Array<StripChannel*>& channels, size_t samples, SizeF size);
+
+		/// <summary>
+		/// 値を色に変換したヒートマップを1枚のテクスチャとして表示します
+		/// </summary>
+		/// <param name="values">行ごとに並べた値 (columns * rows個)</param>
+		/// <param name="size">大きさ (幅が0以下のときは使える幅いっぱい)</param>
+		/// <param name="min">colormapの左端の色になる値</param>
+		/// <param name="max">colormapの右端の色になる値</param>
+		/// <param name="dirtyRows">前回から書き換えた行の範囲 [first, second) (noneのときはすべての行を変換し直します)</param>
+		void heatmap(const StringView id, std::span<const float> values, size_t columns, size_t rows, SizeF size, ColormapType colormap = ColormapType::Turbo, float min = 0.0f, float max = 1.0f, Optional<std::pair<size_t, size_t>> dirtyRows = none);
+
+		/// <summary>
+		/// サンプルの度数分布を表示します
+		/// 数えた結果はversionが変わるまで使い回します (NaNは数えません)
+		/// 大きな配列は写してから別スレッドで数え、終わるまでは前の結果を表示します
+		/// </summary>
+		/// <param name="size">大きさ (幅が0以下のときは使える幅いっぱい)</param>
+		/// <param name="version">サンプルを書き換えたときに変える値</param>
+		/// <param name="bins">区間の数 (noneのときはサンプル数と幅から決めます)</param>
+		/// <param name="logScale">度数を対数で表示するか</param>
+		void histogram(const StringView id, std::span<const float> samples, SizeF size, uint64 version = 0, Optional<size_t> bins = none, bool logScale = false);
+
+		void histogram(const StringView id, std::span<const double> samples, SizeF size, uint64 version = 0, Optional<size_t> bins = none, bool logScale = false);
+
+		void histogram(const StringView id, std::span<const int32> samples, SizeF size, uint64 version = 0, Optional<size_t> bins = none, bool logScale = false);
+
+		/// <summary>
+		/// トラックごとにスパンを並べたタイムラインを表示します
+		/// どの拡大率でも1トラックあたりおおよそ1ピクセルに1つの矩形にまとめて描きます
+		/// 左ドラッグで選択した範囲を拡大、右ドラッグで移動し、右クリックで全体に戻します
+		/// </summary>
+		/// <param name="size">大きさ (幅が0以下のときは使える幅いっぱい)</param>
+		/// <returns>カーソルの下にあるスパンのトラックとspans()での番号</returns>
+		Optional<std::pair<size_t, size_t>> timeline(const StringView id, const TimelineData& data, SizeF size);
+
+		/// <summary>
+		/// 展開されたノードだけを列挙するツリーを表示します
+		/// 展開状態はノードのIDごとに保持され、表示されている行だけを配置します
+		/// </summary>
+		/// <param name="size">大きさ (幅が0以下のときは使える幅いっぱい)</param>
+		/// <param name="version">ノードの構成が変わったときに変える値 (変わると展開状態を保ったまま列挙し直します)</param>
+		/// <returns>選択されているノード</returns>
+		Optional<uint64> tree(const StringView id, const ITreeProvider& provider, SizeF size, uint64 version = 0);
+
+		/// <summary>
+		/// 開閉できるセクションの見出しを表示します
+		/// 開いているときは中身の後にendCollapsingHeader()を呼んでセクションを終えてください (入れ子にできます)
+		/// </summary>
+		/// <returns>開いているときはtrue (閉じているときは中身を評価しないでください)</returns>
+		bool collapsingHeader(const StringView id, const StringView label);
+
+		/// <summary>
+		/// collapsingHeader()がtrueを返したときのセクションを終えます
+		/// </summary>
+		void endCollapsingHeader();
+
+		/// <summary>
+		/// 項目を選ぶドロップダウンを表示します
+		/// 開くと手前に一覧が表示され、入力した文字を順に含む項目に別スレッドで絞り込みます
+		/// </summary>
+		/// <param name="items">項目 (絞り込むスレッドと共有します)</param>
+		/// <param name="selected">選択されている項目の番号</param>
+		/// <returns>選択が変わったときtrue</returns>
+		bool dropdown(const StringView id, const std::shared_ptr<const Array<String>>& items, Optional<size_t>& selected, double width = 200);
+
+		/// <summary>
+		/// 複数行のテキストエディタを表示します
+		/// 表示されている行だけを整形し、文書の大きさによらず1フレームの手間はほぼ一定です
+		/// Ctrl+Z/Yで取り消し・やり直し、Ctrl+X/C/Vで切り取り・コピー・貼り付けができます
+		/// </summary>
+		/// <param name="size">大きさ (幅が0以下のときは使える幅いっぱい)</param>
+		/// <returns>このフレームで編集されたときtrue</returns>
+		bool textEditor(const StringView id, TextDocument& document, SizeF size);
 
 		bool simpleColorpicker(HSV& value);
 
@@ -252,6 +1579,10 @@ namespace SasaGUI
 
 		detail::WindowImpl& getCurrentWindowImpl() { return *m_stack.back(); }
 
+		bool beginMeasure();
+
+		void endMeasure();
+
 		void setWindowPos(Vec2 pos, Vec2 offset);
 
 	public: